@@ -43,6 +43,7 @@
 #include "General/ColourConfiguration.h"
 #include "General/Console.h"
 #include "General/Executables.h"
+#include "General/Jobs.h"
 #include "General/KeyBind.h"
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
@@ -82,6 +83,7 @@ wxStopWatch     timer;
 int             temp_fail_count = 0;
 bool            init_ok         = false;
 bool            exiting         = false;
+bool            headless        = false;
 std::thread::id main_thread_id;
 
 // Version
@@ -112,6 +114,14 @@ CVAR(String, temp_location_custom, "", CVar::Flag::Save)
 CVAR(Bool, setup_wizard_run, false, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// External Variables
+//
+// -----------------------------------------------------------------------------
+EXTERN_CVAR(Int, base_resource)
+
+
 // ----------------------------------------------------------------------------
 //
 // app::Version Struct Functions
@@ -222,6 +232,18 @@ bool initDirectories()
 		}
 	}
 
+	// Headless (command line) instances use their own temp dir within it, so
+	// they don't clash with (or clean up) temp files of any other instance
+	if (headless)
+	{
+		dir_temp += fmt::format("{}headless-{}", dir_separator, wxGetProcessId());
+		if (!wxDirExists(dir_temp) && !wxMkdir(dir_temp))
+		{
+			log::error("Unable to create temp directory \"{}\"", dir_temp);
+			return false;
+		}
+	}
+
 	// Check data dir
 	if (!wxDirExists(dir_data))
 		dir_data = dir_app; // Use app dir if data dir doesn't exist
@@ -430,6 +452,15 @@ bool app::isExiting()
 	return exiting;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if the application was initialised without a UI
+// (see initHeadless)
+// -----------------------------------------------------------------------------
+bool app::isHeadless()
+{
+	return headless;
+}
+
 // -----------------------------------------------------------------------------
 // Application initialisation
 // -----------------------------------------------------------------------------
@@ -462,6 +493,9 @@ bool app::init(const vector<string>& args, double ui_scale)
 	log::info("Loading configuration");
 	readConfigFile();
 
+	// Start background job workers
+	jobs::init();
+
 	// Init entry types
 	EntryDataFormat::initBuiltinFormats();
 	EntryType::initTypes();
@@ -492,93 +526,257 @@ bool app::init(const vector<string>& args, double ui_scale)
 	ui::init(ui_scale);
 
 	// Show splash screen
-	ui::showSplash("Starting up...");
+	ui::showSplash("Starting up...", true);
+
+	// Init SImage formats
+	SIFormat::initFormats();
+
+	// Load everything else, as a graph of tasks so that resources and
+	// configurations can be loaded concurrently on worker threads. Anything
+	// touching the UI (or depending on it) runs on the main thread
+	jobs::TaskGraph startup;
+	auto            always = [](auto fn) // For tasks that can't fail
+	{
+		return [fn]
+		{
+			fn();
+			return true;
+		};
+	};
+
+	// Resources and configurations
+	auto t_palettes     = startup.add("Palettes", [] { return palette_manager.init(); });
+	auto t_etypes       = startup.add("Entry types", always(EntryType::loadEntryTypes));
+	auto t_languages    = startup.add("Text languages", always(TextLanguage::loadLanguages));
+	auto t_styles       = startup.add("Text styles", always(StyleSet::loadResourceStyles), { t_languages });
+	auto t_styles_user  = startup.add("Custom text styles", always(StyleSet::loadCustomStyles), { t_styles });
+	auto t_colours      = startup.add("Colour configuration", always(colourconfig::init));
+	auto t_nodebuilders = startup.add("Node builders", always(nodebuilders::init));
+	auto t_executables  = startup.add("Game executables", always(executables::init));
+	auto t_game_defs    = startup.add("Game definitions", always(game::loadDefinitions));
+
+	// UI
+	auto t_brushes = startup.addMain("Brushes", always(SBrush::initBrushes));
+	auto t_icons   = startup.addMain("Icons", always(icons::loadIcons));
+	auto t_fonts   = startup.addMain("Fonts", always(drawing::initFonts));
+	auto t_editor  = startup.addMain(
+		"Main editor",
+		maineditor::init,
+		{ t_palettes, t_etypes, t_styles_user, t_colours, t_nodebuilders, t_executables, t_brushes, t_icons, t_fonts });
+
+	// Base resource (opened on a worker thread, then set on the main thread)
+	unique_ptr<Archive> base_res;
+
+	auto t_base_res_open = startup.add(
+		"Base resource",
+		[&base_res]
+		{
+			base_res = archive_manager.loadBaseResource(base_resource);
+			return true;
+		},
+		{ t_etypes });
+	auto t_base_res = startup.addMain(
+		"Base resource",
+		[&base_res]
+		{
+			archive_manager.setBaseResource(base_resource, std::move(base_res));
+			return true;
+		},
+		{ t_base_res_open, t_editor });
+
+	// Game configuration
+	auto t_game = startup.addMain("Game configuration", always(game::init), { t_game_defs, t_base_res });
+#ifndef NO_LUA
+	t_game = startup.addMain("Script manager", always(scriptmanager::init), { t_game });
+#endif
 
-	// Init palettes
-	if (!palette_manager.init())
+	// Main window
+	auto t_window = startup.addMain(
+		"Main window",
+		[]
+		{
+			maineditor::windowWx()->Show(true);
+			wxGetApp().SetTopWindow(maineditor::windowWx());
+			ui::showSplash("Starting up...", true, maineditor::windowWx());
+			return true;
+		},
+		{ t_game });
+
+	// Archives from the command line, opened concurrently then added to the
+	// archive manager once the main window is shown
+	vector<shared_ptr<Archive>>     archives(paths_to_open.size());
+	vector<jobs::TaskGraph::TaskId> t_archives{ t_window };
+	for (unsigned a = 0; a < paths_to_open.size(); ++a)
+		t_archives.push_back(startup.add(
+			strutil::Path::fileNameOf(paths_to_open[a]),
+			[&archives, &paths_to_open, a]
+			{
+				archives[a] = archive_manager.openArchive(paths_to_open[a], false, true);
+				return true;
+			},
+			{ t_etypes }));
+	startup.addMain(
+		"Open archives",
+		[&archives]
+		{
+			for (auto& archive : archives)
+				if (archive)
+					archive_manager.manageArchive(archive);
+			return true;
+		},
+		t_archives);
+
+	// Run startup, showing progress in the splash window
+	log::info("Loading resources and configurations");
+	auto ok = startup.run(
+		[](unsigned done, unsigned total, const vector<string>& running)
+		{
+			string message;
+			for (const auto& name : running)
+				message += message.empty() ? name : ", " + name;
+
+			ui::setSplashProgressMessage(message);
+			ui::setSplashProgress(static_cast<float>(done) / static_cast<float>(total));
+		});
+	if (!ok)
 	{
-		log::error("Failed to initialise palettes");
+		log::error("Startup failed, see the log for details");
 		return false;
 	}
 
-	// Init SImage formats
-	SIFormat::initFormats();
+	// Hide splash screen
+	ui::hideSplash();
 
-	// Init brushes
-	SBrush::initBrushes();
+	init_ok = true;
+	log::info("SLADE Initialisation OK ({}ms)", runTimer());
 
-	// Load program icons
-	log::info("Loading icons");
-	icons::loadIcons();
+	// Show Setup Wizard if needed
+	if (!setup_wizard_run)
+	{
+		SetupWizardDialog dlg(maineditor::windowWx());
+		dlg.ShowModal();
+		setup_wizard_run = true;
+		maineditor::windowWx()->Update();
+		maineditor::windowWx()->Refresh();
+	}
 
-	// Load program fonts
-	drawing::initFonts();
+	return true;
+}
 
-	// Load entry types
-	log::info("Loading entry types");
-	EntryType::loadEntryTypes();
+// -----------------------------------------------------------------------------
+// Application initialisation without any UI (for command line tools).
+// Only the core is initialised: directories, log, configuration, entry types,
+// resources, palettes, image formats, lua and game configurations.
+// Background jobs are run on [n_threads] worker threads (0 = default).
+// The log is appended to [log_filename] rather than slade3.log, since the tool
+// may be run alongside SLADE or other instances of itself
+// -----------------------------------------------------------------------------
+bool app::initHeadless(unsigned n_threads, string_view log_filename)
+{
+	headless       = true;
+	main_thread_id = std::this_thread::get_id();
 
-	// Load text languages
-	log::info("Loading text languages");
-	TextLanguage::loadLanguages();
+	// Set numeric locale to C so that the tokenizer will work properly
+	// even in locales where the decimal separator is a comma.
+	wxSetlocale(LC_NUMERIC, "C");
 
-	// Init text stylesets
-	log::info("Loading text style sets");
-	StyleSet::loadResourceStyles();
-	StyleSet::loadCustomStyles();
+	// Init application directories
+	if (!initDirectories())
+		return false;
 
-	// Init colour configuration
-	log::info("Loading colour configuration");
-	colourconfig::init();
+	// Init log
+	log::init(log_filename, true);
 
-	// Init nodebuilders
-	nodebuilders::init();
+	// Init FreeImage
+	FreeImage_Initialise();
 
-	// Init game executables
-	executables::init();
+	// There is nothing to show a splash window in
+	ui::enableSplash(false);
 
-	// Init main editor
-	maineditor::init();
+	// Load configuration file (keybinds are needed to read it)
+	KeyBind::initBinds();
+	readConfigFile();
 
-	// Init base resource
-	log::info("Loading base resource");
-	archive_manager.initBaseResource();
-	log::info("Base resource loaded");
+	// Start background job workers
+	jobs::init(n_threads);
 
-	// Init game configuration
-	log::info("Loading game configurations");
-	game::init();
+	// Init entry types
+	EntryDataFormat::initBuiltinFormats();
+	EntryType::initTypes();
+
+	// Check that SLADE.pk3 can be found
+	archive_manager.init();
+	if (!archive_manager.resArchiveOK())
+	{
+		log::error("Unable to find slade.pk3, make sure it exists in the same directory as the SLADE executable");
+		return false;
+	}
 
 #ifndef NO_LUA
-	// Init script manager
-	scriptmanager::init();
+	// Init lua
+	lua::init();
 #endif
 
-	// Show the main window
-	maineditor::windowWx()->Show(true);
-	wxGetApp().SetTopWindow(maineditor::windowWx());
-	ui::showSplash("Starting up...", false, maineditor::windowWx());
-
-	// Open any archives from the command line
-	for (auto& path : paths_to_open)
-		archive_manager.openArchive(path);
+	// Init SImage formats
+	SIFormat::initFormats();
 
-	// Hide splash screen
-	ui::hideSplash();
+	// Load resources and configurations concurrently where possible (see init)
+	jobs::TaskGraph     startup;
+	unique_ptr<Archive> base_res;
 
-	init_ok = true;
-	log::info("SLADE Initialisation OK");
+	auto t_palettes  = startup.add("Palettes", [] { return palette_manager.init(); });
+	auto t_game_defs = startup.add(
+		"Game definitions",
+		[]
+		{
+			game::loadDefinitions();
+			return true;
+		});
+	auto t_etypes = startup.add(
+		"Entry types",
+		[]
+		{
+			EntryType::loadEntryTypes();
+			return true;
+		});
+	auto t_base_res_open = startup.add(
+		"Base resource",
+		[&base_res]
+		{
+			base_res = archive_manager.loadBaseResource(base_resource);
+			return true;
+		},
+		{ t_etypes });
+	auto t_base_res = startup.addMain(
+		"Base resource",
+		[&base_res]
+		{
+			archive_manager.setBaseResource(base_resource, std::move(base_res));
+			return true;
+		},
+		{ t_base_res_open });
+	startup.addMain(
+		"Game configuration",
+		[]
+		{
+			game::init();
+			return true;
+		},
+		{ t_palettes, t_game_defs, t_base_res });
 
-	// Show Setup Wizard if needed
-	if (!setup_wizard_run)
+	if (!startup.run())
 	{
-		SetupWizardDialog dlg(maineditor::windowWx());
-		dlg.ShowModal();
-		setup_wizard_run = true;
-		maineditor::windowWx()->Update();
-		maineditor::windowWx()->Refresh();
+		log::error("Startup failed, see the log for details");
+		return false;
 	}
 
+	// Wait for any jobs started during startup (eg. loading zdoom.pk3) and
+	// apply their results, since there is no event loop to do it later
+	jobs::waitIdle();
+
+	init_ok = true;
+	log::info("SLADE Initialisation OK (headless, {}ms)", runTimer());
+
 	return true;
 }
 
@@ -682,22 +880,36 @@ void app::exit(bool save_config)
 #endif
 	}
 
+	// Stop background jobs (they may be using open archives)
+	jobs::shutdown();
+
 	// Close all open archives
 	archive_manager.closeAll();
 
 	// Clean up
-	drawing::cleanupFonts();
-	gl::Texture::clearAll();
+	if (!headless)
+	{
+		drawing::cleanupFonts();
+		gl::Texture::clearAll();
+	}
 
-	// Clear temp folder
+	// Clear temp folder (headless instances have their own, so remove it)
 	std::error_code error;
-	for (auto& item : std::filesystem::directory_iterator{ app::path("", app::Dir::Temp) })
+	if (headless)
 	{
-		if (!item.is_regular_file())
-			continue;
+		if (std::filesystem::remove_all(dir_temp, error) == static_cast<std::uintmax_t>(-1))
+			log::warning("Could not clean up temporary directory \"{}\": {}", dir_temp, error.message());
+	}
+	else
+	{
+		for (auto& item : std::filesystem::directory_iterator{ app::path("", app::Dir::Temp) })
+		{
+			if (!item.is_regular_file())
+				continue;
 
-		if (!std::filesystem::remove(item, error))
-			log::warning("Could not clean up temporary file \"{}\": {}", item.path().string(), error.message());
+			if (!std::filesystem::remove(item, error))
+				log::warning("Could not clean up temporary file \"{}\": {}", item.path().string(), error.message());
+		}
 	}
 
 #ifndef NO_LUA
@@ -708,8 +920,12 @@ void app::exit(bool save_config)
 	// Close DUMB
 	dumb_exit();
 
+	// Stop the log writer thread (anything logged afterwards is written directly)
+	log::close();
+
 	// Exit wx Application
-	wxGetApp().Exit();
+	if (!headless)
+		wxGetApp().Exit();
 }
 
 
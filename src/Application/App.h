@@ -22,6 +22,8 @@ namespace app
 	ResourceManager& resources();
 
 	bool init(const vector<string>& args, double ui_scale = 1.);
+	bool initHeadless(unsigned n_threads = 0, string_view log_filename = "slade-cli.log");
+	bool isHeadless();
 	void saveConfigFile();
 	void exit(bool save_config);
 
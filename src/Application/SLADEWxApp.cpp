@@ -64,7 +64,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 namespace slade::global
 {
-string error;
+thread_local string error;
 
 #ifdef GIT_DESCRIPTION
 string sc_rev = GIT_DESCRIPTION;
@@ -272,11 +272,15 @@ public:
 		trace_ += "\n";
 		trace_ += st.traceString();
 
-		// Last 10 log lines
+		// Last 10 log lines (write out anything still queued first)
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = log::history();
-		for (auto a = log.size() - 10; a < log.size(); a++)
-			trace_ += log[a].message + "\n";
+		if (log::drain())
+		{
+			for (const auto& msg : log::lastMessages(10))
+				trace_ += msg.message + "\n";
+		}
+		else
+			trace_ += "(Log unavailable)\n";
 
 		// Set stack trace text
 		text_stack_->SetValue(trace_);
@@ -374,7 +378,9 @@ public:
 // SLADEWxApp Class Functions
 //
 // -----------------------------------------------------------------------------
-IMPLEMENT_APP(SLADEWxApp)
+// The program entry point (main/WinMain) is in GUIMain.cpp, so that the rest of
+// SLADE can also be linked into other executables (eg. slade-cli)
+wxIMPLEMENT_APP_NO_MAIN(SLADEWxApp);
 
 
 // -----------------------------------------------------------------------------
@@ -36,11 +36,13 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Archive.h"
+#include "General/Profiler.h"
 #include "General/UndoRedo.h"
 #include "Utility/FileUtils.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
 #include <filesystem>
+#include <numeric>
 
 using namespace slade;
 
@@ -285,6 +287,35 @@ private:
 };
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the (ascending) indices of entries in [dir] that need to be checked
+// for a search with [options]. If a name is being searched for, only entries
+// with a matching name are returned (via the dir's name index)
+// -----------------------------------------------------------------------------
+vector<unsigned> searchCandidates(const ArchiveDir& dir, const Archive::SearchOptions& options)
+{
+	vector<unsigned> indices;
+
+	if (!options.match_name.empty())
+		dir.entryIndicesMatching(options.match_name, options.ignore_ext, indices);
+	else
+	{
+		indices.resize(dir.numEntries());
+		std::iota(indices.begin(), indices.end(), 0);
+	}
+
+	return indices;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Archive::MapDesc Class Functions
@@ -468,6 +499,19 @@ bool Archive::open(string_view filename)
 		return false;
 	}
 
+	return open(filename, mc);
+}
+
+// -----------------------------------------------------------------------------
+// Reads an archive from [data], the contents of file [filename]. This is used
+// when the file has already been read (eg. to detect its format) so it
+// doesn't need to be read again
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool Archive::open(string_view filename, MemChunk& data)
+{
+	PROFILE_SCOPE("Archive::open");
+
 	// Update filename before opening
 	const auto backupname = filename_;
 	filename_             = filename;
@@ -475,7 +519,7 @@ bool Archive::open(string_view filename)
 
 	// Load from MemChunk
 	const sf::Clock timer;
-	if (open(mc))
+	if (open(data))
 	{
 		log::info(2, "Archive::open took {}ms", timer.getElapsedTime().asMilliseconds());
 		on_disk_ = true;
@@ -630,6 +674,8 @@ shared_ptr<ArchiveEntry> Archive::entryAtPathShared(string_view path) const
 // -----------------------------------------------------------------------------
 bool Archive::write(string_view filename, bool update)
 {
+	PROFILE_SCOPE("Archive::write");
+
 	// Write to a MemChunk, then export it to a file
 	MemChunk mc;
 	if (write(mc, true))
@@ -648,6 +694,8 @@ bool Archive::write(string_view filename, bool update)
 // -----------------------------------------------------------------------------
 bool Archive::save(string_view filename)
 {
+	PROFILE_SCOPE("Archive::save");
+
 	bool success = false;
 
 	// Check if the archive is read-only
@@ -1392,10 +1440,10 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 
 	// Begin search
 
-	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
+	// Search entries (only those with matching names if searching by name)
+	for (auto index : searchCandidates(*dir, options))
 	{
-		const auto entry = dir->entryAt(a);
+		const auto entry = dir->entryAt(index);
 
 		// Check type
 		if (options.match_type)
@@ -1409,15 +1457,6 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			const auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!strutil::matches(check_name, options.match_name))
-				continue;
-		}
-
 		// Check namespace
 		if (!options.match_namespace.empty())
 		{
@@ -1462,10 +1501,11 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 
 	// Begin search
 
-	// Search entries (bottom-up)
-	for (int a = static_cast<int>(dir->numEntries()) - 1; a >= 0; a--)
+	// Search entries (bottom-up, only those with matching names if searching by name)
+	auto candidates = searchCandidates(*dir, options);
+	for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
 	{
-		const auto entry = dir->entryAt(a);
+		const auto entry = dir->entryAt(*it);
 
 		// Check type
 		if (options.match_type)
@@ -1479,15 +1519,6 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			const auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!strutil::matches(check_name, options.match_name))
-				continue;
-		}
-
 		// Check namespace
 		if (!options.match_namespace.empty())
 		{
@@ -1532,10 +1563,10 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 
 	// Begin search
 
-	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
+	// Search entries (only those with matching names if searching by name)
+	for (auto index : searchCandidates(*dir, options))
 	{
-		auto entry = dir->entryAt(a);
+		auto entry = dir->entryAt(index);
 
 		// Check type
 		if (options.match_type)
@@ -1549,15 +1580,6 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			const auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!strutil::matches(check_name, options.match_name))
-				continue;
-		}
-
 		// Check namespace
 		if (!options.match_namespace.empty())
 		{
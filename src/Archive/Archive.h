@@ -78,9 +78,10 @@ public:
 	virtual bool  isTreeless() { return false; }
 
 	// Opening
-	virtual bool open(string_view filename); // Open from File
-	virtual bool open(ArchiveEntry* entry);  // Open from ArchiveEntry
-	virtual bool open(MemChunk& mc) = 0;     // Open from MemChunk
+	virtual bool open(string_view filename);                 // Open from File
+	virtual bool open(string_view filename, MemChunk& data); // Open from File already read into [data]
+	virtual bool open(ArchiveEntry* entry);                  // Open from ArchiveEntry
+	virtual bool open(MemChunk& mc) = 0;                     // Open from MemChunk
 
 	// Writing/Saving
 	virtual bool write(MemChunk& mc, bool update = true) = 0;     // Write to MemChunk
@@ -40,6 +40,7 @@
 #include "Archive.h"
 #include "Utility/StringUtils.h"
 #include <filesystem>
+#include <numeric>
 
 using namespace slade;
 
@@ -228,16 +229,9 @@ ArchiveEntry* ArchiveDir::entry(string_view name, bool cut_ext) const
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (strutil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry.get();
-	}
-
-	// Not found
-	return nullptr;
+	// Look up (non-case-sensitive) name in the name index
+	auto index = firstEntryIndex(name, cut_ext);
+	return index >= 0 ? entries_[index].get() : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -250,16 +244,9 @@ shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(string_view name, bool cut_ext)
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (strutil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry;
-	}
-
-	// Not found
-	return nullptr;
+	// Look up (non-case-sensitive) name in the name index
+	auto index = firstEntryIndex(name, cut_ext);
+	return index >= 0 ? entries_[index] : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -312,9 +299,23 @@ bool ArchiveDir::addEntry(shared_ptr<ArchiveEntry> entry, bool ignore_requiremen
 
 	// Check index
 	if (index >= entries_.size())
+	{
 		entries_.push_back(entry); // 'Invalid' index, add to end of list
+
+		// No existing indices change, so the name index can just be extended
+		std::lock_guard lock(name_index_mutex_);
+		if (name_index_.valid)
+		{
+			name_index_.names[entry->upperName()].push_back(entries_.size() - 1);
+			name_index_.names_no_ext[string{ entry->upperNameNoExt() }].push_back(entries_.size() - 1);
+			name_index_.sorted_valid = false;
+		}
+	}
 	else
+	{
 		entries_.insert(entries_.begin() + index, entry); // Add it at index
+		invalidateNameIndex();
+	}
 
 	// Check entry name if duplicate names aren't allowed
 	if (!ignore_requirements && !allow_duplicate_names_)
@@ -338,6 +339,7 @@ bool ArchiveDir::removeEntry(unsigned index)
 
 	// Remove it from the entry list
 	entries_.erase(entries_.begin() + index);
+	invalidateNameIndex();
 
 	return true;
 }
@@ -354,6 +356,7 @@ bool ArchiveDir::swapEntries(unsigned index1, unsigned index2)
 
 	// Swap entries
 	entries_[index1].swap(entries_[index2]);
+	invalidateNameIndex();
 
 	return true;
 }
@@ -458,6 +461,7 @@ void ArchiveDir::clear()
 {
 	entries_.clear();
 	subdirs_.clear();
+	invalidateNameIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -521,34 +525,159 @@ bool ArchiveDir::exportTo(string_view path) const
 // -----------------------------------------------------------------------------
 void ArchiveDir::ensureUniqueName(ArchiveEntry* entry) const
 {
-	unsigned      index     = 0;
-	unsigned      number    = 0;
-	const auto    n_entries = entries_.size();
+	unsigned      number = 0;
 	strutil::Path fn(entry->name());
 	auto          name = fn.fileName();
-	while (index < n_entries)
+	while (true)
 	{
-		if (entries_[index].get() == entry)
+		// Check if any other entry has the name
+		bool taken = false;
 		{
-			index++;
-			continue;
+			std::lock_guard lock(name_index_mutex_);
+			updateNameIndex();
+			auto i = name_index_.names.find(strutil::upper(name));
+			if (i != name_index_.names.end())
+				for (auto index : i->second)
+					if (entries_[index].get() != entry)
+					{
+						taken = true;
+						break;
+					}
 		}
 
-		if (strutil::equalCI(entries_[index]->name(), name))
-		{
-			fn.setFileName(fmt::format("{} ({})", entry->nameNoExt(), ++number));
-			name  = fn.fileName();
-			index = 0;
-			continue;
-		}
+		if (!taken)
+			break;
 
-		index++;
+		fn.setFileName(fmt::format("{} ({})", entry->nameNoExt(), ++number));
+		name = fn.fileName();
 	}
 
 	if (number > 0)
 		entry->setName(name);
 }
 
+// -----------------------------------------------------------------------------
+// Returns the index of the first entry named [name] (case-insensitive) in this
+// directory, or -1 if no entries match.
+// If [cut_ext] is true, entry names are compared without their extensions
+// -----------------------------------------------------------------------------
+int ArchiveDir::firstEntryIndex(string_view name, bool cut_ext) const
+{
+	auto upper = strutil::upper(name);
+
+	std::lock_guard lock(name_index_mutex_);
+	updateNameIndex();
+
+	auto& names = cut_ext ? name_index_.names_no_ext : name_index_.names;
+	auto  i     = names.find(upper);
+	return i != names.end() && !i->second.empty() ? static_cast<int>(i->second[0]) : -1;
+}
+
+// -----------------------------------------------------------------------------
+// Adds the indices of all entries with names matching [match] to [indices], in
+// ascending order. [match] must be upper case and can contain wildcards
+// (* and ?). If [cut_ext] is true, entry names are compared without their
+// extensions.
+// Names without wildcards are looked up directly in the name index, otherwise
+// only entries with names starting with the part of [match] before the first
+// wildcard are checked
+// -----------------------------------------------------------------------------
+void ArchiveDir::entryIndicesMatching(string_view match, bool cut_ext, vector<unsigned>& indices) const
+{
+	std::lock_guard lock(name_index_mutex_);
+	updateNameIndex();
+
+	// No wildcards, exact match
+	auto wildcard = match.find_first_of("*?");
+	if (wildcard == string_view::npos)
+	{
+		auto& names = cut_ext ? name_index_.names_no_ext : name_index_.names;
+		auto  i     = names.find(string{ match });
+		if (i != names.end())
+			indices.insert(indices.end(), i->second.begin(), i->second.end());
+		return;
+	}
+
+	// Find the range of sorted names starting with the non-wildcard prefix
+	sortNameIndex();
+	auto  prefix  = match.substr(0, wildcard);
+	auto& sorted  = cut_ext ? name_index_.sorted_no_ext : name_index_.sorted;
+	auto  name_at = [this, cut_ext](unsigned index)
+	{ return cut_ext ? entries_[index]->upperNameNoExt() : string_view{ entries_[index]->upperName() }; };
+	auto it = std::lower_bound(
+		sorted.begin(), sorted.end(), prefix, [&](unsigned index, string_view p) { return name_at(index) < p; });
+
+	// Check each name in the range against the full pattern
+	auto first_new = indices.size();
+	for (; it != sorted.end() && strutil::startsWith(name_at(*it), prefix); ++it)
+		if (strutil::matches(name_at(*it), match))
+			indices.push_back(*it);
+
+	std::sort(indices.begin() + first_new, indices.end());
+}
+
+// -----------------------------------------------------------------------------
+// Marks the name index as out of date, so that it will be rebuilt on the next
+// name lookup. Must be called whenever an entry is renamed or entries are
+// removed/moved within this directory
+// -----------------------------------------------------------------------------
+void ArchiveDir::invalidateNameIndex() const
+{
+	std::lock_guard lock(name_index_mutex_);
+	name_index_.valid        = false;
+	name_index_.sorted_valid = false;
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the name -> entry indices maps if the name index is out of date.
+// The name index mutex must be locked when calling this
+// -----------------------------------------------------------------------------
+void ArchiveDir::updateNameIndex() const
+{
+	if (name_index_.valid)
+		return;
+
+	name_index_.names.clear();
+	name_index_.names_no_ext.clear();
+	name_index_.names.reserve(entries_.size());
+	name_index_.names_no_ext.reserve(entries_.size());
+	for (unsigned a = 0; a < entries_.size(); ++a)
+	{
+		name_index_.names[entries_[a]->upperName()].push_back(a);
+		name_index_.names_no_ext[string{ entries_[a]->upperNameNoExt() }].push_back(a);
+	}
+
+	name_index_.valid        = true;
+	name_index_.sorted_valid = false;
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the name-sorted entry index lists if they are out of date.
+// The name index mutex must be locked when calling this
+// -----------------------------------------------------------------------------
+void ArchiveDir::sortNameIndex() const
+{
+	if (name_index_.sorted_valid)
+		return;
+
+	auto& sorted        = name_index_.sorted;
+	auto& sorted_no_ext = name_index_.sorted_no_ext;
+	sorted.resize(entries_.size());
+	std::iota(sorted.begin(), sorted.end(), 0);
+	sorted_no_ext = sorted;
+
+	std::sort(
+		sorted.begin(),
+		sorted.end(),
+		[this](unsigned a, unsigned b) { return entries_[a]->upperName() < entries_[b]->upperName(); });
+	std::sort(
+		sorted_no_ext.begin(),
+		sorted_no_ext.end(),
+		[this](unsigned a, unsigned b) { return entries_[a]->upperNameNoExt() < entries_[b]->upperNameNoExt(); });
+
+	name_index_.sorted_valid = true;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the first entry in the directory that has the same name as another,
 // or nullptr if all names are unique
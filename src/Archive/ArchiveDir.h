@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ArchiveEntry.h"
+#include <mutex>
 
 namespace slade
 {
@@ -37,6 +38,10 @@ public:
 	vector<shared_ptr<ArchiveEntry>> allEntries() const;
 	vector<shared_ptr<ArchiveDir>>   allDirectories() const;
 
+	// Name index
+	void entryIndicesMatching(string_view match, bool cut_ext, vector<unsigned>& indices) const;
+	void invalidateNameIndex() const;
+
 	// Entry Operations
 	bool addEntry(shared_ptr<ArchiveEntry> entry, bool ignore_requirements, unsigned index = 0xFFFFFFFF);
 	bool addEntry(shared_ptr<ArchiveEntry> entry, unsigned index = 0xFFFFFFFF) { return addEntry(entry, false, index); }
@@ -88,6 +93,22 @@ private:
 	vector<shared_ptr<ArchiveDir>>   subdirs_;
 	bool                             allow_duplicate_names_ = true;
 
+	// Index of upper-case entry names, built on demand
+	struct NameIndex
+	{
+		std::unordered_map<string, vector<unsigned>> names;         // Name -> entry indices
+		std::unordered_map<string, vector<unsigned>> names_no_ext;  // Name without extension -> entry indices
+		vector<unsigned>                             sorted;        // Entry indices sorted by name
+		vector<unsigned>                             sorted_no_ext; // Entry indices sorted by name without extension
+		bool                                         valid        = false;
+		bool                                         sorted_valid = false;
+	};
+	mutable NameIndex  name_index_;
+	mutable std::mutex name_index_mutex_;
+
 	void ensureUniqueName(ArchiveEntry* entry) const;
+	int  firstEntryIndex(string_view name, bool cut_ext) const;
+	void updateNameIndex() const;
+	void sortNameIndex() const;
 };
 } // namespace slade
@@ -236,6 +236,10 @@ void ArchiveEntry::setName(string_view name)
 {
 	name_       = name;
 	upper_name_ = strutil::upper(name);
+
+	// Parent dir's name index is now out of date
+	if (parent_)
+		parent_->invalidateNameIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -244,6 +248,11 @@ void ArchiveEntry::setName(string_view name)
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setState(State state, bool silent)
 {
+	// Anything modifying the entry sets it as modified, so treat it as a
+	// possible data change regardless of whether the state is locked
+	if (state == State::Modified)
+		++data_version_;
+
 	if (state_locked_ || (state == State::Unmodified && state_ == State::Unmodified))
 		return;
 
@@ -307,17 +316,12 @@ void ArchiveEntry::unlock()
 // -----------------------------------------------------------------------------
 void ArchiveEntry::formatName(const ArchiveFormat& format)
 {
-	bool changed = false;
-
 	// Perform character substitution if needed
 	name_ = misc::fileNameToLumpName(name_);
 
 	// Max length
 	if (format.max_name_length > 0 && static_cast<int>(name_.size()) > format.max_name_length)
-	{
 		strutil::truncateIP(name_, format.max_name_length);
-		changed = true;
-	}
 
 	// Uppercase
 	if (format.prefer_uppercase && wad_force_uppercase)
@@ -325,19 +329,17 @@ void ArchiveEntry::formatName(const ArchiveFormat& format)
 
 	// Remove \ or / if the format supports folders
 	if (format.supports_dirs && (name_.find('/') != string::npos || name_.find('\\') != string::npos))
-	{
-		name_   = misc::lumpNameToFileName(name_);
-		changed = true;
-	}
+		name_ = misc::lumpNameToFileName(name_);
 
 	// Remove extension if the format doesn't have them
 	if (!format.names_extensions)
 		if (const auto pos = name_.find('.'); pos != string::npos)
 			strutil::truncateIP(name_, pos);
 
-	// Update upper name
-	if (changed)
-		upper_name_ = strutil::upper(name_);
+	// Update upper name and parent dir's name index
+	upper_name_ = strutil::upper(name_);
+	if (parent_)
+		parent_->invalidateNameIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -403,6 +405,7 @@ void ArchiveEntry::clearData()
 	// Reset attributes
 	size_        = 0;
 	data_loaded_ = false;
+	++data_version_;
 }
 
 // -----------------------------------------------------------------------------
@@ -54,6 +54,7 @@ public:
 	Property&                exProp(const string& key) { return ex_props_[key]; }
 	template<typename T> T   exProp(const string& key);
 	State                    state() const { return state_; }
+	unsigned                 dataVersion() const { return data_version_; }
 	bool                     isLocked() const { return locked_; }
 	bool                     isLoaded() const { return data_loaded_; }
 	Encryption               encryption() const { return encrypted_; }
@@ -128,6 +129,7 @@ private:
 	bool       locked_       = false;            // If true the entry data+info cannot be changed
 	bool       data_loaded_  = true;             // True if the entry's data is currently loaded into the data MemChunk
 	Encryption encrypted_    = Encryption::None; // Is there some encrypting on the archive?
+	unsigned   data_version_ = 0;                // Incremented whenever the entry data may have changed
 
 	// Misc stuff
 	int    reliability_ = 0; // The reliability of the entry's identification
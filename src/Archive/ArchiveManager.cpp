@@ -59,6 +59,104 @@ CVAR(Int, max_recent_files, 25, CVar::Flag::Save)
 CVAR(Bool, auto_open_wads_root, false, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Files up to this size are read whole to detect their format, and then
+// opened from the data read. Only the header of larger files is read at first
+// (enough to detect a zip), so that zips and unsupported files aren't read
+// into memory
+const unsigned probe_read_max    = 16 * 1024 * 1024;
+const unsigned probe_header_size = 1024;
+
+// Archive format detection, in order of priority
+struct ArchiveFormatProbe
+{
+	bool (*detect)(MemChunk&);
+	bool (*detect_file)(const string&);
+	unique_ptr<Archive> (*create)();
+	bool        by_name = false; // Files are detected with [detect_file] even if they have been read
+	string_view entry_ext;       // Entries must have this extension (if not empty)
+};
+
+template<class A> unique_ptr<Archive> createArchive()
+{
+	return std::make_unique<A>();
+}
+
+// clang-format off
+const ArchiveFormatProbe format_probes[] = {
+	{ WadArchive::isWadArchive,           WadArchive::isWadArchive,           createArchive<WadArchive> },
+	{ ZipArchive::isZipArchive,           ZipArchive::isZipArchive,           createArchive<ZipArchive> },
+	{ ResArchive::isResArchive,           ResArchive::isResArchive,           createArchive<ResArchive> },
+	{ DatArchive::isDatArchive,           DatArchive::isDatArchive,           createArchive<DatArchive> },
+	{ LibArchive::isLibArchive,           LibArchive::isLibArchive,           createArchive<LibArchive> },
+	{ PakArchive::isPakArchive,           PakArchive::isPakArchive,           createArchive<PakArchive> },
+	{ BSPArchive::isBSPArchive,           BSPArchive::isBSPArchive,           createArchive<BSPArchive> },
+	{ GrpArchive::isGrpArchive,           GrpArchive::isGrpArchive,           createArchive<GrpArchive> },
+	{ RffArchive::isRffArchive,           RffArchive::isRffArchive,           createArchive<RffArchive> },
+	{ GobArchive::isGobArchive,           GobArchive::isGobArchive,           createArchive<GobArchive> },
+	{ LfdArchive::isLfdArchive,           LfdArchive::isLfdArchive,           createArchive<LfdArchive> },
+	{ HogArchive::isHogArchive,           HogArchive::isHogArchive,           createArchive<HogArchive> },
+	{ ADatArchive::isADatArchive,         ADatArchive::isADatArchive,         createArchive<ADatArchive> },
+	{ Wad2Archive::isWad2Archive,         Wad2Archive::isWad2Archive,         createArchive<Wad2Archive> },
+	{ WadJArchive::isWadJArchive,         WadJArchive::isWadJArchive,         createArchive<WadJArchive> },
+	{ WolfArchive::isWolfArchive,         WolfArchive::isWolfArchive,         createArchive<WolfArchive>, true },
+	{ GZipArchive::isGZipArchive,         GZipArchive::isGZipArchive,         createArchive<GZipArchive> },
+	{ BZip2Archive::isBZip2Archive,       BZip2Archive::isBZip2Archive,       createArchive<BZip2Archive> },
+	{ TarArchive::isTarArchive,           TarArchive::isTarArchive,           createArchive<TarArchive> },
+	{ DiskArchive::isDiskArchive,         DiskArchive::isDiskArchive,         createArchive<DiskArchive> },
+	{ PodArchive::isPodArchive,           PodArchive::isPodArchive,           createArchive<PodArchive>, false, ".pod" },
+	{ ChasmBinArchive::isChasmBinArchive, ChasmBinArchive::isChasmBinArchive, createArchive<ChasmBinArchive> },
+	{ SiNArchive::isSiNArchive,           SiNArchive::isSiNArchive,           createArchive<SiNArchive> },
+};
+// clang-format on
+
+// -----------------------------------------------------------------------------
+// Detects the archive format of [data] and returns a new (unopened) archive of
+// that format, or nullptr if the format is unsupported. [data] is either the
+// contents of file [filename] or of entry [entry_name], all format probes run
+// against it so the file is only read once
+// -----------------------------------------------------------------------------
+unique_ptr<Archive> createArchiveForData(MemChunk& data, const string& filename, string_view entry_name = {})
+{
+	for (const auto& probe : format_probes)
+	{
+		if (!entry_name.empty() && !probe.entry_ext.empty() && !strutil::endsWithCI(entry_name, probe.entry_ext))
+			continue;
+
+		bool detected = !filename.empty() && probe.by_name ? probe.detect_file(filename) : probe.detect(data);
+		if (detected)
+			return probe.create();
+	}
+
+	// Unsupported format
+	global::error = "Unsupported or invalid Archive format";
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Detects the archive format of file [filename] and returns a new (unopened)
+// archive of that format, or nullptr if the format is unsupported. Each probe
+// only reads the parts of the file it checks
+// -----------------------------------------------------------------------------
+unique_ptr<Archive> createArchiveForFile(const string& filename)
+{
+	for (const auto& probe : format_probes)
+		if (probe.detect_file(filename))
+			return probe.create();
+
+	// Unsupported format
+	global::error = "Unsupported or invalid Archive format";
+	return nullptr;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // ArchiveManager Class Functions
@@ -224,6 +322,25 @@ bool ArchiveManager::addArchive(shared_ptr<Archive> archive)
 		return false;
 }
 
+// -----------------------------------------------------------------------------
+// Adds [archive], which has already been opened (eg. by openArchive with
+// [manage] false on a worker thread), to the list of open archives and recent
+// files. If [silent] is false, announces that it was opened
+// -----------------------------------------------------------------------------
+void ArchiveManager::manageArchive(shared_ptr<Archive> archive, bool silent)
+{
+	auto index = open_archives_.size();
+	if (!addArchive(archive))
+		return;
+
+	// Announce open
+	if (!silent)
+		signals_.archive_opened(index);
+
+	// Add to recent files
+	addRecentFile(archive->filename());
+}
+
 // -----------------------------------------------------------------------------
 // Returns the archive at the index specified (nullptr if it doesn't exist)
 // -----------------------------------------------------------------------------
@@ -293,78 +410,51 @@ shared_ptr<Archive> ArchiveManager::openArchive(string_view filename, bool manag
 		return new_archive;
 	}
 
-	// Determine file format
-	string std_fn{ filename };
-	if (WadArchive::isWadArchive(std_fn))
-		new_archive = std::make_shared<WadArchive>();
-	else if (ZipArchive::isZipArchive(std_fn))
+	// Read the file (or just its start if it is large)
+	SFile    file(filename);
+	MemChunk data;
+	auto     whole = file.size() <= probe_read_max;
+	if (!file.isOpen() || !file.read(data, whole ? file.size() : probe_header_size))
+	{
+		global::error = "Unable to open file. Make sure it isn't in use by another program.";
+		log::error(global::error);
+		return nullptr;
+	}
+	file.close();
+
+	// Determine the format and open the archive. Zips already read in full are
+	// opened from that data, large zips from the file (which is copied to a
+	// temp file rather than read into memory). Any other format is opened from
+	// the whole file's data
+	bool opened;
+	if (ZipArchive::isZipArchive(data))
+	{
 		new_archive = std::make_shared<ZipArchive>();
-	else if (ResArchive::isResArchive(std_fn))
-		new_archive = std::make_shared<ResArchive>();
-	else if (DatArchive::isDatArchive(std_fn))
-		new_archive = std::make_shared<DatArchive>();
-	else if (LibArchive::isLibArchive(std_fn))
-		new_archive = std::make_shared<LibArchive>();
-	else if (PakArchive::isPakArchive(std_fn))
-		new_archive = std::make_shared<PakArchive>();
-	else if (BSPArchive::isBSPArchive(std_fn))
-		new_archive = std::make_shared<BSPArchive>();
-	else if (GrpArchive::isGrpArchive(std_fn))
-		new_archive = std::make_shared<GrpArchive>();
-	else if (RffArchive::isRffArchive(std_fn))
-		new_archive = std::make_shared<RffArchive>();
-	else if (GobArchive::isGobArchive(std_fn))
-		new_archive = std::make_shared<GobArchive>();
-	else if (LfdArchive::isLfdArchive(std_fn))
-		new_archive = std::make_shared<LfdArchive>();
-	else if (HogArchive::isHogArchive(std_fn))
-		new_archive = std::make_shared<HogArchive>();
-	else if (ADatArchive::isADatArchive(std_fn))
-		new_archive = std::make_shared<ADatArchive>();
-	else if (Wad2Archive::isWad2Archive(std_fn))
-		new_archive = std::make_shared<Wad2Archive>();
-	else if (WadJArchive::isWadJArchive(std_fn))
-		new_archive = std::make_shared<WadJArchive>();
-	else if (WolfArchive::isWolfArchive(std_fn))
-		new_archive = std::make_shared<WolfArchive>();
-	else if (GZipArchive::isGZipArchive(std_fn))
-		new_archive = std::make_shared<GZipArchive>();
-	else if (BZip2Archive::isBZip2Archive(std_fn))
-		new_archive = std::make_shared<BZip2Archive>();
-	else if (TarArchive::isTarArchive(std_fn))
-		new_archive = std::make_shared<TarArchive>();
-	else if (DiskArchive::isDiskArchive(std_fn))
-		new_archive = std::make_shared<DiskArchive>();
-	else if (PodArchive::isPodArchive(std_fn))
-		new_archive = std::make_shared<PodArchive>();
-	else if (ChasmBinArchive::isChasmBinArchive(std_fn))
-		new_archive = std::make_shared<ChasmBinArchive>();
-	else if (SiNArchive::isSiNArchive(std_fn))
-		new_archive = std::make_shared<SiNArchive>();
+		opened      = whole ? new_archive->open(filename, data) : new_archive->open(filename);
+	}
 	else
 	{
-		// Unsupported format
-		global::error = "Unsupported or invalid Archive format";
-		return nullptr;
+		// Large files are detected from the file, so only supported ones are
+		// read in full
+		new_archive = whole ? createArchiveForData(data, string{ filename }) : createArchiveForFile(string{ filename });
+		if (!new_archive)
+			return nullptr;
+		if (!whole && !data.importFile(filename))
+		{
+			global::error = "Unable to open file. Make sure it isn't in use by another program.";
+			log::error(global::error);
+			return nullptr;
+		}
+
+		opened = new_archive->open(filename, data);
 	}
 
 	// If it opened successfully, add it to the list if needed & return it,
 	// Otherwise, delete it and return nullptr
-	if (new_archive->open(filename))
+	if (opened)
 	{
 		if (manage)
-		{
-			// Add the archive
-			auto index = open_archives_.size();
-			addArchive(new_archive);
-
-			// Announce open
-			if (!silent)
-				signals_.archive_opened(index);
-
-			// Add to recent files
-			addRecentFile(filename);
-		}
+			manageArchive(new_archive, silent);
 
 		// Return the opened archive
 		return new_archive;
@@ -399,59 +489,9 @@ shared_ptr<Archive> ArchiveManager::openArchive(ArchiveEntry* entry, bool manage
 	}
 
 	// Check entry type
-	shared_ptr<Archive> new_archive;
-	if (WadArchive::isWadArchive(entry->data()))
-		new_archive = std::make_shared<WadArchive>();
-	else if (ZipArchive::isZipArchive(entry->data()))
-		new_archive = std::make_shared<ZipArchive>();
-	else if (ResArchive::isResArchive(entry->data()))
-		new_archive = std::make_shared<ResArchive>();
-	else if (LibArchive::isLibArchive(entry->data()))
-		new_archive = std::make_shared<LibArchive>();
-	else if (DatArchive::isDatArchive(entry->data()))
-		new_archive = std::make_shared<DatArchive>();
-	else if (PakArchive::isPakArchive(entry->data()))
-		new_archive = std::make_shared<PakArchive>();
-	else if (BSPArchive::isBSPArchive(entry->data()))
-		new_archive = std::make_shared<BSPArchive>();
-	else if (GrpArchive::isGrpArchive(entry->data()))
-		new_archive = std::make_shared<GrpArchive>();
-	else if (RffArchive::isRffArchive(entry->data()))
-		new_archive = std::make_shared<RffArchive>();
-	else if (GobArchive::isGobArchive(entry->data()))
-		new_archive = std::make_shared<GobArchive>();
-	else if (LfdArchive::isLfdArchive(entry->data()))
-		new_archive = std::make_shared<LfdArchive>();
-	else if (HogArchive::isHogArchive(entry->data()))
-		new_archive = std::make_shared<HogArchive>();
-	else if (ADatArchive::isADatArchive(entry->data()))
-		new_archive = std::make_shared<ADatArchive>();
-	else if (Wad2Archive::isWad2Archive(entry->data()))
-		new_archive = std::make_shared<Wad2Archive>();
-	else if (WadJArchive::isWadJArchive(entry->data()))
-		new_archive = std::make_shared<WadJArchive>();
-	else if (WolfArchive::isWolfArchive(entry->data()))
-		new_archive = std::make_shared<WolfArchive>();
-	else if (GZipArchive::isGZipArchive(entry->data()))
-		new_archive = std::make_shared<GZipArchive>();
-	else if (BZip2Archive::isBZip2Archive(entry->data()))
-		new_archive = std::make_shared<BZip2Archive>();
-	else if (TarArchive::isTarArchive(entry->data()))
-		new_archive = std::make_shared<TarArchive>();
-	else if (DiskArchive::isDiskArchive(entry->data()))
-		new_archive = std::make_shared<DiskArchive>();
-	else if (strutil::endsWithCI(entry->name(), ".pod") && PodArchive::isPodArchive(entry->data()))
-		new_archive = std::make_shared<PodArchive>();
-	else if (ChasmBinArchive::isChasmBinArchive(entry->data()))
-		new_archive = std::make_shared<ChasmBinArchive>();
-	else if (SiNArchive::isSiNArchive(entry->data()))
-		new_archive = std::make_shared<SiNArchive>();
-	else
-	{
-		// Unsupported format
-		global::error = "Unsupported or invalid Archive format";
+	shared_ptr<Archive> new_archive = createArchiveForData(entry->data(), {}, entry->name());
+	if (!new_archive)
 		return nullptr;
-	}
 
 	// If it opened successfully, add it to the list & return it,
 	// Otherwise, delete it and return nullptr
@@ -513,18 +553,7 @@ shared_ptr<Archive> ArchiveManager::openDirArchive(string_view dir, bool manage,
 	if (new_archive->open(dir))
 	{
 		if (manage)
-		{
-			// Add the archive
-			auto index = open_archives_.size();
-			addArchive(new_archive);
-
-			// Announce open
-			if (!silent)
-				signals_.archive_opened(index);
-
-			// Add to recent files
-			addRecentFile(dir);
-		}
+			manageArchive(new_archive, silent);
 
 		// Return the opened archive
 		return new_archive;
@@ -906,27 +935,67 @@ bool ArchiveManager::openBaseResource(int index)
 		return false;
 	}
 
-	// Create archive based on file type
-	auto filename = base_resource_paths_[index];
+	// Open the archive
+	ui::showSplash(fmt::format("Opening {}...", base_resource_paths_[index]), true);
+	auto archive = loadBaseResource(index);
+	ui::hideSplash();
+
+	return setBaseResource(index, std::move(archive));
+}
+
+// -----------------------------------------------------------------------------
+// Opens and returns the base resource archive [index], without making it the
+// current base resource. Can be called from a worker thread, the result is
+// then passed to setBaseResource on the main thread.
+// Returns nullptr if the archive couldn't be opened
+// -----------------------------------------------------------------------------
+unique_ptr<Archive> ArchiveManager::loadBaseResource(int index) const
+{
+	if (index < 0 || (unsigned)index >= base_resource_paths_.size())
+		return nullptr;
+
+	// Create archive based on the file's type (base resources can only be wads
+	// or zips). Zips are opened from the file (copied to a temp file), wads are
+	// read into memory
+	const auto&         filename = base_resource_paths_[index];
+	unique_ptr<Archive> archive;
 	if (WadArchive::isWadArchive(filename))
-		base_resource_archive_ = std::make_unique<WadArchive>();
+		archive = std::make_unique<WadArchive>();
 	else if (ZipArchive::isZipArchive(filename))
-		base_resource_archive_ = std::make_unique<ZipArchive>();
+		archive = std::make_unique<ZipArchive>();
 	else
-		return false;
+		return nullptr;
 
 	// Attempt to open the file
-	ui::showSplash(fmt::format("Opening {}...", filename), true);
-	if (base_resource_archive_->open(filename))
+	if (!archive->open(filename))
+		return nullptr;
+
+	return archive;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the current base resource to [archive], opened from base resource
+// path [index] by loadBaseResource. If [archive] is null (failed to open),
+// there will be no current base resource. Returns false in that case
+// -----------------------------------------------------------------------------
+bool ArchiveManager::setBaseResource(int index, unique_ptr<Archive> archive)
+{
+	// Close/delete current base resource archive
+	if (base_resource_archive_)
+	{
+		app::resources().removeArchive(base_resource_archive_.get());
+		base_resource_archive_ = nullptr;
+	}
+
+	base_resource_archive_ = std::move(archive);
+	if (base_resource_archive_)
 	{
 		base_resource = index;
-		ui::hideSplash();
 		app::resources().addArchive(base_resource_archive_.get());
 		signals_.base_res_current_changed(index);
 		return true;
 	}
-	base_resource_archive_ = nullptr;
-	ui::hideSplash();
+
 	signals_.base_res_current_changed(index);
 	return false;
 }
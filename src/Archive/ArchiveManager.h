@@ -14,6 +14,7 @@ public:
 	bool                        initBaseResource();
 	bool                        resArchiveOK() const { return res_archive_open_; }
 	bool                        addArchive(shared_ptr<Archive> archive);
+	void                        manageArchive(shared_ptr<Archive> archive, bool silent = false);
 	bool                        validResDir(string_view dir) const;
 	shared_ptr<Archive>         getArchive(int index);
 	shared_ptr<Archive>         getArchive(string_view filename);
@@ -42,12 +43,14 @@ public:
 	const vector<weak_ptr<ArchiveEntry>>& bookmarks() const { return bookmarks_; }
 
 	// Base resource archive stuff
-	Archive* baseResourceArchive() const { return base_resource_archive_.get(); }
-	bool     addBaseResourcePath(string_view path);
-	void     removeBaseResourcePath(unsigned index);
-	unsigned numBaseResourcePaths() const { return base_resource_paths_.size(); }
-	string   getBaseResourcePath(unsigned index);
-	bool     openBaseResource(int index);
+	Archive*            baseResourceArchive() const { return base_resource_archive_.get(); }
+	bool                addBaseResourcePath(string_view path);
+	void                removeBaseResourcePath(unsigned index);
+	unsigned            numBaseResourcePaths() const { return base_resource_paths_.size(); }
+	string              getBaseResourcePath(unsigned index);
+	bool                openBaseResource(int index);
+	unique_ptr<Archive> loadBaseResource(int index) const;
+	bool                setBaseResource(int index, unique_ptr<Archive> archive);
 
 	// Resource entry get/search
 	ArchiveEntry*         getResourceEntry(string_view name, Archive* ignore = nullptr);
@@ -40,6 +40,7 @@
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Console.h"
+#include "General/Profiler.h"
 #include "MainEditor/MainEditor.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
@@ -598,6 +599,8 @@ bool EntryType::loadEntryTypes()
 // -----------------------------------------------------------------------------
 bool EntryType::detectEntryType(ArchiveEntry& entry)
 {
+	PROFILE_SCOPE("EntryType::detectEntryType");
+
 	// Do nothing if the entry is a folder or a map marker
 	if (entry.type() == etype_folder || entry.type() == etype_map)
 		return false;
@@ -79,10 +79,13 @@ bool BZip2Archive::open(MemChunk& mc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 	auto                    entry = std::make_shared<ArchiveEntry>(fn.fileName(), size);
 	MemChunk                xdata;
-	if (compression::bzip2Decompress(mc, xdata))
-		entry->importMemChunk(xdata);
-	else
-		return false;
+	if (!compression::getCachedDecompressed(mc, xdata))
+	{
+		if (!compression::bzip2Decompress(mc, xdata))
+			return false;
+		compression::cacheDecompressed(mc, xdata);
+	}
+	entry->importMemChunk(xdata);
 	rootDir()->addEntry(entry);
 	EntryType::detectEntryType(*entry);
 	entry->setState(ArchiveEntry::State::Unmodified);
@@ -100,10 +103,7 @@ bool BZip2Archive::open(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool BZip2Archive::write(MemChunk& mc, bool update)
 {
-	if (numEntries() == 1)
-		return compression::bzip2Compress(entryAt(0)->data(), mc);
-
-	return false;
+	return numEntries() == 1 && compression::bzip2Compress(entryAt(0)->data(), mc);
 }
 
 // -----------------------------------------------------------------------------
@@ -161,10 +161,13 @@ bool GZipArchive::open(MemChunk& mc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 	auto                    entry = std::make_shared<ArchiveEntry>(name, size - mds);
 	MemChunk                xdata;
-	if (compression::gzipInflate(mc, xdata))
-		entry->importMemChunk(xdata);
-	else
-		return false;
+	if (!compression::getCachedDecompressed(mc, xdata))
+	{
+		if (!compression::gzipInflate(mc, xdata))
+			return false;
+		compression::cacheDecompressed(mc, xdata);
+	}
+	entry->importMemChunk(xdata);
 	rootDir()->addEntry(entry);
 	EntryType::detectEntryType(*entry);
 	entry->setState(ArchiveEntry::State::Unmodified);
@@ -37,10 +37,12 @@
 #include "Main.h"
 #include "WadArchive.h"
 #include "General/Misc.h"
+#include "General/Profiler.h"
 #include "General/UI.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
+#include <numeric>
 
 using namespace slade;
 
@@ -125,6 +127,33 @@ bool isNamespaceEntry(ArchiveEntry* entry)
 {
 	return strutil::endsWith(entry->upperName(), "_START") || strutil::endsWith(entry->upperName(), "_END");
 }
+
+// -----------------------------------------------------------------------------
+// Returns the (ascending) indices of entries in [dir] between [start] and [end]
+// (exclusive) that need to be checked for a search for [match_name].
+// If [match_name] isn't empty, only entries with matching names are returned
+// (via the dir's name index)
+// -----------------------------------------------------------------------------
+vector<unsigned> searchCandidates(const ArchiveDir& dir, string_view match_name, unsigned start, unsigned end)
+{
+	vector<unsigned> indices;
+
+	if (!match_name.empty())
+	{
+		dir.entryIndicesMatching(match_name, false, indices);
+		indices.erase(
+			std::remove_if(
+				indices.begin(), indices.end(), [start, end](unsigned index) { return index < start || index >= end; }),
+			indices.end());
+	}
+	else if (end > start)
+	{
+		indices.resize(end - start);
+		std::iota(indices.begin(), indices.end(), start);
+	}
+
+	return indices;
+}
 } // namespace
 
 
@@ -135,6 +164,14 @@ bool isNamespaceEntry(ArchiveEntry* entry)
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// WadArchive class destructor
+// -----------------------------------------------------------------------------
+WadArchive::~WadArchive()
+{
+	closeDataFile();
+}
+
 // -----------------------------------------------------------------------------
 // Returns true if the archive can be written to disk
 // -----------------------------------------------------------------------------
@@ -325,6 +362,8 @@ bool WadArchive::hasFlatHack()
 // -----------------------------------------------------------------------------
 bool WadArchive::open(MemChunk& mc)
 {
+	PROFILE_SCOPE("WadArchive::open");
+
 	// Check data was given
 	if (!mc.hasData())
 		return false;
@@ -615,6 +654,9 @@ bool WadArchive::write(string_view filename, bool update)
 		return false;
 	}
 
+	// Can't keep reading entry data from a file that is being overwritten
+	closeDataFile();
+
 	// Open file for writing
 	wxFile file;
 	file.Open(wxString{ filename.data(), filename.size() }, wxFile::write);
@@ -700,19 +742,25 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
-	// Open wadfile
-	wxFile file(filename_);
-
-	// Check if opening the file failed
-	if (!file.IsOpened())
+	// Read the lump from the wadfile, which is kept open for subsequent reads
 	{
-		log::error("WadArchive::loadEntryData: Failed to open wadfile {}", filename_);
-		return false;
-	}
+		std::lock_guard lock(data_file_mutex_);
 
-	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
-	entry->importFileStream(file, entry->size());
+		if (!data_file_)
+		{
+			data_file_ = std::make_unique<wxFile>(filename_);
+			if (!data_file_->IsOpened())
+			{
+				data_file_.reset();
+				log::error("WadArchive::loadEntryData: Failed to open wadfile {}", filename_);
+				return false;
+			}
+		}
+
+		// Seek to lump offset in file and read it in
+		data_file_->Seek(getEntryOffset(entry), wxFromStart);
+		entry->importFileStream(*data_file_, entry->size());
+	}
 
 	// Set the lump to loaded
 	entry->setLoaded();
@@ -721,6 +769,15 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Closes the wadfile used for loading entry data, if it is open
+// -----------------------------------------------------------------------------
+void WadArchive::closeDataFile()
+{
+	std::lock_guard lock(data_file_mutex_);
+	data_file_.reset();
+}
+
 // -----------------------------------------------------------------------------
 // Override of Archive::addEntry to force entry addition to the root directory,
 // update namespaces if needed and rename the entry if necessary to be
@@ -1311,11 +1368,11 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 			return nullptr;
 	}
 
-	// Begin search
+	// Begin search (only entries with matching names if searching by name)
 	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	for (auto a : searchCandidates(*rootDir(), options.match_name, index, index_end))
 	{
-		entry = entryAt(index);
+		entry = entryAt(a);
 
 		// Check type
 		if (options.match_type)
@@ -1329,13 +1386,6 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!strutil::matches(options.match_name, entry->upperName()))
-				continue;
-		}
-
 		// Entry passed all checks so far, so we found a match
 		return entry;
 	}
@@ -1384,11 +1434,13 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 			return nullptr;
 	}
 
-	// Begin search
+	// Begin search (only entries with matching names if searching by name)
+	auto candidates = searchCandidates(
+		*rootDir(), options.match_name, static_cast<unsigned>(index_start), static_cast<unsigned>(index + 1));
 	ArchiveEntry* entry;
-	for (; index >= index_start; --index)
+	for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
 	{
-		entry = entryAt(index);
+		entry = entryAt(*it);
 
 		// Check type
 		if (options.match_type)
@@ -1402,13 +1454,6 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!strutil::matches(entry->upperName(), options.match_name))
-				continue;
-		}
-
 		// Entry passed all checks so far, so we found a match
 		return entry;
 	}
@@ -1454,10 +1499,11 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 			return ret;
 	}
 
+	// Begin search (only entries with matching names if searching by name)
 	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	for (auto a : searchCandidates(*rootDir(), options.match_name, index, index_end))
 	{
-		entry = entryAt(index);
+		entry = entryAt(a);
 
 		// Check type
 		if (options.match_type)
@@ -1471,13 +1517,6 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 				continue;
 		}
 
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!strutil::matches(entry->upperName(), options.match_name))
-				continue;
-		}
-
 		// Entry passed all checks so far, so we found a match
 		ret.push_back(entry);
 	}
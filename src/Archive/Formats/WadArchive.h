@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include <mutex>
 
 namespace slade
 {
@@ -8,7 +9,7 @@ class WadArchive : public TreelessArchive
 {
 public:
 	WadArchive() : TreelessArchive("wad") {}
-	~WadArchive() = default;
+	~WadArchive() override;
 
 	// Wad specific
 	bool     isIWAD() const { return iwad_; }
@@ -88,7 +89,11 @@ private:
 		NSPair(ArchiveEntry* start, ArchiveEntry* end) : start{ start }, start_index{ 0 }, end{ end }, end_index{ 0 } {}
 	};
 
-	bool           iwad_ = false;
-	vector<NSPair> namespaces_;
+	bool               iwad_ = false;
+	vector<NSPair>     namespaces_;
+	unique_ptr<wxFile> data_file_; // Kept open for loading entry data
+	std::mutex         data_file_mutex_;
+
+	void closeDataFile();
 };
 } // namespace slade
@@ -86,6 +86,17 @@ string findFileCasing(const strutil::Path& filename)
 #endif
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [filename] is one of the files of a multi-file Wolf archive
+// (maps, audio or graphics), which are opened from their file set by name
+// -----------------------------------------------------------------------------
+bool isWolfFileSetName(string_view filename)
+{
+	auto name = strutil::upper(strutil::Path::fileNameOf(filename, false));
+	return name == "MAPHEAD" || name == "GAMEMAPS" || name == "MAPTEMP" || name == "AUDIOHED" || name == "AUDIOT"
+		   || name == "VGAHEAD" || name == "VGAGRAPH" || name == "VGADICT";
+}
+
 // -----------------------------------------------------------------------------
 // Returns a Wolf constant depending on the size of the archive.
 // Anyone who finds that the Doom source code is hacky should take a look at how
@@ -460,6 +471,20 @@ bool WolfArchive::open(string_view filename)
 		return false;
 }
 
+// -----------------------------------------------------------------------------
+// Reads a Wolf format file from [data], the already read contents of
+// [filename]. Multi-file archives still need their other files read, so are
+// opened by name instead
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WolfArchive::open(string_view filename, MemChunk& data)
+{
+	if (isWolfFileSetName(filename))
+		return open(filename);
+
+	return Archive::open(filename, data);
+}
+
 // -----------------------------------------------------------------------------
 // Reads VSWAP Wolf format data from a MemChunk.
 // Returns true if successful, false otherwise
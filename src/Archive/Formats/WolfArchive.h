@@ -15,8 +15,9 @@ public:
 	void     setEntryOffset(ArchiveEntry* entry, uint32_t offset) const;
 
 	// Opening
-	bool open(string_view filename) override; // Open from File
-	bool open(MemChunk& mc) override;         // Open from MemChunk
+	bool open(string_view filename) override;                 // Open from File
+	bool open(string_view filename, MemChunk& data) override; // Open from File already read into [data]
+	bool open(MemChunk& mc) override;                         // Open from MemChunk
 
 	bool openAudio(MemChunk& head, MemChunk& data);
 	bool openGraph(MemChunk& head, MemChunk& data, MemChunk& dict);
@@ -38,8 +38,10 @@
 #include "ZipArchive.h"
 #include "App.h"
 #include "General/Misc.h"
+#include "General/Profiler.h"
 #include "General/UI.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
 #include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
 #include "WadArchive.h"
@@ -91,6 +93,8 @@ ZipArchive::ZipArchive() : Archive("zip")
 // -----------------------------------------------------------------------------
 ZipArchive::~ZipArchive()
 {
+	closeDataFile();
+
 	if (fileutil::fileExists(temp_file_))
 		fileutil::removeFile(temp_file_);
 }
@@ -108,12 +112,45 @@ bool ZipArchive::open(string_view filename)
 		return false;
 	}
 
-	// Copy the zip to a temp file (for use when saving)
-	generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
+	// Copy the zip to a temp file (for use when saving and loading entry data)
+	closeDataFile();
+	entry_locations_.clear();
+	if (!generateTempFileName(filename) || !fileutil::copyFile(filename, temp_file_))
+	{
+		global::error = "Unable to create temp file";
+		return false;
+	}
 
-	// Open the file
-	wxFFileInputStream in(wxutil::strFromView(filename));
+	return openTempFile(filename);
+}
+
+// -----------------------------------------------------------------------------
+// Reads zip data from [data], the contents of file [filename]
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::open(string_view filename, MemChunk& data)
+{
+	// Write the data to a temp file (for use when saving and loading entry
+	// data), rather than copying the file again
+	closeDataFile();
+	entry_locations_.clear();
+	if (!generateTempFileName(filename) || !data.exportFile(temp_file_))
+	{
+		global::error = "Unable to write temp file";
+		return false;
+	}
+
+	return openTempFile(filename);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the zip from its temp file copy, which has been created from [filename]
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openTempFile(string_view filename)
+{
+	// Open the temp file
+	wxFFileInputStream in(temp_file_);
 	if (!in.IsOk())
 	{
 		global::error = "Unable to open file";
@@ -144,6 +181,13 @@ bool ZipArchive::open(string_view filename)
 			return false;
 		}
 
+		// Record where the entry's data is in the file
+		entry_locations_.push_back(
+			{ static_cast<uint32_t>(zip_entry->GetOffset()),
+			  static_cast<uint32_t>(zip_entry->GetCompressedSize()),
+			  static_cast<uint32_t>(zip_entry->GetSize()),
+			  zip_entry->GetMethod() });
+
 		if (!zip_entry->IsDir())
 		{
 			// Get the entry name as a Path (so we can break it up)
@@ -224,9 +268,17 @@ bool ZipArchive::open(string_view filename)
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(MemChunk& mc)
 {
+	PROFILE_SCOPE("ZipArchive::open");
+
 	// Write the MemChunk to a temp file
-	const auto tempfile = app::path("slade-temp-open.zip", app::Dir::Temp);
-	mc.exportFile(tempfile);
+	const auto tempfile = fileutil::createTempFile("slade-temp-open.zip");
+	if (tempfile.empty() || !mc.exportFile(tempfile))
+	{
+		global::error = "Unable to write temp file";
+		if (!tempfile.empty())
+			fileutil::removeFile(tempfile);
+		return false;
+	}
 
 	// Load the file
 	const bool success = open(tempfile);
@@ -246,7 +298,12 @@ bool ZipArchive::write(MemChunk& mc, bool update)
 	bool success = false;
 
 	// Write to a temporary file
-	const auto tempfile = app::path("slade-temp-write.zip", app::Dir::Temp);
+	const auto tempfile = fileutil::createTempFile("slade-temp-write.zip");
+	if (tempfile.empty())
+	{
+		global::error = "Unable to create temp file";
+		return false;
+	}
 	if (write(tempfile, true))
 	{
 		// Load file into MemChunk
@@ -281,6 +338,9 @@ bool ZipArchive::write(string_view filename, bool update)
 	}
 #endif
 
+	// The temp file will be replaced after writing
+	closeDataFile();
+
 	// Open the file
 	wxFFileOutputStream out(wxutil::strFromView(filename));
 	if (!out.IsOk())
@@ -387,10 +447,14 @@ bool ZipArchive::write(string_view filename, bool update)
 	zip.Close();
 	out.Close();
 
-	// Update the temp file
-	if (temp_file_.empty())
-		generateTempFileName(filename);
-	fileutil::copyFile(filename, temp_file_);
+	// Update the temp file and entry locations, since entry zip indices have
+	// changed. If entries weren't updated their indices still refer to the
+	// current temp file, so it is left as is
+	if (update && (!temp_file_.empty() || generateTempFileName(filename)))
+	{
+		fileutil::copyFile(filename, temp_file_);
+		readEntryLocations(temp_file_);
+	}
 
 	ui::setSplashProgressMessage("");
 
@@ -429,52 +493,76 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Open the file
-	wxFFileInputStream in(filename_);
-	if (!in.IsOk())
+	// Read the entry's compressed data directly from its location in the file
+	MemChunk data;
+	uint32_t size   = 0;
+	int      method = 0;
 	{
-		log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", filename_);
-		return false;
-	}
+		std::lock_guard lock(data_file_mutex_);
 
-	// Create zip stream
-	wxZipInputStream zip(in);
-	if (!zip.IsOk())
-	{
-		log::error("ZipArchive::loadEntryData: Invalid zip file \"{}\"!", filename_);
-		return false;
+		if (zip_index < 0 || zip_index >= static_cast<int>(entry_locations_.size()))
+		{
+			log::error("Error: ZipEntry for entry \"{}\" does not exist in zip", entry->name());
+			return false;
+		}
+		const auto& location = entry_locations_[zip_index];
+		size                 = location.size;
+		method               = location.method;
+
+		// Open the file if needed
+		if (!data_file_)
+		{
+			data_file_ = std::make_unique<SFile>(fileutil::fileExists(temp_file_) ? temp_file_ : filename_);
+			if (!data_file_->isOpen())
+			{
+				data_file_.reset();
+				log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", filename_);
+				return false;
+			}
+		}
+
+		// Skip the local file header (its name/extra field lengths can differ
+		// from the central directory)
+		uint8_t header[30];
+		if (!data_file_->seekFromStart(location.header_offset) || !data_file_->read(header, 30) || header[0] != 'P'
+			|| header[1] != 'K' || header[2] != 3 || header[3] != 4)
+		{
+			log::error("ZipArchive::loadEntryData: Invalid local header for entry \"{}\"", entry->name());
+			return false;
+		}
+		unsigned name_length  = header[26] | (header[27] << 8);
+		unsigned extra_length = header[28] | (header[29] << 8);
+		data_file_->seek(name_length + extra_length);
+
+		if (!data_file_->read(data, location.compressed_size) || data.size() != location.compressed_size)
+		{
+			log::error("ZipArchive::loadEntryData: Unable to read data for entry \"{}\"", entry->name());
+			return false;
+		}
 	}
 
 	// Lock entry state
 	entry->lockState();
 
-	// Skip to correct entry in zip
-	auto zentry = zip.GetNextEntry();
-	for (long a = 0; a < zip_index; a++)
-	{
-		delete zentry;
-		zentry = zip.GetNextEntry();
-	}
-
-	// Abort if entry doesn't exist in zip (some kind of error)
-	if (!zentry)
+	// Decompress the data if needed
+	if (method == wxZIP_METHOD_DEFLATE)
 	{
-		log::error("Error: ZipEntry for entry \"{}\" does not exist in zip", entry->name());
-		return false;
+		MemChunk inflated;
+		if (!compression::zipInflate(data, inflated, size))
+		{
+			log::error("ZipArchive::loadEntryData: Unable to inflate entry \"{}\"", entry->name());
+			entry->unlockState();
+			return false;
+		}
+		entry->importMemChunk(inflated);
 	}
-
-	// Read the data
-	vector<uint8_t> data(zentry->GetSize());
-	zip.Read(data.data(), zentry->GetSize());
-	entry->importMem(data.data(), static_cast<uint32_t>(zentry->GetSize()));
+	else
+		entry->importMemChunk(data);
 
 	// Set the entry to loaded
 	entry->setLoaded();
 	entry->unlockState();
 
-	// Clean up
-	delete zentry;
-
 	return true;
 }
 
@@ -671,27 +759,61 @@ vector<ArchiveEntry*> ZipArchive::findAll(SearchOptions& options)
 }
 
 // -----------------------------------------------------------------------------
-// Generates the temp file path to use, from [filename].
-// The temp file will be in the configured temp folder
+// Creates the temp file to use, named from [filename], in the configured temp
+// folder. The file is created exclusively so zips with the same name (even
+// when opened concurrently) never share a temp file.
+// Returns false if the temp file couldn't be created
 // -----------------------------------------------------------------------------
-void ZipArchive::generateTempFileName(string_view filename)
+bool ZipArchive::generateTempFileName(string_view filename)
 {
-	const strutil::Path tfn(filename);
-	temp_file_ = app::path(tfn.fileName(), app::Dir::Temp);
-	if (wxFileExists(temp_file_))
+	// Remove any previous temp file
+	if (!temp_file_.empty() && fileutil::fileExists(temp_file_))
+		fileutil::removeFile(temp_file_);
+
+	temp_file_ = fileutil::createTempFile(strutil::Path::fileNameOf(filename));
+	return !temp_file_.empty();
+}
+
+// -----------------------------------------------------------------------------
+// Reads the locations of all entries' data within zip file [filename]
+// -----------------------------------------------------------------------------
+bool ZipArchive::readEntryLocations(const string& filename)
+{
+	std::lock_guard lock(data_file_mutex_);
+
+	entry_locations_.clear();
+
+	wxFFileInputStream in(filename);
+	if (!in.IsOk())
+		return false;
+
+	wxZipInputStream zip(in);
+	if (!zip.IsOk())
+		return false;
+
+	// Only the entry headers are read here, not the data
+	unique_ptr<wxZipEntry> zip_entry{ zip.GetNextEntry() };
+	while (zip_entry)
 	{
-		// Make sure we don't overwrite an existing temp file
-		// (in case there are multiple zips open with the same name)
-		int n = 1;
-		while (true)
-		{
-			temp_file_ = app::path(fmt::format("{}.{}", tfn.fileName(), n), app::Dir::Temp);
-			if (!wxFileExists(temp_file_))
-				break;
+		entry_locations_.push_back(
+			{ static_cast<uint32_t>(zip_entry->GetOffset()),
+			  static_cast<uint32_t>(zip_entry->GetCompressedSize()),
+			  static_cast<uint32_t>(zip_entry->GetSize()),
+			  zip_entry->GetMethod() });
 
-			n++;
-		}
+		zip_entry.reset(zip.GetNextEntry());
 	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Closes the file used for loading entry data, if it is open
+// -----------------------------------------------------------------------------
+void ZipArchive::closeDataFile()
+{
+	std::lock_guard lock(data_file_mutex_);
+	data_file_.reset();
 }
 
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include "Utility/FileUtils.h"
+#include <mutex>
 
 namespace slade
 {
@@ -11,8 +13,9 @@ public:
 	~ZipArchive() override;
 
 	// Opening
-	bool open(string_view filename) override; // Open from File
-	bool open(MemChunk& mc) override;         // Open from MemChunk
+	bool open(string_view filename) override;                 // Open from File
+	bool open(string_view filename, MemChunk& data) override; // Open from File already read into [data]
+	bool open(MemChunk& mc) override;                         // Open from MemChunk
 
 	// Writing/Saving
 	bool write(MemChunk& mc, bool update = true) override;         // Write to MemChunk
@@ -38,8 +41,23 @@ public:
 	static bool isZipArchive(const string& filename);
 
 private:
-	string temp_file_;
-
-	void generateTempFileName(string_view filename);
+	// Location of an entry's data within the zip file
+	struct EntryLocation
+	{
+		uint32_t header_offset   = 0; // Offset of the local file header
+		uint32_t compressed_size = 0;
+		uint32_t size            = 0;
+		int      method          = 0;
+	};
+
+	string                temp_file_;
+	vector<EntryLocation> entry_locations_; // Locations of entries in temp_file_, by zip index
+	unique_ptr<SFile>     data_file_;       // temp_file_, kept open for loading entry data
+	std::mutex            data_file_mutex_;
+
+	bool generateTempFileName(string_view filename);
+	bool openTempFile(string_view filename);
+	bool readEntryLocations(const string& filename);
+	void closeDataFile();
 };
 } // namespace slade
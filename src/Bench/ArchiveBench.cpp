@@ -0,0 +1,209 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    ArchiveBench.cpp
+// Description: Archive benchmarks - wad/zip open and save at varying entry
+//              counts, and entry type detection
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Archive/EntryType/EntryType.h"
+#include "Archive/Formats/WadArchive.h"
+#include "Archive/Formats/ZipArchive.h"
+#include "Bench.h"
+#include "Graphics/SImage/SIFormat.h"
+#include <random>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Fills [data] with [size] bytes of random words (compressible, like text
+// lumps) or random bytes (incompressible, like graphics or sounds)
+// -----------------------------------------------------------------------------
+void randomData(std::mt19937& rng, vector<uint8_t>& data, unsigned size, bool text)
+{
+	static const char* words[] = { "actor ", "states ", "spawn:\n", "TNT1 A 1 ", "goto ", "loop\n", "{ ", "}\n" };
+
+	data.clear();
+	if (text)
+	{
+		while (data.size() < size)
+		{
+			auto word = words[rng() % 8];
+			data.insert(data.end(), word, word + strlen(word));
+		}
+		data.resize(size);
+	}
+	else
+	{
+		data.resize(size);
+		for (auto& byte : data)
+			byte = rng() & 0xFF;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds [n_entries] entries of random data to [archive] and writes it to [out].
+// A quarter of the entries are text
+// -----------------------------------------------------------------------------
+void generateArchive(Archive& archive, unsigned n_entries, bool wad, MemChunk& out)
+{
+	std::mt19937    rng(n_entries);
+	vector<uint8_t> data;
+	for (unsigned a = 0; a < n_entries; ++a)
+	{
+		bool text = a % 4 == 0;
+		auto name = wad ? fmt::format("E{:07d}", a) : fmt::format("entry{:05d}.{}", a, text ? "txt" : "lmp");
+		randomData(rng, data, 16 + rng() % 4080, text);
+		archive.addNewEntry(name)->importMem(data.data(), data.size());
+	}
+
+	archive.write(out);
+}
+
+// -----------------------------------------------------------------------------
+// Runs open and save benchmarks for archive type [A] with [n_entries]
+// -----------------------------------------------------------------------------
+template<class A> void archiveOpenSave(string_view type, unsigned n_entries)
+{
+	if (!bench::enabled(fmt::format("archive/{}", type)))
+		return;
+
+	MemChunk data;
+	{
+		A archive;
+		generateArchive(archive, n_entries, type == "wad", data);
+	}
+
+	unique_ptr<A> archive;
+	bench::run(
+		fmt::format("archive/{}_open/{}", type, n_entries),
+		n_entries,
+		"entries",
+		[&]
+		{
+			archive = std::make_unique<A>();
+			archive->open(data);
+		},
+		[&] { archive.reset(); });
+
+	archive = std::make_unique<A>();
+	archive->open(data);
+	bench::run(
+		fmt::format("archive/{}_save/{}", type, n_entries),
+		n_entries,
+		"entries",
+		[&]
+		{
+			MemChunk out;
+			archive->write(out);
+			bench::keep(out);
+		});
+}
+
+// -----------------------------------------------------------------------------
+// Runs the entry type detection benchmark over a mix of typical entries
+// -----------------------------------------------------------------------------
+void detectEntryTypes()
+{
+	if (!bench::enabled("archive/detect_entry_type"))
+		return;
+
+	std::mt19937    rng(1);
+	vector<uint8_t> data;
+	WadArchive      wad;
+
+	// Images
+	SImage          image;
+	vector<uint8_t> pixels(64 * 64);
+	for (auto& pixel : pixels)
+		pixel = rng() & 0xFF;
+	image.setImageData(pixels, 64, 64, SImage::Type::PalMask);
+	MemChunk png, gfx;
+	SIFormat::getFormat("png")->saveImage(image, png);
+	SIFormat::getFormat("doom")->saveImage(image, gfx);
+
+	// Sound and music headers
+	const uint8_t wav[] = { 'R', 'I', 'F', 'F', 36, 0,  0,  0, 'W', 'A', 'V', 'E', 'f', 'm', 't',
+							' ', 16,  0,   0,   1,  0,  1,  0, 0x11, 0x2B, 0, 0,   0x11, 0x2B, 0,
+							0,   1,   0,   8,   0,  'd', 'a', 't', 'a', 0, 0,   0,   0 };
+	const uint8_t mid[] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96 };
+
+	for (unsigned a = 0; a < 200; ++a)
+	{
+		wad.addNewEntry(fmt::format("PNG{:05d}", a))->importMemChunk(png);
+		wad.addNewEntry(fmt::format("GFX{:05d}", a))->importMemChunk(gfx);
+		wad.addNewEntry(fmt::format("WAV{:05d}", a))->importMem(wav, sizeof(wav));
+		wad.addNewEntry(fmt::format("MID{:05d}", a))->importMem(mid, sizeof(mid));
+
+		randomData(rng, data, 4096, false);
+		wad.addNewEntry(fmt::format("FLT{:05d}", a))->importMem(data.data(), data.size());
+		randomData(rng, data, 16 + rng() % 4080, true);
+		wad.addNewEntry(fmt::format("TXT{:05d}", a))->importMem(data.data(), data.size());
+		randomData(rng, data, 16 + rng() % 4080, false);
+		wad.addNewEntry(fmt::format("BIN{:05d}", a))->importMem(data.data(), data.size());
+	}
+
+	vector<ArchiveEntry*> entries;
+	wad.putEntryTreeAsList(entries);
+	bench::run(
+		"archive/detect_entry_type",
+		entries.size(),
+		"entries",
+		[&]
+		{
+			for (auto entry : entries)
+				EntryType::detectEntryType(*entry);
+		});
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Runs all archive benchmarks
+// -----------------------------------------------------------------------------
+void bench::archiveBenchmarks()
+{
+	for (auto n_entries : { 100, 1000, 10000 })
+	{
+		archiveOpenSave<WadArchive>("wad", n_entries);
+		archiveOpenSave<ZipArchive>("zip", n_entries);
+	}
+
+	detectEntryTypes();
+}
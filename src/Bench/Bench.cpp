@@ -0,0 +1,204 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    Bench.cpp
+// Description: slade-bench benchmark runner. Times benchmarks over a number of
+//              iterations and collects the results for JSON output
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Bench.h"
+#include "App.h"
+#include "General/Jobs.h"
+#include "Utility/StringUtils.h"
+#include <chrono>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace slade::bench
+{
+Settings       bench_settings;
+vector<Result> bench_results;
+} // namespace slade::bench
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Returns the benchmark settings
+// -----------------------------------------------------------------------------
+bench::Settings& bench::settings()
+{
+	return bench_settings;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the results of all benchmarks run so far
+// -----------------------------------------------------------------------------
+const vector<bench::Result>& bench::results()
+{
+	return bench_results;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if any benchmark with a name starting with [prefix] would run
+// -----------------------------------------------------------------------------
+bool bench::enabled(string_view prefix)
+{
+	// A filter can only be checked against a full name, so just check that the
+	// filter doesn't rule out the prefix (up to its first wildcard)
+	auto filter = string_view{ bench_settings.filter };
+	auto fixed  = filter.substr(0, filter.find_first_of("*?"));
+	auto len    = std::min(fixed.size(), prefix.size());
+
+	return strutil::equalCI(fixed.substr(0, len), prefix.substr(0, len));
+}
+
+// -----------------------------------------------------------------------------
+// Runs benchmark [name], timing [fn] for at least settings().min_iterations
+// iterations and settings().min_time_ms in total
+// -----------------------------------------------------------------------------
+void bench::run(
+	string_view                  name,
+	double                       items,
+	string_view                  unit,
+	const std::function<void()>& fn,
+	const std::function<void()>& setup)
+{
+	using clock = std::chrono::steady_clock;
+
+	if (!strutil::matchesCI(name, bench_settings.filter))
+		return;
+
+	// Warm up
+	if (setup)
+		setup();
+	fn();
+
+	vector<double> times;
+	double         total = 0.;
+	while (times.size() < bench_settings.max_iterations
+		   && (times.size() < bench_settings.min_iterations || total < bench_settings.min_time_ms))
+	{
+		if (setup)
+			setup();
+
+		auto start = clock::now();
+		fn();
+		auto ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		times.push_back(ms);
+		total += ms;
+	}
+
+	Result result;
+	result.name       = name;
+	result.unit       = unit;
+	result.items      = items;
+	result.iterations = times.size();
+	result.mean_ms    = total / times.size();
+	std::sort(times.begin(), times.end());
+	result.min_ms    = times.front();
+	result.max_ms    = times.back();
+	result.median_ms = times.size() % 2 ? times[times.size() / 2] :
+										  (times[times.size() / 2 - 1] + times[times.size() / 2]) * 0.5;
+
+	if (items > 0)
+		fmt::print(
+			stderr,
+			"{:<48} {:>10.3f} ms {:>14.0f} {}/s\n",
+			name,
+			result.median_ms,
+			items * 1000. / result.median_ms,
+			unit);
+	else
+		fmt::print(stderr, "{:<48} {:>10.3f} ms\n", name, result.median_ms);
+
+	bench_results.push_back(result);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all benchmark results (and info about the run) as JSON
+// -----------------------------------------------------------------------------
+string bench::resultsJson()
+{
+	auto now = std::time(nullptr);
+	char timestamp[32];
+	std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	string json = "{\n";
+	json += fmt::format("  \"version\": \"{}\",\n", app::version().toString());
+	json += fmt::format("  \"timestamp\": \"{}\",\n", timestamp);
+#ifdef NDEBUG
+	json += "  \"build\": \"release\",\n";
+#else
+	json += "  \"build\": \"debug\",\n";
+#endif
+	json += fmt::format("  \"threads\": {},\n", jobs::nThreads());
+	json += fmt::format("  \"min_time_ms\": {},\n", bench_settings.min_time_ms);
+	json += "  \"benchmarks\": [";
+
+	bool first = true;
+	for (const auto& result : bench_results)
+	{
+		json += first ? "\n" : ",\n";
+		json += fmt::format(
+			"    {{ \"name\": \"{}\", \"iterations\": {}, \"min_ms\": {:.6f}, \"median_ms\": {:.6f}, "
+			"\"mean_ms\": {:.6f}, \"max_ms\": {:.6f}",
+			result.name,
+			result.iterations,
+			result.min_ms,
+			result.median_ms,
+			result.mean_ms,
+			result.max_ms);
+		if (result.items > 0)
+			json += fmt::format(
+				", \"items\": {}, \"unit\": \"{}\", \"items_per_sec\": {:.1f}",
+				result.items,
+				result.unit,
+				result.items * 1000. / result.median_ms);
+		json += " }";
+		first = false;
+	}
+
+	json += "\n  ]\n}\n";
+	return json;
+}
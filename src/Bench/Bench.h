@@ -0,0 +1,57 @@
+#pragma once
+
+namespace slade::bench
+{
+struct Settings
+{
+	string   filter         = "*"; // Only run benchmarks with names matching this (wildcards allowed)
+	double   min_time_ms    = 500.;
+	unsigned min_iterations = 5;
+	unsigned max_iterations = 10000;
+};
+
+struct Result
+{
+	string   name;
+	string   unit; // What [items] counts (eg. "entries", "pixels")
+	double   items      = 0.; // Number of items processed per iteration
+	unsigned iterations = 0;
+	double   min_ms     = 0.;
+	double   median_ms  = 0.;
+	double   mean_ms    = 0.;
+	double   max_ms     = 0.;
+};
+
+Settings&             settings();
+const vector<Result>& results();
+
+// Returns true if any benchmark with a name starting with [prefix] would run
+// with the current filter, so setup for a group of benchmarks can be skipped
+bool enabled(string_view prefix);
+
+// Runs benchmark [name] (if it matches the filter), timing [fn] repeatedly.
+// [setup] (if given) is called before each iteration, and isn't timed.
+// [items] (in [unit]s) is the amount of work each iteration does, used to
+// report throughput
+void run(
+	string_view                  name,
+	double                       items,
+	string_view                  unit,
+	const std::function<void()>& fn,
+	const std::function<void()>& setup = {});
+
+// Prevents the compiler from optimizing away a [value] that is otherwise unused
+template<typename T> void keep(const T& value)
+{
+	static const void* volatile sink;
+	sink = &value;
+}
+
+string resultsJson();
+
+// Benchmark groups
+void archiveBenchmarks();
+void mapBenchmarks();
+void graphicsBenchmarks();
+void textBenchmarks();
+} // namespace slade::bench
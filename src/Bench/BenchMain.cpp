@@ -0,0 +1,136 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    BenchMain.cpp
+// Description: Program entry point for slade-bench, which runs benchmarks of
+//              archive, map, graphics and text processing hot paths on
+//              synthetic data and outputs the results as JSON
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "Bench.h"
+#include "General/Jobs.h"
+#include "Utility/FileUtils.h"
+#include "Utility/StringUtils.h"
+#include <wx/init.h>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// BenchApp Class
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// wx needs an application object for its base services (paths, events, etc.),
+// but there is no event loop and the GUI is never initialised
+class BenchApp : public wxAppConsole
+{
+public:
+	int OnRun() override { return 0; }
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Entry Point
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	// Process options
+	string out_file;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		string_view opt = argv[arg];
+		if (opt == "--filter" && arg + 1 < argc)
+			bench::settings().filter = argv[++arg];
+		else if (opt == "--min-time" && arg + 1 < argc)
+			bench::settings().min_time_ms = strutil::asDouble(argv[++arg]);
+		else if (opt == "--out" && arg + 1 < argc)
+			out_file = argv[++arg];
+		else
+		{
+			fmt::print(
+				"Usage: slade-bench [--filter <pattern>] [--min-time <ms>] [--out <file>]\n\n"
+				"  --filter <pattern>  Only run benchmarks with names matching <pattern> (eg. \"map_*\")\n"
+				"  --min-time <ms>     Minimum time to spend running each benchmark (default: 500)\n"
+				"  --out <file>        Write JSON results to <file> instead of stdout\n");
+			return opt == "-h" || opt == "--help" ? 0 : 2;
+		}
+	}
+
+	// Init wx (without the GUI)
+	wxAppConsole::SetInstance(new BenchApp());
+	wxInitializer wx_init(argc, argv);
+	if (!wx_init.IsOk())
+	{
+		fmt::print(stderr, "Failed to initialise wxWidgets\n");
+		return 1;
+	}
+#ifdef __WINDOWS__
+	wxAppConsole::GetInstance()->SetAppName("SLADE3");
+#else
+	wxAppConsole::GetInstance()->SetAppName("slade3");
+#endif
+
+	// Init SLADE
+	if (!app::initHeadless(0, "slade-bench.log"))
+	{
+		fmt::print(stderr, "Failed to initialise SLADE, see {}\n", app::path("slade-bench.log", app::Dir::User));
+		return 1;
+	}
+
+	// Run benchmarks
+	bench::archiveBenchmarks();
+	bench::mapBenchmarks();
+	bench::graphicsBenchmarks();
+	bench::textBenchmarks();
+
+	// Output results
+	int result = 0;
+	if (out_file.empty())
+		fmt::print("{}", bench::resultsJson());
+	else if (!fileutil::writeStringToFile(bench::resultsJson(), out_file))
+	{
+		fmt::print(stderr, "Unable to write results to \"{}\"\n", out_file);
+		result = 1;
+	}
+
+	jobs::waitIdle();
+	app::exit(false);
+
+	return result;
+}
@@ -0,0 +1,251 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    GraphicsBench.cpp
+// Description: Graphics benchmarks - composite texture generation, palette
+//              conversion per colour matching mode and image blending
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "Archive/Formats/WadArchive.h"
+#include "Bench.h"
+#include "General/ResourceManager.h"
+#include "Graphics/CTexture/CTexture.h"
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/Palette/PaletteManager.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+#include <random>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// External Variables
+//
+// -----------------------------------------------------------------------------
+EXTERN_CVAR(Int, col_match)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Sets [image] to a [width]x[height] image of random pixels of [type]
+// -----------------------------------------------------------------------------
+void randomImage(std::mt19937& rng, SImage& image, int width, int height, SImage::Type type)
+{
+	vector<uint8_t> data(width * height * (type == SImage::Type::RGBA ? 4 : 1));
+	for (auto& byte : data)
+		byte = rng() & 0xFF;
+
+	// Keep RGBA images mostly opaque so blending isn't skipped
+	if (type == SImage::Type::RGBA)
+		for (unsigned a = 3; a < data.size(); a += 4)
+			data[a] = data[a] < 32 ? 0 : 255;
+
+	image.setImageData(data, width, height, type);
+}
+
+// -----------------------------------------------------------------------------
+// Runs composite texture benchmarks, for both a regular (TEXTUREx) and an
+// extended (ZDoom TEXTURES) texture made of 16 overlapping patches
+// -----------------------------------------------------------------------------
+void compositeTextures()
+{
+	if (!bench::enabled("graphics/ctexture_to_image"))
+		return;
+
+	std::mt19937 rng(1);
+	auto         palette = app::paletteManager()->globalPalette();
+
+	// Generate a wad with patches (reopened from written data so the patches
+	// are detected in the patches namespace)
+	MemChunk data;
+	{
+		WadArchive wad;
+		SImage     patch;
+		MemChunk   png;
+		wad.addNewEntry("P_START");
+		for (unsigned a = 0; a < 16; ++a)
+		{
+			randomImage(rng, patch, 64, 128, SImage::Type::PalMask);
+			SIFormat::getFormat("png")->saveImage(patch, png, palette);
+			wad.addNewEntry(fmt::format("PATCH{:02d}", a))->importMemChunk(png);
+		}
+		wad.addNewEntry("P_END");
+		wad.write(data);
+	}
+	WadArchive wad;
+	wad.open(data);
+	app::resources().addArchive(&wad);
+
+	for (auto extended : { false, true })
+	{
+		CTexture texture("BENCHTEX", extended);
+		texture.setSize({ 256, 128 });
+		for (unsigned a = 0; a < 16; ++a)
+		{
+			auto x = static_cast<int>(rng() % 224) - 16;
+			auto y = static_cast<int>(rng() % 96) - 16;
+			texture.addPatch(fmt::format("PATCH{:02d}", a), x, y);
+			if (!extended)
+				continue;
+
+			// Use a mix of extended patch properties
+			auto patch = dynamic_cast<CTPatchEx*>(texture.patches().back().get());
+			switch (a % 4)
+			{
+			case 1:
+				patch->setStyle("Translucent");
+				patch->setAlpha(0.5f);
+				break;
+			case 2: patch->setStyle("Add"); break;
+			case 3:
+				patch->setBlendType(CTPatchEx::BlendType::Tint);
+				patch->setColour(255, 0, 0, 128);
+				break;
+			default: break;
+			}
+		}
+
+		bench::run(
+			fmt::format("graphics/ctexture_to_image/{}", extended ? "textures" : "doom"),
+			256 * 128,
+			"pixels",
+			[&]
+			{
+				SImage image;
+				texture.toImage(image, &wad, palette, extended);
+				bench::keep(image);
+			});
+	}
+
+	app::resources().removeArchive(&wad);
+}
+
+// -----------------------------------------------------------------------------
+// Runs RGBA -> paletted conversion benchmarks for each colour matching mode
+// -----------------------------------------------------------------------------
+void convertPaletted()
+{
+	if (!bench::enabled("graphics/convert_paletted"))
+		return;
+
+	static const std::pair<Palette::ColourMatch, const char*> modes[] = {
+		{ Palette::ColourMatch::Old, "old" }, { Palette::ColourMatch::RGB, "rgb" },
+		{ Palette::ColourMatch::HSL, "hsl" }, { Palette::ColourMatch::C76, "c76" },
+		{ Palette::ColourMatch::C94, "c94" }, { Palette::ColourMatch::C2K, "c2k" },
+	};
+
+	std::mt19937 rng(2);
+	SImage       source, image;
+	auto         palette = app::paletteManager()->globalPalette();
+	randomImage(rng, source, 256, 256, SImage::Type::RGBA);
+
+	int prev_match = col_match;
+	for (const auto& [mode, id] : modes)
+	{
+		col_match = static_cast<int>(mode);
+		bench::run(
+			fmt::format("graphics/convert_paletted/{}", id),
+			256 * 256,
+			"pixels",
+			[&] { image.convertPaletted(palette); },
+			[&] { image.copyImage(&source); });
+	}
+	col_match = prev_match;
+}
+
+// -----------------------------------------------------------------------------
+// Runs image blending benchmarks for each blend type
+// -----------------------------------------------------------------------------
+void drawImage()
+{
+	if (!bench::enabled("graphics/draw_image"))
+		return;
+
+	static const std::pair<SImage::BlendType, const char*> blends[] = {
+		{ SImage::BlendType::Normal, "normal" },
+		{ SImage::BlendType::Add, "add" },
+		{ SImage::BlendType::Subtract, "subtract" },
+		{ SImage::BlendType::ReverseSubtract, "reverse_subtract" },
+		{ SImage::BlendType::Modulate, "modulate" },
+	};
+
+	std::mt19937 rng(3);
+	SImage       source, dest, dest_pal;
+	auto         palette = app::paletteManager()->globalPalette();
+	randomImage(rng, source, 256, 256, SImage::Type::RGBA);
+	randomImage(rng, dest, 1024, 1024, SImage::Type::RGBA);
+	randomImage(rng, dest_pal, 1024, 1024, SImage::Type::PalMask);
+
+	// Draws the source image tiled over the whole of [target]
+	auto drawTiled = [&](SImage& target, SImage::DrawProps& props)
+	{
+		for (int y = 0; y < 1024; y += 256)
+			for (int x = 0; x < 1024; x += 256)
+				target.drawImage(source, x, y, props, palette, palette);
+	};
+
+	SImage::DrawProps props;
+	for (const auto& [blend, id] : blends)
+	{
+		props.blend = blend;
+		bench::run(
+			fmt::format("graphics/draw_image/{}", id), 1024 * 1024, "pixels", [&] { drawTiled(dest, props); });
+	}
+
+	props.blend = SImage::BlendType::Normal;
+	props.alpha = 0.5f;
+	bench::run("graphics/draw_image/translucent", 1024 * 1024, "pixels", [&] { drawTiled(dest, props); });
+
+	// Paletted destination (each pixel is matched back to the palette)
+	props.alpha = 1.0f;
+	bench::run("graphics/draw_image/paletted", 1024 * 1024, "pixels", [&] { drawTiled(dest_pal, props); });
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Runs all graphics benchmarks
+// -----------------------------------------------------------------------------
+void bench::graphicsBenchmarks()
+{
+	compositeTextures();
+	convertPaletted();
+	drawImage();
+}
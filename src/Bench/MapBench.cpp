@@ -0,0 +1,378 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    MapBench.cpp
+// Description: Map benchmarks - binary (doom) and UDMF map read/write, and
+//              the standard map checks
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Archive/Formats/WadArchive.h"
+#include "Bench.h"
+#include "Game/Configuration.h"
+#include "MapEditor/MapChecks.h"
+#include "SLADEMap/SLADEMap.h"
+#include <random>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A simple map definition that can be written in either binary or UDMF format
+struct GridMap
+{
+	struct Line
+	{
+		unsigned v1, v2;
+		int      front, back; // Sector index, -1 for none
+	};
+	struct Thing
+	{
+		int x, y, type;
+	};
+
+	unsigned      size = 0; // Cells per side
+	vector<Line>  lines;
+	vector<Thing> things;
+
+	unsigned nVertices() const { return (size + 1) * (size + 1); }
+	unsigned nSectors() const { return size * size; }
+	int      vertexX(unsigned v) const { return (v % (size + 1)) * 64; }
+	int      vertexY(unsigned v) const { return (v / (size + 1)) * 64; }
+};
+
+// -----------------------------------------------------------------------------
+// Generates a [size]x[size] grid of 64x64 sectors, with a random thing in each
+// -----------------------------------------------------------------------------
+GridMap generateGridMap(unsigned size)
+{
+	GridMap map;
+	map.size = size;
+
+	auto vertex = [size](unsigned x, unsigned y) { return y * (size + 1) + x; };
+	auto sector = [size](unsigned x, unsigned y) { return static_cast<int>(y * size + x); };
+
+	// Horizontal lines (front side is below, or above along the bottom edge)
+	for (unsigned y = 0; y <= size; ++y)
+		for (unsigned x = 0; x < size; ++x)
+		{
+			if (y == 0)
+				map.lines.push_back({ vertex(x + 1, y), vertex(x, y), sector(x, y), -1 });
+			else
+				map.lines.push_back(
+					{ vertex(x, y), vertex(x + 1, y), sector(x, y - 1), y < size ? sector(x, y) : -1 });
+		}
+
+	// Vertical lines (front side is right, or left along the right edge)
+	for (unsigned x = 0; x <= size; ++x)
+		for (unsigned y = 0; y < size; ++y)
+		{
+			if (x == size)
+				map.lines.push_back({ vertex(x, y + 1), vertex(x, y), sector(x - 1, y), -1 });
+			else
+				map.lines.push_back(
+					{ vertex(x, y), vertex(x, y + 1), sector(x, y), x > 0 ? sector(x - 1, y) : -1 });
+		}
+
+	// Things
+	std::mt19937 rng(size);
+	map.things.push_back({ 32, 32, 1 });
+	for (unsigned y = 0; y < size; ++y)
+		for (unsigned x = 0; x < size; ++x)
+		{
+			auto tx = static_cast<int>(x * 64 + 8 + rng() % 48);
+			auto ty = static_cast<int>(y * 64 + 8 + rng() % 48);
+			map.things.push_back({ tx, ty, 3004 });
+		}
+
+	return map;
+}
+
+// -----------------------------------------------------------------------------
+// Appends little-endian 16-bit [value] to [data]
+// -----------------------------------------------------------------------------
+void writeShort(vector<uint8_t>& data, int value)
+{
+	data.push_back(value & 0xFF);
+	data.push_back((value >> 8) & 0xFF);
+}
+
+// -----------------------------------------------------------------------------
+// Appends [name] to [data] as an 8-character lump/texture name
+// -----------------------------------------------------------------------------
+void writeName(vector<uint8_t>& data, string_view name)
+{
+	for (unsigned a = 0; a < 8; ++a)
+		data.push_back(a < name.size() ? name[a] : 0);
+}
+
+// -----------------------------------------------------------------------------
+// Adds [map] to [wad] as binary doom format map [name]
+// -----------------------------------------------------------------------------
+void addDoomMap(WadArchive& wad, const GridMap& map, string_view name)
+{
+	vector<uint8_t> things, lines, sides, vertices, sectors;
+
+	for (const auto& thing : map.things)
+	{
+		writeShort(things, thing.x);
+		writeShort(things, thing.y);
+		writeShort(things, 0);
+		writeShort(things, thing.type);
+		writeShort(things, 7);
+	}
+
+	auto addSide = [&](int sector, bool two_sided)
+	{
+		writeShort(sides, 0);
+		writeShort(sides, 0);
+		writeName(sides, "-");
+		writeName(sides, "-");
+		writeName(sides, two_sided ? "-" : "STARTAN3");
+		writeShort(sides, sector);
+		return static_cast<int>(sides.size() / 30 - 1);
+	};
+	for (const auto& line : map.lines)
+	{
+		bool two_sided = line.back >= 0;
+		int  front     = addSide(line.front, two_sided);
+		int  back      = two_sided ? addSide(line.back, true) : 0xFFFF;
+		writeShort(lines, line.v1);
+		writeShort(lines, line.v2);
+		writeShort(lines, two_sided ? 4 : 1);
+		writeShort(lines, 0);
+		writeShort(lines, 0);
+		writeShort(lines, front);
+		writeShort(lines, back);
+	}
+
+	for (unsigned a = 0; a < map.nVertices(); ++a)
+	{
+		writeShort(vertices, map.vertexX(a));
+		writeShort(vertices, map.vertexY(a));
+	}
+
+	for (unsigned a = 0; a < map.nSectors(); ++a)
+	{
+		writeShort(sectors, 0);
+		writeShort(sectors, 128);
+		writeName(sectors, "FLOOR4_8");
+		writeName(sectors, "CEIL3_5");
+		writeShort(sectors, 160);
+		writeShort(sectors, 0);
+		writeShort(sectors, 0);
+	}
+
+	wad.addNewEntry(name);
+	wad.addNewEntry("THINGS")->importMem(things.data(), things.size());
+	wad.addNewEntry("LINEDEFS")->importMem(lines.data(), lines.size());
+	wad.addNewEntry("SIDEDEFS")->importMem(sides.data(), sides.size());
+	wad.addNewEntry("VERTEXES")->importMem(vertices.data(), vertices.size());
+	wad.addNewEntry("SECTORS")->importMem(sectors.data(), sectors.size());
+}
+
+// -----------------------------------------------------------------------------
+// Adds [map] to [wad] as UDMF format map [name]
+// -----------------------------------------------------------------------------
+void addUDMFMap(WadArchive& wad, const GridMap& map, string_view name)
+{
+	string textmap = "namespace = \"zdoom\";\n";
+
+	for (const auto& thing : map.things)
+		textmap += fmt::format(
+			"thing {{ x = {}.0; y = {}.0; type = {}; skill1 = true; skill2 = true; skill3 = true; "
+			"skill4 = true; skill5 = true; single = true; }}\n",
+			thing.x,
+			thing.y,
+			thing.type);
+
+	unsigned n_sides = 0;
+	string   sides;
+	auto     addSide = [&](int sector, bool two_sided)
+	{
+		if (two_sided)
+			sides += fmt::format("sidedef {{ sector = {}; }}\n", sector);
+		else
+			sides += fmt::format("sidedef {{ sector = {}; texturemiddle = \"STARTAN3\"; }}\n", sector);
+		return n_sides++;
+	};
+	for (const auto& line : map.lines)
+	{
+		bool two_sided = line.back >= 0;
+		auto front     = addSide(line.front, two_sided);
+		if (two_sided)
+			textmap += fmt::format(
+				"linedef {{ v1 = {}; v2 = {}; sidefront = {}; sideback = {}; twosided = true; }}\n",
+				line.v1,
+				line.v2,
+				front,
+				addSide(line.back, true));
+		else
+			textmap += fmt::format(
+				"linedef {{ v1 = {}; v2 = {}; sidefront = {}; blocking = true; }}\n", line.v1, line.v2, front);
+	}
+	textmap += sides;
+
+	for (unsigned a = 0; a < map.nVertices(); ++a)
+		textmap += fmt::format("vertex {{ x = {}.0; y = {}.0; }}\n", map.vertexX(a), map.vertexY(a));
+
+	for (unsigned a = 0; a < map.nSectors(); ++a)
+		textmap += "sector { heightceiling = 128; texturefloor = \"FLOOR4_8\"; textureceiling = \"CEIL3_5\"; "
+				   "lightlevel = 160; }\n";
+
+	wad.addNewEntry(name);
+	wad.addNewEntry("TEXTMAP")->importMem(textmap.data(), textmap.size());
+	wad.addNewEntry("ENDMAP");
+}
+
+// -----------------------------------------------------------------------------
+// Runs read and write benchmarks for [map] of [format] ("doom" or "udmf")
+// -----------------------------------------------------------------------------
+void mapReadWrite(const Archive::MapDesc& map, string_view format, unsigned size, unsigned n_lines)
+{
+	unique_ptr<SLADEMap> slade_map;
+	bench::run(
+		fmt::format("map/{}_read/{}", format, size),
+		n_lines,
+		"lines",
+		[&]
+		{
+			slade_map = std::make_unique<SLADEMap>();
+			slade_map->readMap(map);
+		},
+		[&] { slade_map.reset(); });
+
+	slade_map = std::make_unique<SLADEMap>();
+	slade_map->readMap(map);
+	bench::run(
+		fmt::format("map/{}_write/{}", format, size),
+		n_lines,
+		"lines",
+		[&]
+		{
+			vector<ArchiveEntry*> entries;
+			slade_map->writeMap(entries);
+			for (auto entry : entries)
+				delete entry;
+		});
+}
+
+// -----------------------------------------------------------------------------
+// Runs all standard map checks (except those needing textures) on [map]
+// -----------------------------------------------------------------------------
+void mapChecks(const Archive::MapDesc& map, unsigned n_lines)
+{
+	SLADEMap slade_map;
+	if (!slade_map.readMap(map))
+		return;
+
+	for (int a = 0; a < MapCheck::NumStandardChecks; ++a)
+	{
+		auto type = static_cast<MapCheck::StandardCheck>(a);
+		if (type == MapCheck::UnknownTexture || type == MapCheck::UnknownFlat)
+			continue;
+
+		bench::run(
+			fmt::format("map_check/{}", MapCheck::standardCheckId(type)),
+			n_lines,
+			"lines",
+			[&]
+			{
+				auto check = MapCheck::standardCheck(type, &slade_map);
+				check->doCheck();
+				bench::keep(check->nProblems());
+			});
+	}
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Runs all map benchmarks
+// -----------------------------------------------------------------------------
+void bench::mapBenchmarks()
+{
+	if (!enabled("map"))
+		return;
+
+	// Generate maps
+	WadArchive       wad;
+	vector<unsigned> sizes = { 16, 64 };
+	vector<unsigned> n_lines;
+	for (auto size : sizes)
+	{
+		auto map = generateGridMap(size);
+		addDoomMap(wad, map, fmt::format("MAP{:02d}", size));
+		addUDMFMap(wad, map, fmt::format("MAP{:02d}", size + 1));
+		n_lines.push_back(map.lines.size());
+	}
+
+	// Reopen from written data so the map entries are detected as they would
+	// be for a wad on disk
+	MemChunk data;
+	wad.write(data);
+	WadArchive maps_wad;
+	maps_wad.open(data);
+	auto maps = maps_wad.detectMaps();
+
+	for (auto format : { MapFormat::Doom, MapFormat::UDMF })
+	{
+		auto format_id = format == MapFormat::Doom ? "doom" : "udmf";
+		if (!enabled(fmt::format("map/{}", format_id)) && !enabled("map_check"))
+			continue;
+
+		// Thing types, specials etc. come from the game configuration
+		if (!game::configuration().openConfig("doom2", format == MapFormat::Doom ? "" : "zdoom", format))
+			log::warning("Unable to open doom2 game configuration, map benchmarks will run without it");
+
+		for (unsigned a = 0; a < sizes.size(); ++a)
+		{
+			auto name = fmt::format("MAP{:02d}", format == MapFormat::Doom ? sizes[a] : sizes[a] + 1);
+			auto map  = std::find_if(maps.begin(), maps.end(), [&](const auto& desc) { return desc.name == name; });
+			if (map == maps.end())
+			{
+				log::error("Generated map {} not detected", name);
+				continue;
+			}
+
+			mapReadWrite(*map, format_id, sizes[a], n_lines[a]);
+
+			// Map checks are run once, on the largest UDMF map
+			if (format == MapFormat::UDMF && a == sizes.size() - 1)
+				mapChecks(*map, n_lines[a]);
+		}
+	}
+}
@@ -0,0 +1,113 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    TextBench.cpp
+// Description: Text benchmarks - tokenizer throughput
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Bench.h"
+#include "Utility/Tokenizer.h"
+#include <random>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Generates about [size] bytes of DECORATE-like text: actor definitions with
+// properties, states, strings, numbers and both comment types
+// -----------------------------------------------------------------------------
+string generateDecorate(unsigned size)
+{
+	static const char* sprites[] = { "TROO", "POSS", "SPOS", "HEAD", "BOSS", "SKUL", "CPOS", "FATT" };
+
+	std::mt19937 rng(size);
+	string       text;
+	unsigned     index = 0;
+	while (text.size() < size)
+	{
+		auto sprite = sprites[rng() % 8];
+		text += fmt::format("// Actor {}\nactor BenchActor{} : DoomImp {}\n{{\n", index, index, 20000 + index);
+		text += fmt::format("\tHealth {}\n\tRadius {}\n\tHeight {}\n", rng() % 1000, 16 + rng() % 32, 56);
+		text += fmt::format("\tSpeed {}.{}\n\tPainChance {}\n", rng() % 16, rng() % 100, rng() % 256);
+		text += fmt::format("\tObituary \"%o was killed by bench actor {}.\"\n", index);
+		text += "\t+FLOAT +NOGRAVITY\n\t/* Multi-line\n\t   comment */\n\tstates\n\t{\n";
+		text += fmt::format("\tSpawn:\n\t\t{} AB 10 A_Look\n\t\tloop\n", sprite);
+		text += fmt::format("\tSee:\n\t\t{} AABBCCDD 3 A_Chase\n\t\tloop\n", sprite);
+		text += fmt::format("\tMissile:\n\t\t{} EF 8 A_FaceTarget\n\t\t{} G 6 A_CustomMissile(\"DoomImpBall\", {}, 0)\n"
+							"\t\tgoto See\n",
+							sprite,
+							sprite,
+							rng() % 64);
+		text += fmt::format("\tDeath:\n\t\t{} I 8\n\t\t{} J 8 A_Scream\n\t\t{} K -1\n\t\tstop\n\t}}\n}}\n\n",
+							sprite,
+							sprite,
+							sprite);
+		++index;
+	}
+
+	return text;
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Runs all text benchmarks
+// -----------------------------------------------------------------------------
+void bench::textBenchmarks()
+{
+	if (!enabled("text/tokenizer"))
+		return;
+
+	auto text = generateDecorate(4 * 1024 * 1024);
+	run(
+		"text/tokenizer",
+		text.size(),
+		"bytes",
+		[&]
+		{
+			Tokenizer tz;
+			tz.openString(text);
+			unsigned n_tokens = 0;
+			while (!tz.atEnd())
+			{
+				tz.adv();
+				++n_tokens;
+			}
+			keep(n_tokens);
+		});
+}
@@ -0,0 +1,177 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    CLIMain.cpp
+// Description: Program entry point for slade-cli, a command line tool to run
+//              SLADE operations (scripts, gfx conversion, map checks, etc.)
+//              on archives without the GUI
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "Commands.h"
+#include "General/Jobs.h"
+#include "Utility/FileUtils.h"
+#include "Utility/StringUtils.h"
+#include <wx/init.h>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// CLIApp Class
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// wx needs an application object for its base services (paths, events, etc.),
+// but there is no event loop and the GUI is never initialised
+class CLIApp : public wxAppConsole
+{
+public:
+	int OnRun() override { return 0; }
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Prints usage information for slade-cli
+// -----------------------------------------------------------------------------
+void printUsage()
+{
+	fmt::print("Usage: slade-cli [options] <command> [command args]\n\n");
+	fmt::print("Options:\n");
+	fmt::print("  -j <threads>   Number of worker threads to process files with (default: one per core)\n");
+	fmt::print("  -o <dir>       Write modified archives to <dir> instead of overwriting them\n");
+	fmt::print("  -debug         Enable debug logging\n\n");
+	fmt::print("Commands:\n");
+	for (const auto& cmd : cli::commands())
+		fmt::print("  {} {}\n      {}\n", cmd.name, cmd.usage, cmd.description);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Entry Point
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	// Process global options
+	cli::Options options;
+	unsigned     n_threads = 0;
+	int          arg       = 1;
+	for (; arg < argc; ++arg)
+	{
+		string_view opt = argv[arg];
+		if ((opt == "-j" || opt == "-o") && arg + 1 < argc)
+		{
+			if (opt == "-j")
+				n_threads = std::max(strutil::asInt(argv[++arg]), 0);
+			else
+				options.output_dir = argv[++arg];
+		}
+		else if (strutil::equalCI(opt, "-debug"))
+			global::debug = true;
+		else if (opt == "-h" || opt == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else
+			break;
+	}
+
+	// Get command
+	if (arg >= argc)
+	{
+		printUsage();
+		return 2;
+	}
+	auto command = cli::command(argv[arg]);
+	if (!command)
+	{
+		fmt::print(stderr, "Unknown command \"{}\"\n", argv[arg]);
+		printUsage();
+		return 2;
+	}
+	vector<string> args(argv + arg + 1, argv + argc);
+
+	// Init wx (without the GUI)
+	wxAppConsole::SetInstance(new CLIApp());
+	wxInitializer wx_init(argc, argv);
+	if (!wx_init.IsOk())
+	{
+		fmt::print(stderr, "Failed to initialise wxWidgets\n");
+		return 1;
+	}
+#ifdef __WINDOWS__
+	wxAppConsole::GetInstance()->SetAppName("SLADE3");
+#else
+	wxAppConsole::GetInstance()->SetAppName("slade3");
+#endif
+
+	// Init SLADE
+	if (!app::initHeadless(n_threads))
+	{
+		fmt::print(stderr, "Failed to initialise SLADE, see {}\n", app::path("slade-cli.log", app::Dir::User));
+		return 1;
+	}
+
+	// Create output directory if needed
+	if (!options.output_dir.empty() && !fileutil::dirExists(options.output_dir)
+		&& !fileutil::createDir(options.output_dir))
+	{
+		fmt::print(stderr, "Unable to create output directory \"{}\"\n", options.output_dir);
+		app::exit(false);
+		return 1;
+	}
+
+	// Run command
+	auto result = command->run(args, options);
+	if (result == 2)
+		fmt::print(stderr, "Usage: slade-cli {} {}\n", command->name, command->usage);
+
+	// Finish any jobs the command started before shutting down
+	jobs::waitIdle();
+	app::exit(false);
+
+	return result;
+}
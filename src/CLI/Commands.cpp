@@ -0,0 +1,547 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    Commands.cpp
+// Description: slade-cli commands. Each command processes a list of input
+//              files, in parallel on the job worker threads where possible
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Commands.h"
+#include "App.h"
+#include "Archive/ArchiveManager.h"
+#include "Game/Configuration.h"
+#include "General/Jobs.h"
+#include "General/Misc.h"
+#include "Graphics/PNGOptimizer.h"
+#include "Graphics/Palette/PaletteManager.h"
+#include "MainEditor/GfxConverter.h"
+#include "MapEditor/MapChecks.h"
+#include "SLADEMap/SLADEMap.h"
+#include "Scripting/Lua.h"
+#include "Utility/FileUtils.h"
+#include "Utility/StringUtils.h"
+#include <filesystem>
+#include <mutex>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// External Variables
+//
+// -----------------------------------------------------------------------------
+EXTERN_CVAR(String, game_configuration)
+EXTERN_CVAR(String, port_configuration)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace slade::cli
+{
+std::mutex print_mutex;
+
+// -----------------------------------------------------------------------------
+// Writes a line of [text] to stdout (or stderr if [error] is true).
+// Safe to call from multiple threads
+// -----------------------------------------------------------------------------
+void print(string_view text, bool error = false)
+{
+	std::lock_guard lock(print_mutex);
+	fmt::print(error ? stderr : stdout, "{}\n", text);
+}
+
+// -----------------------------------------------------------------------------
+// Splits command [args] into options (--name value) and positional arguments
+// -----------------------------------------------------------------------------
+void parseArgs(const vector<string>& args, std::map<string, string>& named, vector<string>& positional)
+{
+	for (unsigned a = 0; a < args.size(); ++a)
+	{
+		if (strutil::startsWith(args[a], "--") && a + 1 < args.size())
+		{
+			named[args[a].substr(2)] = args[a + 1];
+			++a;
+		}
+		else
+			positional.push_back(args[a]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Opens the archive [filename] without adding it to the archive manager.
+// Prints an error and returns nullptr if it couldn't be opened
+// -----------------------------------------------------------------------------
+shared_ptr<Archive> openArchive(const string& filename)
+{
+	auto archive = app::archiveManager().openArchive(filename, false, true);
+	if (!archive)
+		print(fmt::format("{}: {}", filename, global::error), true);
+
+	return archive;
+}
+
+// -----------------------------------------------------------------------------
+// Saves [archive], to the output directory if one was given in [options]
+// (otherwise it is overwritten). Prints an error and returns false on failure
+// -----------------------------------------------------------------------------
+bool saveArchive(Archive& archive, const Options& options)
+{
+	bool ok;
+	if (options.output_dir.empty())
+		ok = archive.save();
+	else
+		ok = archive.save(fmt::format("{}/{}", options.output_dir, archive.filename(false)));
+
+	if (!ok)
+		print(fmt::format("{}: Unable to save: {}", archive.filename(), global::error), true);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Runs [process] for each of [files] on the job worker threads.
+// Returns the program exit code (1 if any file failed to process)
+// -----------------------------------------------------------------------------
+int processFiles(const vector<string>& files, const std::function<bool(const string&)>& process)
+{
+	std::atomic<unsigned> n_failed = 0;
+
+	jobs::parallelFor(
+		files.size(),
+		[&](unsigned index)
+		{
+			try
+			{
+				if (!process(files[index]))
+					++n_failed;
+			}
+			catch (const std::exception& ex)
+			{
+				print(fmt::format("{}: {}", files[index], ex.what()), true);
+				++n_failed;
+			}
+		});
+
+	return n_failed > 0 ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Prints any script output logged since [next_message]
+// -----------------------------------------------------------------------------
+void printScriptOutput(uint64_t& next_message)
+{
+	log::flush();
+	for (const auto& msg : log::newMessages(next_message))
+	{
+		if (msg.type == log::MessageType::Script)
+			print(msg.message);
+		else if (msg.type == log::MessageType::Error)
+			print(msg.message, true);
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+// script <script.lua> [files...]
+//
+// Runs a lua script. If any files are given, they are opened as archives and
+// the script's Execute(archive) function is called for each one in turn
+// (scripts aren't thread-safe, so these are never run in parallel)
+// -----------------------------------------------------------------------------
+int runScript(const vector<string>& args, const Options& options)
+{
+#ifdef NO_LUA
+	print("This build of SLADE doesn't support scripting", true);
+	return 1;
+#else
+	if (args.empty())
+		return 2;
+
+	uint64_t next_message = 0;
+	log::flush();
+	log::newMessages(next_message);
+
+	// No files, just run the script
+	if (args.size() == 1)
+	{
+		bool ok = lua::runFile(args[0]);
+		printScriptOutput(next_message);
+		return ok ? 0 : 1;
+	}
+
+	string script;
+	if (!fileutil::readFileToString(args[0], script))
+	{
+		print(fmt::format("Unable to read script file \"{}\"", args[0]), true);
+		return 1;
+	}
+
+	int result = 0;
+	for (unsigned a = 1; a < args.size(); ++a)
+	{
+		auto archive = openArchive(args[a]);
+		if (!archive)
+		{
+			result = 1;
+			continue;
+		}
+
+		if (!lua::runArchiveScript(script, archive.get()))
+			result = 1;
+
+		printScriptOutput(next_message);
+		jobs::processMainThreadQueue();
+	}
+
+	return result;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// convert <format> [--pixel paletted|truecolour|alphamap] [--match <pattern>]
+//         <files...>
+//
+// Converts all graphics entries (or those with names matching [pattern]) in
+// each archive to the image [format]
+// -----------------------------------------------------------------------------
+int convertGfx(const vector<string>& args, const Options& options)
+{
+	std::map<string, string> named;
+	vector<string>           files;
+	parseArgs(args, named, files);
+	if (files.size() < 2)
+		return 2;
+
+	auto format = SIFormat::getFormat(files[0]);
+	if (format == SIFormat::unknownFormat())
+	{
+		print(fmt::format("Unknown image format \"{}\"", files[0]), true);
+		return 2;
+	}
+	files.erase(files.begin());
+
+	// Get pixel format to convert to
+	SIFormat::ConvertOptions opt;
+	opt.col_format = format->canWriteType(SImage::Type::PalMask) ? SImage::Type::PalMask : SImage::Type::RGBA;
+	if (auto pixel = named.find("pixel"); pixel != named.end())
+	{
+		if (strutil::equalCI(pixel->second, "truecolour") || strutil::equalCI(pixel->second, "truecolor"))
+			opt.col_format = SImage::Type::RGBA;
+		else if (strutil::equalCI(pixel->second, "alphamap"))
+			opt.col_format = SImage::Type::AlphaMap;
+		else if (strutil::equalCI(pixel->second, "paletted"))
+			opt.col_format = SImage::Type::PalMask;
+	}
+	if (!format->canWriteType(opt.col_format))
+	{
+		print(fmt::format("Format \"{}\" can't be written with that pixel format", format->name()), true);
+		return 2;
+	}
+	auto match = named.count("match") ? named["match"] : "*";
+
+	return processFiles(
+		files,
+		[&](const string& filename)
+		{
+			auto archive = openArchive(filename);
+			if (!archive)
+				return false;
+
+			// Use the archive's palette if it has one
+			Palette palette(*app::paletteManager()->globalPalette());
+			misc::loadPaletteFromArchive(&palette, archive.get());
+			auto entry_opt        = opt;
+			entry_opt.pal_current = &palette;
+			entry_opt.pal_target  = &palette;
+
+			// Convert all matching gfx entries
+			vector<ArchiveEntry*> entries;
+			archive->putEntryTreeAsList(entries);
+			GfxConverter converter;
+			for (auto entry : entries)
+				if (entry->type()->editor() == "gfx" && strutil::matchesCI(entry->name(), match))
+					converter.addEntry(entry, format, entry_opt, &palette);
+			converter.run();
+
+			for (unsigned a = 0; a < converter.numItems(); ++a)
+			{
+				const auto& item = converter.item(a);
+				if (!item.error.empty())
+					print(fmt::format("{}: {}: {}", filename, item.entry->path(true), item.error), true);
+			}
+
+			auto count = converter.applyToEntries();
+			print(fmt::format("{}: Converted {} of {} entries", filename, count, converter.numItems()));
+
+			return count == 0 || saveArchive(*archive, options);
+		});
+}
+
+// -----------------------------------------------------------------------------
+// optimize <files...>
+//
+// Losslessly optimizes all PNG entries in each archive
+// -----------------------------------------------------------------------------
+int optimizePNGs(const vector<string>& args, const Options& options)
+{
+	if (args.empty())
+		return 2;
+
+	return processFiles(
+		args,
+		[&](const string& filename)
+		{
+			auto archive = openArchive(filename);
+			if (!archive)
+				return false;
+
+			vector<ArchiveEntry*> entries;
+			archive->putEntryTreeAsList(entries);
+
+			unsigned n_optimized = 0;
+			size_t   old_size    = 0;
+			size_t   new_size    = 0;
+			MemChunk out;
+			for (auto entry : entries)
+			{
+				if (entry->type()->id() != "png")
+					continue;
+
+				gfx::PNGOptStats stats;
+				if (gfx::optimizePNG(entry->data(), out, &stats))
+				{
+					entry->importMemChunk(out);
+					old_size += stats.old_size;
+					new_size += stats.new_size;
+					++n_optimized;
+				}
+			}
+
+			print(fmt::format(
+				"{}: Optimized {} PNG entries, saved {} bytes", filename, n_optimized, old_size - new_size));
+
+			return n_optimized == 0 || saveArchive(*archive, options);
+		});
+}
+
+// -----------------------------------------------------------------------------
+// check [--game <id>] [--port <id>] [--checks <id,id,...>] <files...>
+//
+// Runs map checks on all maps in each archive, printing any problems found.
+// Archives are opened in parallel, but maps are checked one at a time since
+// game configuration lookups aren't thread-safe. Texture/flat checks need a
+// GL context so they aren't available here
+// -----------------------------------------------------------------------------
+int checkMaps(const vector<string>& args, const Options& options)
+{
+	std::map<string, string> named;
+	vector<string>           files;
+	parseArgs(args, named, files);
+	if (files.empty())
+		return 2;
+
+	auto game = named.count("game") ? named["game"] : game_configuration.value;
+	auto port = named.count("port") ? named["port"] : port_configuration.value;
+	if (game.empty())
+	{
+		print("No game configuration given (use --game <id>)", true);
+		return 2;
+	}
+
+	// Determine checks to run
+	vector<MapCheck::StandardCheck> checks;
+	if (auto ids = named.find("checks"); ids != named.end())
+	{
+		for (const auto& id : strutil::split(ids->second, ','))
+		{
+			bool found = false;
+			for (int a = 0; a < MapCheck::NumStandardChecks; ++a)
+			{
+				auto type = static_cast<MapCheck::StandardCheck>(a);
+				if (MapCheck::standardCheckId(type) == id)
+				{
+					checks.push_back(type);
+					found = true;
+				}
+			}
+			if (!found)
+			{
+				print(fmt::format("Unknown map check \"{}\"", id), true);
+				return 2;
+			}
+		}
+	}
+	else
+	{
+		for (int a = 0; a < MapCheck::NumStandardChecks; ++a)
+			checks.push_back(static_cast<MapCheck::StandardCheck>(a));
+	}
+	checks.erase(
+		std::remove_if(
+			checks.begin(),
+			checks.end(),
+			[](MapCheck::StandardCheck type)
+			{ return type == MapCheck::UnknownTexture || type == MapCheck::UnknownFlat; }),
+		checks.end());
+
+	// Open all archives
+	vector<shared_ptr<Archive>> archives(files.size());
+	jobs::parallelFor(files.size(), [&](unsigned index) { archives[index] = openArchive(files[index]); });
+
+	// Check maps
+	int      result     = 0;
+	bool     config_ok  = false;
+	auto     cfg_format = MapFormat::Unknown;
+	unsigned n_problems = 0;
+	for (unsigned a = 0; a < files.size(); ++a)
+	{
+		if (!archives[a])
+		{
+			result = 1;
+			continue;
+		}
+
+		for (const auto& map_desc : archives[a]->detectMaps())
+		{
+			// Load the game configuration for the map format if needed
+			if (!config_ok || map_desc.format != cfg_format)
+			{
+				cfg_format = map_desc.format;
+				config_ok  = game::configuration().openConfig(game, port, cfg_format);
+				if (!config_ok)
+				{
+					print(fmt::format("Unable to load game configuration \"{}\" (port \"{}\")", game, port), true);
+					return 1;
+				}
+			}
+
+			SLADEMap map;
+			if (!map.readMap(map_desc))
+			{
+				print(fmt::format("{}: {}: Unable to read map", files[a], map_desc.name), true);
+				result = 1;
+				continue;
+			}
+
+			for (auto type : checks)
+			{
+				auto check = MapCheck::standardCheck(type, &map);
+				check->doCheck();
+				for (unsigned p = 0; p < check->nProblems(); ++p)
+					print(fmt::format("{}: {}: {}", files[a], map_desc.name, check->problemDesc(p)));
+				n_problems += check->nProblems();
+			}
+		}
+
+		archives[a].reset();
+		jobs::processMainThreadQueue();
+	}
+
+	print(fmt::format("{} problems found", n_problems));
+
+	return n_problems > 0 ? 1 : result;
+}
+
+// -----------------------------------------------------------------------------
+// repack <files...>
+//
+// Rewrites each archive (recompressing zip entries, dropping unused space in
+// wads, etc.)
+// -----------------------------------------------------------------------------
+int repackArchives(const vector<string>& args, const Options& options)
+{
+	if (args.empty())
+		return 2;
+
+	return processFiles(
+		args,
+		[&](const string& filename)
+		{
+			auto archive = openArchive(filename);
+			if (!archive)
+				return false;
+
+			std::error_code error;
+			auto            old_size = std::filesystem::file_size(filename, error);
+			if (!saveArchive(*archive, options))
+				return false;
+
+			auto new_size = std::filesystem::file_size(archive->filename(), error);
+			print(fmt::format("{}: Repacked, {} -> {} bytes", filename, old_size, new_size));
+			return true;
+		});
+}
+
+// clang-format off
+vector<Command> command_list = {
+	{ "script",   "<script.lua> [files...]",
+	  "Runs a lua script, calling its Execute(archive) function for each file if any are given",
+	  &runScript },
+	{ "convert",  "<format> [--pixel paletted|truecolour|alphamap] [--match <pattern>] <files...>",
+	  "Converts all graphics entries in each file to an image format",
+	  &convertGfx },
+	{ "optimize", "<files...>",
+	  "Losslessly optimizes all PNG entries in each file",
+	  &optimizePNGs },
+	{ "check",    "[--game <id>] [--port <id>] [--checks <id,id,...>] <files...>",
+	  "Runs map checks on all maps in each file, exits with 1 if any problems are found",
+	  &checkMaps },
+	{ "repack",   "<files...>",
+	  "Rewrites each file",
+	  &repackArchives },
+};
+// clang-format on
+} // namespace slade::cli
+
+// -----------------------------------------------------------------------------
+// Returns a list of all commands
+// -----------------------------------------------------------------------------
+const vector<cli::Command>& cli::commands()
+{
+	return command_list;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the command with [name], or nullptr if there is none
+// -----------------------------------------------------------------------------
+const cli::Command* cli::command(string_view name)
+{
+	for (const auto& cmd : command_list)
+		if (cmd.name == name)
+			return &cmd;
+
+	return nullptr;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace slade::cli
+{
+struct Options
+{
+	string output_dir; // If set, modified archives are written here instead of being overwritten
+};
+
+struct Command
+{
+	string_view name;
+	string_view usage;
+	string_view description;
+	int (*run)(const vector<string>& args, const Options& options);
+};
+
+const vector<Command>& commands();
+const Command*         command(string_view name);
+} // namespace slade::cli
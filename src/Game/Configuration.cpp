@@ -44,7 +44,9 @@
 #include "Decorate.h"
 #include "GenLineSpecial.h"
 #include "General/Console.h"
+#include "General/Misc.h"
 #include "SLADEMap/SLADEMap.h"
+#include "Utility/FileUtils.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
 #include "ZScript.h"
@@ -61,6 +63,64 @@ using namespace game;
 EXTERN_CVAR(String, game_configuration)
 EXTERN_CVAR(String, port_configuration)
 CVAR(Bool, debug_configuration, false, CVar::Flag::Save)
+CVAR(Bool, game_config_cache, true, CVar::Flag::Save)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the path to the parse tree cache file for configuration text [cfg]
+// parsed with [define] set
+// -----------------------------------------------------------------------------
+string configCachePath(string_view cfg, string_view define)
+{
+	auto hash = misc::hash64(reinterpret_cast<const uint8_t*>(cfg.data()), cfg.size());
+	hash ^= misc::hash64(reinterpret_cast<const uint8_t*>(define.data()), define.size()) * 31;
+	return app::path(fmt::format("config_cache/{:016x}.bin", hash), app::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Parses configuration text [cfg] into [parser], which should already have
+// [define] set. If the parse tree for the same text and define was cached
+// previously it is loaded from the cache instead of parsing, otherwise it is
+// parsed and written to the cache
+// -----------------------------------------------------------------------------
+void parseConfig(Parser& parser, string_view cfg, string_view source, string_view define)
+{
+	if (!game_config_cache)
+	{
+		parser.parseText(cfg, source);
+		return;
+	}
+
+	auto     start = app::runTimer();
+	auto     path  = configCachePath(cfg, define);
+	MemChunk cached;
+	if (fileutil::fileExists(path) && cached.importFile(path) && parser.readBinary(cached))
+	{
+		log::info(2, "Loaded cached configuration {} in {}ms", source, app::runTimer() - start);
+		return;
+	}
+
+	// Not cached (or invalid), parse it
+	if (!parser.parseText(cfg, source))
+		return;
+
+	// Write to cache
+	auto dir = app::path("config_cache", app::Dir::User);
+	if (!fileutil::dirExists(dir) && !fileutil::createDir(dir))
+		return;
+	MemChunk mc;
+	parser.writeBinary(mc);
+	if (!mc.exportFile(path))
+		log::warning("Unable to write configuration cache file {}", path);
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -551,20 +611,24 @@ bool Configuration::readConfiguration(
 		udmf_sector_props_.clear();
 		udmf_thing_props_.clear();
 		tt_group_defaults_.clear();
+		parsed_types_.clear();
+		version_++;
 	}
 
 	// Parse the full configuration
-	Parser parser;
+	Parser      parser;
+	string_view define;
 	switch (format)
 	{
-	case MapFormat::Doom: parser.define("MAP_DOOM"); break;
-	case MapFormat::Hexen: parser.define("MAP_HEXEN"); break;
-	case MapFormat::Doom64: parser.define("MAP_DOOM64"); break;
-	case MapFormat::Doom32X: parser.define("MAP_DOOM32X"); break;
-	case MapFormat::UDMF: parser.define("MAP_UDMF"); break;
-	default: parser.define("MAP_UNKNOWN"); break;
+	case MapFormat::Doom: define = "MAP_DOOM"; break;
+	case MapFormat::Hexen: define = "MAP_HEXEN"; break;
+	case MapFormat::Doom64: define = "MAP_DOOM64"; break;
+	case MapFormat::Doom32X: define = "MAP_DOOM32X"; break;
+	case MapFormat::UDMF: define = "MAP_UDMF"; break;
+	default: define = "MAP_UNKNOWN"; break;
 	}
-	parser.parseText(cfg, source);
+	parser.define(define);
+	parseConfig(parser, cfg, source, define);
 
 	// Process parsed data
 	auto base = parser.parseTreeRoot();
@@ -1399,14 +1463,20 @@ bool Configuration::parseMapInfo(const Archive& archive)
 // -----------------------------------------------------------------------------
 void Configuration::linkDoomEdNums()
 {
+	// Index MAPINFO editor numbers by (lowercase) actor class, lowest first
+	std::unordered_map<string, int> class_ednums;
+	for (const auto& i : map_info_.doomEdNums())
+		class_ednums.emplace(strutil::lower(i.second.actor_class), i.first);
+
 	for (auto& parsed : parsed_types_)
 	{
 		// Find MAPINFO editor number for parsed actor class
-		int ednum = map_info_.doomEdNumForClass(parsed.className());
+		auto found = class_ednums.find(strutil::lower(parsed.className()));
 
-		if (ednum >= 0)
+		if (found != class_ednums.end())
 		{
 			// Editor number found, copy the definition to thing types map
+			int ednum = found->second;
 			thing_types_[ednum].define(ednum, parsed.name(), parsed.group());
 			thing_types_[ednum].copy(parsed);
 			log::info(2, "Linked parsed class {} to DoomEdNum {}", parsed.className(), ednum);
@@ -1414,6 +1484,17 @@ void Configuration::linkDoomEdNums()
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Restores thing types and *MAPINFO definitions from [state], previously saved
+// with customDefsState()
+// -----------------------------------------------------------------------------
+void Configuration::restoreCustomDefsState(const CustomDefsState& state)
+{
+	thing_types_  = state.thing_types;
+	parsed_types_ = state.parsed_types;
+	map_info_     = state.map_info;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the name of the line flag at [index]
 // -----------------------------------------------------------------------------
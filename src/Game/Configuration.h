@@ -72,10 +72,20 @@ namespace game
 			string sky2;
 		};
 
+		// Everything modified by parsing custom (DECORATE/ZScript/*MAPINFO)
+		// definitions, so it can be saved and restored without reparsing
+		struct CustomDefsState
+		{
+			std::map<int, ThingType> thing_types;
+			vector<ThingType>        parsed_types;
+			MapInfo                  map_info;
+		};
+
 		Configuration();
 		~Configuration() = default;
 
 		void          setDefaults();
+		unsigned      version() const { return version_; }
 		const string& currentGame() const { return current_game_; }
 		const string& currentPort() const { return current_port_; }
 		bool          supportsSectorFlags() const { return boom_sector_flag_start_ > 0; }
@@ -145,6 +155,10 @@ namespace game
 		void clearMapInfo() { map_info_.clear(); }
 		void linkDoomEdNums();
 
+		// Custom definitions state
+		CustomDefsState customDefsState() const { return { thing_types_, parsed_types_, map_info_ }; }
+		void            restoreCustomDefsState(const CustomDefsState& state);
+
 		// Line flags
 		unsigned    nLineFlags() const { return flags_line_.size(); }
 		const Flag& lineFlag(unsigned flag_index);
@@ -200,6 +214,7 @@ namespace game
 		void dumpUDMFProperties();
 
 	private:
+		unsigned                  version_ = 0;            // Incremented each time a configuration is read
 		string                    current_game_;           // Current game name
 		string                    current_port_;           // Current port name (empty if none)
 		std::map<MapFormat, bool> map_formats_;            // Supported map formats
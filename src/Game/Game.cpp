@@ -41,11 +41,12 @@
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "Configuration.h"
+#include "General/Jobs.h"
+#include "General/Misc.h"
 #include "TextEditor/TextLanguage.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
 #include "ZScript.h"
-#include <thread>
 
 using namespace slade;
 using namespace game;
@@ -65,7 +66,31 @@ std::map<string, PortDef> port_defs;
 PortDef                   port_def_unknown;
 zscript::Definitions      zscript_base;
 zscript::Definitions      zscript_custom;
-unique_ptr<std::thread>   zscript_parse_thread;
+
+// Custom definitions parsed from each resource archive. Each source holds the
+// definitions parsed from it and all sources before it, so that only changed
+// archives (and any after them) need to be reparsed
+struct CustomDefsSource
+{
+	const Archive*                 archive = nullptr;
+	uint64_t                       hash    = 0;
+	zscript::Definitions           zscript;
+	Configuration::CustomDefsState defs;
+};
+vector<CustomDefsSource>       custom_defs_sources;
+Configuration::CustomDefsState custom_defs_initial;
+unsigned                       custom_defs_config_version = 0;
+bool                           custom_defs_valid          = false;
+
+// Cached data hashes of text entries, so unchanged entries don't need to be
+// loaded and rehashed on every update
+struct EntryDataHash
+{
+	weak_ptr<ArchiveEntry> entry;
+	unsigned               version = 0;
+	uint64_t               hash    = 0;
+};
+std::unordered_map<const ArchiveEntry*, EntryDataHash> entry_data_hashes;
 } // namespace slade::game
 CVAR(String, game_configuration, "", CVar::Flag::Save)
 CVAR(String, port_configuration, "", CVar::Flag::Save)
@@ -236,38 +261,126 @@ Configuration& game::configuration()
 	return config_current;
 }
 
+namespace
+{
 // -----------------------------------------------------------------------------
-// Clears and re-parses custom definitions in all open archives
-// (DECORATE, *MAPINFO, ZScript etc.)
+// Returns the hash of [entry]'s data, reusing the cached hash if the entry
+// hasn't been modified since it was last hashed
 // -----------------------------------------------------------------------------
-void game::updateCustomDefinitions()
+uint64_t entryDataHash(const shared_ptr<ArchiveEntry>& entry)
 {
-	// Clear out all existing custom definitions
-	config_current.clearDecorateDefs();
-	config_current.clearMapInfo();
-	zscript_custom.clear();
-
-	// Parse custom definitions in base resource
-	auto base_resource = app::archiveManager().baseResourceArchive();
-	if (base_resource)
+	auto& cached = entry_data_hashes[entry.get()];
+	if (cached.entry.lock() != entry || cached.version != entry->dataVersion())
 	{
-		zscript_custom.parseZScript(base_resource);
-		config_current.parseDecorateDefs(base_resource);
-		config_current.parseMapInfo(*base_resource);
+		cached.entry   = entry;
+		cached.version = entry->dataVersion();
+		cached.hash    = entry->data().hash();
 	}
 
-	// Parse custom definitions in all resource archives
-	auto resource_archives = app::archiveManager().allArchives(true);
+	return cached.hash;
+}
 
-	// ZScript first
-	for (const auto& archive : resource_archives)
-		zscript_custom.parseZScript(archive.get());
+// -----------------------------------------------------------------------------
+// Returns a hash of the paths and data of all text entries in [archive], which
+// is where any custom definitions would be read from
+// -----------------------------------------------------------------------------
+uint64_t customDefsHash(const Archive& archive)
+{
+	vector<shared_ptr<ArchiveEntry>> entries;
+	ArchiveDir::entryTreeAsList(archive.rootDir().get(), entries);
 
-	// Other definitions
-	for (const auto& archive : resource_archives)
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto     mix  = [&hash](uint64_t value) { hash = (hash ^ value) * 0x100000001b3ULL; };
+	for (const auto& entry : entries)
 	{
-		config_current.parseDecorateDefs(archive.get());
-		config_current.parseMapInfo(*archive);
+		if (entry->type()->formatId() != "text")
+			continue;
+
+		auto path = entry->path(true);
+		mix(misc::hash64(reinterpret_cast<const uint8_t*>(path.data()), path.size()));
+		mix(entryDataHash(entry));
+	}
+
+	return hash;
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Updates custom definitions from all open resource archives
+// (DECORATE, *MAPINFO, ZScript etc.).
+// Parsed definitions are cached per archive, keyed by a hash of its text
+// entries. Parsing resumes from the first archive that was added, removed or
+// changed since the last update, so opening/closing an archive or saving an
+// entry only reparses that archive and the ones after it
+// -----------------------------------------------------------------------------
+void game::updateCustomDefinitions()
+{
+	auto start = app::runTimer();
+
+	// Get archives to parse (base resource first)
+	vector<Archive*> archives;
+	if (auto base_resource = app::archiveManager().baseResourceArchive())
+		archives.push_back(base_resource);
+	for (const auto& archive : app::archiveManager().allArchives(true))
+		archives.push_back(archive.get());
+
+	// If the game configuration was (re)loaded since the last update, all
+	// cached definitions are out of date
+	if (!custom_defs_valid || config_current.version() != custom_defs_config_version)
+	{
+		custom_defs_sources.clear();
+		config_current.clearMapInfo();
+		custom_defs_initial        = config_current.customDefsState();
+		custom_defs_config_version = config_current.version();
+		custom_defs_valid          = true;
+	}
+
+	// Drop cached hashes of entries that no longer exist
+	for (auto i = entry_data_hashes.begin(); i != entry_data_hashes.end();)
+		i = i->second.entry.expired() ? entry_data_hashes.erase(i) : std::next(i);
+
+	// Find the first archive that differs from the cached sources
+	vector<uint64_t> hashes;
+	for (auto* archive : archives)
+		hashes.push_back(customDefsHash(*archive));
+	unsigned first_changed = 0;
+	while (first_changed < archives.size() && first_changed < custom_defs_sources.size()
+		   && custom_defs_sources[first_changed].archive == archives[first_changed]
+		   && custom_defs_sources[first_changed].hash == hashes[first_changed])
+		first_changed++;
+
+	// Nothing changed
+	if (first_changed == archives.size() && first_changed == custom_defs_sources.size())
+		return;
+
+	// Restore definitions parsed from unchanged archives
+	custom_defs_sources.resize(first_changed);
+	if (first_changed > 0)
+	{
+		zscript_custom = custom_defs_sources.back().zscript;
+		config_current.restoreCustomDefsState(custom_defs_sources.back().defs);
+	}
+	else
+	{
+		zscript_custom.clear();
+		config_current.restoreCustomDefsState(custom_defs_initial);
+	}
+
+	// Parse definitions in changed archives. All ZScript is parsed before any
+	// DECORATE/*MAPINFO, so each stage is cached separately
+	for (auto a = first_changed; a < archives.size(); ++a)
+	{
+		zscript_custom.parseZScript(archives[a]);
+		custom_defs_sources.push_back({ archives[a], 0, zscript_custom, {} });
+	}
+	for (auto a = first_changed; a < archives.size(); ++a)
+	{
+		config_current.parseDecorateDefs(archives[a]);
+		config_current.parseMapInfo(*archives[a]);
+		custom_defs_sources[a].defs = config_current.customDefsState();
+
+		// Rehash, since parsing sets the type of any #included entries
+		custom_defs_sources[a].hash = customDefsHash(*archives[a]);
 	}
 
 	// Process custom definitions
@@ -280,6 +393,13 @@ void game::updateCustomDefinitions()
 		lang->clearCustomDefs();
 		lang->loadZScript(zscript_custom, true);
 	}
+
+	log::info(
+		2,
+		"Updated custom definitions from {} of {} archives in {}ms",
+		archives.size() - first_changed,
+		archives.size(),
+		app::runTimer() - start);
 }
 
 // -----------------------------------------------------------------------------
@@ -320,16 +440,12 @@ TagType game::parseTagged(ParseTreeNode* tagged)
 }
 
 // -----------------------------------------------------------------------------
-// Game related initialisation (read basic definitions, etc.)
+// Reads basic game and port definitions from the user dir and program
+// resource. This doesn't touch the current configuration, so can be run on a
+// worker thread (eg. at startup), but must be done before init
 // -----------------------------------------------------------------------------
-void game::init()
+void game::loadDefinitions()
 {
-	// Init static ThingTypes
-	ThingType::initGlobal();
-
-	// Init static ActionSpecials
-	ActionSpecial::initGlobal();
-
 	// Add game configurations from user dir
 	wxArrayString allfiles;
 	wxDir::GetAllFiles(app::path("games", app::Dir::User), &allfiles);
@@ -409,6 +525,19 @@ void game::init()
 			}
 		}
 	}
+}
+
+// -----------------------------------------------------------------------------
+// Game related initialisation (open last configuration, custom definitions,
+// etc.). Basic definitions must be loaded first with loadDefinitions
+// -----------------------------------------------------------------------------
+void game::init()
+{
+	// Init static ThingTypes
+	ThingType::initGlobal();
+
+	// Init static ActionSpecials
+	ActionSpecial::initGlobal();
 
 	// Load last configuration if any
 	if (!game_configuration.value.empty())
@@ -418,35 +547,50 @@ void game::init()
 	if (!loadCustomSpecialPresets())
 		log::warning("An error occurred loading user special_presets.cfg");
 
-	// Load zdoom.pk3 stuff
+	// Load zdoom.pk3 stuff. The archive is opened and its ZScript parsed on a
+	// worker thread, then handed over to the main thread to apply, since
+	// config_current and the ZScript language are only used from there
 	if (wxFileExists(zdoom_pk3_path))
 	{
-		zscript_parse_thread = std::make_unique<std::thread>([=]() {
-			ZipArchive zdoom_pk3;
-			if (!zdoom_pk3.open(zdoom_pk3_path))
-				return;
-
-			// ZScript
-			auto zscript_entry = zdoom_pk3.entryAtPath("zscript.txt");
+		struct ZDoomDefs
+		{
+			unique_ptr<ZipArchive> archive;
+			zscript::Definitions   zscript;
+		};
 
-			if (!zscript_entry)
+		jobs::run(
+			[path = zdoom_pk3_path.value]()
 			{
-				// Bail out if no entry is found.
-				log::warning(1, "Could not find \'zscript.txt\' in " + zdoom_pk3_path);
-			}
-			else
+				ZDoomDefs defs;
+				auto      archive = std::make_unique<ZipArchive>();
+				if (!archive->open(path))
+					return defs;
+
+				// ZScript
+				auto zscript_entry = archive->entryAtPath("zscript.txt");
+				if (!zscript_entry)
+				{
+					// Bail out if no entry is found.
+					log::warning(1, "Could not find \'zscript.txt\' in " + path);
+					return defs;
+				}
+				defs.zscript.parseZScript(zscript_entry);
+				defs.archive = std::move(archive);
+
+				return defs;
+			},
+			[](ZDoomDefs defs)
 			{
-				zscript_base.parseZScript(zscript_entry);
+				if (!defs.archive)
+					return;
 
-				auto lang = TextLanguage::fromId("zscript");
-				if (lang)
+				zscript_base = std::move(defs.zscript);
+				if (auto lang = TextLanguage::fromId("zscript"))
 					lang->loadZScript(zscript_base);
 
 				// MapInfo
-				config_current.parseMapInfo(zdoom_pk3);
-			}
-		});
-		zscript_parse_thread->detach();
+				config_current.parseMapInfo(*defs.archive);
+			});
 	}
 
 	// Update custom definitions when an archive is opened or closed
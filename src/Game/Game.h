@@ -82,6 +82,7 @@ namespace game
 	};
 
 	// General
+	void loadDefinitions();
 	void init();
 
 	// Basic Game/Port Definitions
@@ -766,40 +766,11 @@ void Class::inherit(const Class& parent)
 	db_properties_      = parent.db_properties_;
 }
 
-// ----------------------------------------------------------------------------
-// Adds this class as a ThingType to [parsed], or updates an existing ThingType
-// definition in [types] or [parsed]
-// ----------------------------------------------------------------------------
-void Class::toThingType(std::map<int, game::ThingType>& types, vector<game::ThingType>& parsed)
+// -----------------------------------------------------------------------------
+// Applies this class' DB comment and default properties to ThingType [def]
+// -----------------------------------------------------------------------------
+void Class::toThingType(game::ThingType& def) const
 {
-	// Find existing definition
-	game::ThingType* def = nullptr;
-
-	// Check types with ednums first
-	for (auto& type : types)
-		if (strutil::equalCI(name_, type.second.className()))
-		{
-			def = &type.second;
-			break;
-		}
-	if (!def)
-	{
-		// Check all parsed types
-		for (auto& type : parsed)
-			if (strutil::equalCI(name_, type.className()))
-			{
-				def = &type;
-				break;
-			}
-	}
-
-	// Create new type if it didn't exist
-	if (!def)
-	{
-		parsed.emplace_back(name_, "ZScript", name_);
-		def = &parsed.back();
-	}
-
 	// Set properties from DB comments
 	auto   title = name_;
 	string group = "ZScript";
@@ -810,10 +781,10 @@ void Class::toThingType(std::map<int, game::ThingType>& types, vector<game::Thin
 		else if (strutil::equalCI(prop.first, "Group") || strutil::equalCI(prop.first, "Category"))
 			group = "ZScript/" + prop.second;
 	}
-	def->define(def->number(), title, group);
+	def.define(def.number(), title, group);
 
 	// Set properties from defaults section
-	def->loadProps(default_properties_, true, true);
+	def.loadProps(default_properties_, true, true);
 }
 
 // -----------------------------------------------------------------------------
@@ -1064,8 +1035,28 @@ bool Definitions::parseZScript(Archive* archive)
 // -----------------------------------------------------------------------------
 void Definitions::exportThingTypes(std::map<int, game::ThingType>& types, vector<game::ThingType>& parsed)
 {
+	// Index existing definitions by (lowercase) class name, types with ednums
+	// taking priority over parsed types. Reserve space for any new parsed
+	// types up front so the indexed pointers stay valid
+	parsed.reserve(parsed.size() + classes_.size());
+	std::unordered_map<string, game::ThingType*> existing;
+	for (auto& type : types)
+		existing.emplace(strutil::lower(type.second.className()), &type.second);
+	for (auto& type : parsed)
+		existing.emplace(strutil::lower(type.className()), &type);
+
 	for (auto& cdef : classes_)
-		cdef.toThingType(types, parsed);
+	{
+		// Find existing definition, or create a new one if it didn't exist
+		auto& def = existing[strutil::lower(cdef.name())];
+		if (!def)
+		{
+			parsed.emplace_back(cdef.name(), "ZScript", cdef.name());
+			def = &parsed.back();
+		}
+
+		cdef.toThingType(*def);
+	}
 }
 
 
@@ -160,7 +160,7 @@ namespace zscript
 		bool parse(ParsedStatement& class_statement, const vector<Class>& parsed_classes);
 		bool extend(ParsedStatement& block);
 		void inherit(const Class& parent);
-		void toThingType(std::map<int, game::ThingType>& types, vector<game::ThingType>& parsed);
+		void toThingType(game::ThingType& def) const;
 		bool isMixin() const { return is_mixin_; }
 
 	private:
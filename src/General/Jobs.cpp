@@ -0,0 +1,591 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    Jobs.cpp
+// Description: Background job scheduler. Runs jobs on a pool of work-stealing
+//              worker threads, with results handed back to the main thread
+//              via a completion queue processed from the wx event loop
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Jobs.h"
+#include "App.h"
+#include "General/Console.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, jobs_max_threads, 0, CVar::Flag::Save)
+
+namespace slade::jobs
+{
+// Each worker has its own task queue. Workers take tasks from the back of
+// their own queue, and steal from the front of others' when it is empty
+struct WorkerQueue
+{
+	std::mutex                        mutex;
+	std::deque<std::function<void()>> tasks;
+};
+
+vector<unique_ptr<WorkerQueue>> queues;
+vector<std::thread>             workers;
+std::mutex                      pool_mutex; // Guards starting/stopping the pool
+std::mutex                      wake_mutex;
+std::condition_variable         wake_cv;
+unsigned                        n_pending    = 0; // Queued tasks not yet taken by a worker (guarded by wake_mutex)
+std::atomic<unsigned>           n_active     = 0; // Tasks queued or running
+bool                            stopping     = false;
+std::atomic<unsigned>           next_queue   = 0;
+std::atomic<unsigned>           n_workers    = 0;
+thread_local int                worker_index = -1;
+
+// Main thread completion queue
+std::mutex                    main_mutex;
+vector<std::function<void()>> main_queue;
+std::atomic<bool>             main_wake_pending = false;
+} // namespace slade::jobs
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace slade::jobs
+{
+// -----------------------------------------------------------------------------
+// Runs [task], logging (rather than propagating) any exception it throws
+// -----------------------------------------------------------------------------
+void runTask(const std::function<void()>& task)
+{
+	try
+	{
+		task();
+	}
+	catch (const std::exception& ex)
+	{
+		log::error("Exception in background job: {}", ex.what());
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Takes the next task for worker [index] from its own queue, or steals one
+// from another worker's queue. Returns false if all queues are empty
+// -----------------------------------------------------------------------------
+bool takeTask(unsigned index, std::function<void()>& task)
+{
+	{
+		auto&           own = *queues[index];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for (unsigned a = 1; a < queues.size(); ++a)
+	{
+		auto&           victim = *queues[(index + a) % queues.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread loop
+// -----------------------------------------------------------------------------
+void workerLoop(unsigned index)
+{
+	worker_index = static_cast<int>(index);
+
+	while (true)
+	{
+		// Wait for a task to be queued, and reserve it
+		{
+			std::unique_lock lock(wake_mutex);
+			wake_cv.wait(lock, [] { return stopping || n_pending > 0; });
+			if (stopping)
+				return;
+			--n_pending;
+		}
+
+		// The reserved task is in one of the queues, though another worker may
+		// take it first (in which case the one it reserved will be there)
+		std::function<void()> task;
+		while (!takeTask(index, task))
+			std::this_thread::yield();
+
+		runTask(task);
+		--n_active;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Starts the worker threads if they aren't already running
+// -----------------------------------------------------------------------------
+void ensureStarted()
+{
+	if (n_workers == 0)
+		init();
+}
+} // namespace slade::jobs
+
+// -----------------------------------------------------------------------------
+// Starts [n_threads] worker threads (0 = the jobs_max_threads cvar, or one per
+// core if that is 0 too). Does nothing if the workers are already running
+// -----------------------------------------------------------------------------
+void jobs::init(unsigned n_threads)
+{
+	std::lock_guard lock(pool_mutex);
+	if (!workers.empty())
+		return;
+
+	if (n_threads == 0)
+		n_threads = jobs_max_threads > 0 ? static_cast<unsigned>(jobs_max_threads) : std::thread::hardware_concurrency();
+	n_threads = std::max(n_threads, 1u);
+
+	stopping = false;
+	for (unsigned a = 0; a < n_threads; ++a)
+		queues.push_back(std::make_unique<WorkerQueue>());
+	n_workers = n_threads;
+	for (unsigned a = 0; a < n_threads; ++a)
+		workers.emplace_back(workerLoop, a);
+
+	log::info(2, "Started {} job worker threads", n_threads);
+}
+
+// -----------------------------------------------------------------------------
+// Stops all worker threads, waiting for any running tasks to finish. Tasks
+// that haven't started yet are discarded, as are any pending main thread
+// completions
+// -----------------------------------------------------------------------------
+void jobs::shutdown()
+{
+	std::lock_guard pool_lock(pool_mutex);
+	if (workers.empty())
+		return;
+
+	{
+		std::lock_guard lock(wake_mutex);
+		stopping = true;
+	}
+	wake_cv.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+
+	workers.clear();
+	queues.clear();
+	n_pending = 0;
+	n_active  = 0;
+	n_workers = 0;
+
+	std::lock_guard main_lock(main_mutex);
+	main_queue.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of worker threads
+// -----------------------------------------------------------------------------
+unsigned jobs::nThreads()
+{
+	ensureStarted();
+	return n_workers;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the calling thread is a job worker thread
+// -----------------------------------------------------------------------------
+bool jobs::isWorkerThread()
+{
+	return worker_index >= 0;
+}
+
+// -----------------------------------------------------------------------------
+// Queues [task] to run on a worker thread. Tasks queued from a worker go to
+// its own queue (so related tasks tend to run on the same thread), otherwise
+// they are distributed between the workers
+// -----------------------------------------------------------------------------
+void jobs::submit(std::function<void()> task)
+{
+	ensureStarted();
+
+	++n_active;
+	auto index = worker_index >= 0 ? static_cast<unsigned>(worker_index) : next_queue++ % n_workers;
+	{
+		std::lock_guard lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard lock(wake_mutex);
+		++n_pending;
+	}
+	wake_cv.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+// Queues [task] to run on the main thread, and wakes up the wx event loop to
+// process it if there is one
+// -----------------------------------------------------------------------------
+void jobs::runOnMainThread(std::function<void()> task)
+{
+	{
+		std::lock_guard lock(main_mutex);
+		main_queue.push_back(std::move(task));
+	}
+
+	// CallAfter is safe to use from any thread (it queues an event). Headless
+	// (console) apps have no event loop, so must process the queue themselves
+	auto app = wxAppConsole::GetInstance();
+	if (app && !app::isHeadless() && !main_wake_pending.exchange(true))
+		app->CallAfter([] { processMainThreadQueue(); });
+}
+
+// -----------------------------------------------------------------------------
+// Runs all tasks queued for the main thread, returning the number run.
+// Must be called from the main thread
+// -----------------------------------------------------------------------------
+unsigned jobs::processMainThreadQueue()
+{
+	main_wake_pending = false;
+
+	vector<std::function<void()>> tasks;
+	{
+		std::lock_guard lock(main_mutex);
+		tasks.swap(main_queue);
+	}
+
+	for (const auto& task : tasks)
+		runTask(task);
+
+	return tasks.size();
+}
+
+// -----------------------------------------------------------------------------
+// Blocks until all queued and running tasks have finished, running any main
+// thread completions (which may queue more tasks) as they come in.
+// Must be called from the main thread
+// -----------------------------------------------------------------------------
+void jobs::waitIdle()
+{
+	while (true)
+	{
+		auto idle = n_active == 0;
+		if (processMainThreadQueue() == 0 && idle)
+			return;
+
+		if (!idle)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Runs [fn] for every index in [0, count) on the worker threads.
+// The calling thread also processes indices unless it needs to report
+// progress (and it isn't a worker itself, which could otherwise deadlock if
+// all workers were waiting on nested loops)
+// -----------------------------------------------------------------------------
+bool jobs::parallelFor(
+	unsigned                             count,
+	const std::function<void(unsigned)>& fn,
+	const std::function<bool(unsigned)>& progress,
+	unsigned                             max_threads)
+{
+	if (count == 0)
+		return true;
+
+	struct State
+	{
+		std::atomic<unsigned>   next      = 0;
+		std::atomic<bool>       cancelled = false;
+		unsigned                done      = 0;
+		std::mutex              mutex;
+		std::condition_variable done_cv;
+	};
+	auto state = std::make_shared<State>();
+
+	// Helper tasks that only start after all indices have been taken exit
+	// without touching [fn], so it is fine for them to outlive this call
+	auto work = [state, &fn, count]()
+	{
+		for (auto index = state->next++; index < count; index = state->next++)
+		{
+			if (!state->cancelled)
+				runTask([&fn, index] { fn(index); });
+
+			std::lock_guard lock(state->mutex);
+			++state->done;
+			state->done_cv.notify_all();
+		}
+	};
+
+	auto n_threads   = std::min(max_threads > 0 ? max_threads : nThreads(), count);
+	bool participate = !progress || isWorkerThread();
+	for (unsigned a = participate ? 1 : 0; a < n_threads; ++a)
+		submit(work);
+
+	if (participate)
+		work();
+
+	// Wait for all indices to be done, reporting progress if needed
+	unsigned reported = 0;
+	while (true)
+	{
+		{
+			std::unique_lock lock(state->mutex);
+			state->done_cv.wait_for(lock, std::chrono::milliseconds(50), [&] { return state->done != reported; });
+			reported = state->done;
+		}
+
+		if (progress && !state->cancelled && !progress(reported))
+		{
+			// Skip any indices not started yet
+			state->cancelled = true;
+			work();
+		}
+
+		if (reported == count)
+			break;
+	}
+
+	return !state->cancelled;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TaskGraph Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Adds a task [name] that runs [fn] once all tasks in [deps] have finished
+// (these must already have been added, so there can't be any cycles).
+// Returns the id of the task, to use as a dependency of later tasks
+// -----------------------------------------------------------------------------
+jobs::TaskGraph::TaskId jobs::TaskGraph::add(
+	string_view           name,
+	std::function<bool()> fn,
+	const vector<TaskId>& deps,
+	bool                  main_thread)
+{
+	tasks_.push_back({ string{ name }, std::move(fn), deps, main_thread });
+	return tasks_.size() - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Runs all tasks, each starting as soon as its dependencies have finished.
+// Worker thread tasks are submitted to the pool, while main thread tasks are
+// run here in between checking for progress. Returns false if any task failed
+// -----------------------------------------------------------------------------
+bool jobs::TaskGraph::run(const ProgressFn& progress)
+{
+	using clock = std::chrono::steady_clock;
+
+	enum class Status
+	{
+		Waiting,
+		Running,
+		Done,
+		Failed
+	};
+	struct State
+	{
+		std::mutex              mutex;
+		std::condition_variable cv;
+		vector<Status>          status;
+		vector<unsigned>        n_waiting;  // Number of unfinished dependencies of each task
+		std::deque<TaskId>      main_ready; // Main thread tasks ready to run
+		unsigned                n_finished = 0;
+		bool                    failed     = false;
+	};
+
+	unsigned n_tasks = tasks_.size();
+	if (n_tasks == 0)
+		return true;
+
+	auto state = std::make_shared<State>();
+	state->status.resize(n_tasks, Status::Waiting);
+	state->n_waiting.resize(n_tasks);
+	vector<vector<TaskId>> dependents(n_tasks);
+	for (TaskId id = 0; id < n_tasks; ++id)
+	{
+		state->n_waiting[id] = tasks_[id].deps.size();
+		for (auto dep : tasks_[id].deps)
+			dependents[dep].push_back(id);
+	}
+
+	// Runs task [id], returning true if it succeeded
+	auto execute = [this](TaskId id)
+	{
+		auto& task  = tasks_[id];
+		auto  start = clock::now();
+		bool  ok    = false;
+		try
+		{
+			ok = task.fn();
+		}
+		catch (const std::exception& ex)
+		{
+			log::error("Exception in task \"{}\": {}", task.name, ex.what());
+		}
+
+		auto ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		if (ok)
+			log::info(2, "Task \"{}\" finished in {:.0f}ms", task.name, ms);
+		else
+			log::error("Task \"{}\" failed after {:.0f}ms", task.name, ms);
+
+		return ok;
+	};
+
+	// Both of these must be called with state->mutex locked
+	std::function<void(TaskId)>       start;
+	std::function<void(TaskId, bool)> finish;
+
+	// Marks task [id] as finished and starts any dependents that are now ready
+	finish = [&](TaskId id, bool ok)
+	{
+		state->status[id] = ok ? Status::Done : Status::Failed;
+		state->failed |= !ok;
+		++state->n_finished;
+
+		for (auto dependent : dependents[id])
+			if (--state->n_waiting[dependent] == 0)
+				start(dependent);
+
+		state->cv.notify_all();
+	};
+
+	// Starts task [id], or skips it if any of its dependencies failed
+	start = [&](TaskId id)
+	{
+		for (auto dep : tasks_[id].deps)
+			if (state->status[dep] == Status::Failed)
+			{
+				log::warning("Skipping task \"{}\" since \"{}\" failed", tasks_[id].name, tasks_[dep].name);
+				finish(id, false);
+				return;
+			}
+
+		state->status[id] = Status::Running;
+		if (tasks_[id].main_thread)
+			state->main_ready.push_back(id);
+		else
+			submit(
+				[state, id, &execute, &finish]
+				{
+					bool            ok = execute(id);
+					std::lock_guard lock(state->mutex);
+					finish(id, ok);
+				});
+	};
+
+	// Start all tasks without dependencies
+	{
+		std::lock_guard lock(state->mutex);
+		for (TaskId id = 0; id < n_tasks; ++id)
+			if (tasks_[id].deps.empty())
+				start(id);
+	}
+
+	while (true)
+	{
+		std::optional<TaskId> main_task;
+		unsigned              n_finished;
+		vector<string>        running;
+		{
+			std::unique_lock lock(state->mutex);
+			state->cv.wait_for(
+				lock,
+				std::chrono::milliseconds(50),
+				[&] { return !state->main_ready.empty() || state->n_finished == n_tasks; });
+
+			if (!state->main_ready.empty())
+			{
+				main_task = state->main_ready.front();
+				state->main_ready.pop_front();
+			}
+
+			n_finished = state->n_finished;
+			for (TaskId id = 0; id < n_tasks; ++id)
+				if (state->status[id] == Status::Running)
+					running.push_back(tasks_[id].name);
+		}
+
+		if (progress)
+			progress(n_finished, n_tasks, running);
+
+		if (main_task)
+		{
+			bool            ok = execute(*main_task);
+			std::lock_guard lock(state->mutex);
+			finish(*main_task, ok);
+		}
+		else if (n_finished == n_tasks)
+			break;
+	}
+
+	return !state->failed;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+CONSOLE_COMMAND(jobs_info, 0, false)
+{
+	std::lock_guard lock(jobs::wake_mutex);
+	log::console(wxString::Format("%u worker threads, %u queued tasks", jobs::n_workers.load(), jobs::n_pending));
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+
+namespace slade::jobs
+{
+// Cancellation token for a job. Copies share the same state, so cancelling
+// any copy cancels the job. A cancelled job's main thread completion is never
+// called, and long-running jobs can check cancelled() to stop early
+class Token
+{
+public:
+	Token() : cancelled_{ std::make_shared<std::atomic<bool>>(false) } {}
+
+	void cancel() const { *cancelled_ = true; }
+	bool cancelled() const { return *cancelled_; }
+
+private:
+	std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+// Scheduler
+void     init(unsigned n_threads = 0);
+void     shutdown();
+unsigned nThreads();
+bool     isWorkerThread();
+
+// Queues [task] to run on a worker thread
+void submit(std::function<void()> task);
+
+// Queues [task] to run on the main thread. With a wx event loop running the
+// queue is processed automatically, otherwise processMainThreadQueue must be
+// called periodically
+void     runOnMainThread(std::function<void()> task);
+unsigned processMainThreadQueue();
+
+// Blocks until no tasks are queued or running, processing the main thread
+// queue meanwhile (for apps without an event loop). Must be called from the
+// main thread
+void waitIdle();
+
+// Runs [fn] for every index in [0, count) on the worker threads (using at
+// most [max_threads], 0 = all), blocking until all are done.
+// If [progress] is given it is called on the calling thread roughly every
+// 50ms with the number of indices done, and returning false from it cancels
+// any that haven't started yet. Returns false if cancelled
+bool parallelFor(
+	unsigned                             count,
+	const std::function<void(unsigned)>& fn,
+	const std::function<bool(unsigned)>& progress    = {},
+	unsigned                             max_threads = 0);
+
+// A set of named tasks with dependencies between them. When run, each task
+// starts as soon as all the tasks it depends on have finished, so independent
+// tasks run concurrently on the worker threads. Tasks added with [main_thread]
+// set run on the thread that calls run() instead (for anything touching the UI)
+class TaskGraph
+{
+public:
+	using TaskId = unsigned;
+
+	// Called with the number of tasks finished, the total number of tasks and
+	// the names of the tasks currently running
+	using ProgressFn = std::function<void(unsigned, unsigned, const vector<string>&)>;
+
+	TaskId add(string_view name, std::function<bool()> fn, const vector<TaskId>& deps = {}, bool main_thread = false);
+	TaskId addMain(string_view name, std::function<bool()> fn, const vector<TaskId>& deps = {})
+	{
+		return add(name, std::move(fn), deps, true);
+	}
+
+	// Runs all tasks, blocking until they are done. A task that returns false
+	// (or throws) fails, and any tasks depending on it are skipped.
+	// [progress] is called on the calling thread roughly every 50ms and after
+	// each task finishes. Returns false if any task failed
+	bool run(const ProgressFn& progress = {});
+
+private:
+	struct Task
+	{
+		string                name;
+		std::function<bool()> fn;
+		vector<TaskId>        deps;
+		bool                  main_thread = false;
+	};
+
+	vector<Task> tasks_;
+};
+
+// Runs [fn] on a worker thread, returning a future for its result
+template<typename F> auto async(F fn) -> std::future<std::invoke_result_t<F>>
+{
+	using R = std::invoke_result_t<F>;
+
+	auto task   = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+	auto result = task->get_future();
+	submit([task] { (*task)(); });
+
+	return result;
+}
+
+// Runs [fn] on a worker thread, then [on_complete] on the main thread with its
+// result (if any). If [token] is cancelled before [fn] starts it is skipped,
+// and if it is cancelled before [on_complete] runs that is skipped, so it is
+// safe for [on_complete] to reference an object that cancels [token] when it
+// is destroyed on the main thread
+template<typename F, typename C> void run(F fn, C on_complete, Token token = {})
+{
+	using R = std::invoke_result_t<F>;
+
+	submit(
+		[fn, on_complete, token]() mutable
+		{
+			if (token.cancelled())
+				return;
+
+			if constexpr (std::is_void_v<R>)
+			{
+				fn();
+				runOnMainThread(
+					[on_complete, token]() mutable
+					{
+						if (!token.cancelled())
+							on_complete();
+					});
+			}
+			else
+			{
+				auto result = std::make_shared<R>(fn());
+				runOnMainThread(
+					[on_complete, token, result]() mutable
+					{
+						if (!token.cancelled())
+							on_complete(std::move(*result));
+					});
+			}
+		});
+}
+} // namespace slade::jobs
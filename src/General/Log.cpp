@@ -36,9 +36,15 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "App.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 using namespace slade;
 
@@ -48,12 +54,113 @@ using namespace slade;
 // Variables
 //
 // -----------------------------------------------------------------------------
+CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
+CVAR(Int, log_history_max, 10000, CVar::Flag::Save)
+CVAR(Int, log_rate_limit, 50, CVar::Flag::Save)
+
 namespace slade::log
 {
-vector<Message> log;
-std::ofstream   log_file;
+// Message waiting to be written by the log writer thread
+struct QueuedMessage
+{
+	string      text;
+	MessageType type = MessageType::Info;
+	time_t      time = 0;
+};
+
+// Bounded lock-free queue that messages are passed through from any number of
+// logging threads to the writer thread. Each slot has a sequence number that
+// says whether it is free to write to or ready to read from
+class MessageQueue
+{
+public:
+	MessageQueue(unsigned capacity) : slots_{ new Slot[capacity] }, mask_{ capacity - 1 }
+	{
+		for (unsigned a = 0; a < capacity; ++a)
+			slots_[a].sequence.store(a, std::memory_order_relaxed);
+	}
+
+	// Adds [msg] to the queue, returns false if it is full (can be called from
+	// any thread)
+	bool push(QueuedMessage& msg)
+	{
+		auto  pos = head_.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true)
+		{
+			slot      = &slots_[pos & mask_];
+			auto seq  = slot->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = head_.load(std::memory_order_relaxed);
+		}
+
+		slot->message = std::move(msg);
+		slot->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Takes the next message from the queue into [msg], returns false if it is
+	// empty (must only be called from one thread at a time)
+	bool pop(QueuedMessage& msg)
+	{
+		auto& slot = slots_[tail_ & mask_];
+		auto  seq  = slot.sequence.load(std::memory_order_acquire);
+		if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(tail_ + 1) < 0)
+			return false;
+
+		msg = std::move(slot.message);
+		slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+		++tail_;
+		return true;
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		QueuedMessage       message;
+	};
+
+	unique_ptr<Slot[]>  slots_;
+	size_t              mask_;
+	std::atomic<size_t> head_ = 0;
+	size_t              tail_ = 0;
+};
+
+// Per-callsite message rate limit (callsites are hashed into a fixed table,
+// so a few may share a limit)
+struct RateLimit
+{
+	std::atomic<int64_t>  second     = 0;
+	std::atomic<int>      count      = 0;
+	std::atomic<unsigned> suppressed = 0;
+};
+
+constexpr unsigned QUEUE_SIZE       = 4096; // Must be a power of 2
+constexpr unsigned RATE_LIMIT_SLOTS = 256;
+
+std::deque<Message>     history_list;
+uint64_t                history_start = 0; // Index of the first message in history_list
+std::mutex              history_mutex;     // Guards history_list and writing to the log file
+std::ofstream           log_file;
+MessageQueue            queue{ QUEUE_SIZE };
+std::thread             writer_thread;
+std::atomic<bool>       writer_running = false;
+std::atomic<bool>       writer_waiting = false;
+std::atomic<uint64_t>   n_queued       = 0;
+std::atomic<uint64_t>   n_written      = 0;
+std::mutex              writer_mutex;
+std::condition_variable writer_cv;
+RateLimit               rate_limits[RATE_LIMIT_SLOTS];
 } // namespace slade::log
-CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
 
 
 // -----------------------------------------------------------------------------
@@ -118,6 +225,139 @@ string log::Message::formattedMessageLine() const
 }
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace slade::log
+{
+// -----------------------------------------------------------------------------
+// Adds [msg] to the history and writes it to the log file.
+// history_mutex must be locked
+// -----------------------------------------------------------------------------
+void addToHistory(QueuedMessage& msg)
+{
+	history_list.emplace_back(msg.text, msg.type, *std::localtime(&msg.time));
+	auto max = static_cast<size_t>(std::max<int>(log_history_max, 100));
+	while (history_list.size() > max)
+	{
+		history_list.pop_front();
+		++history_start;
+	}
+
+	if (log_file.is_open() && msg.type != MessageType::Console)
+		sf::err() << history_list.back().formattedMessageLine() << "\n";
+}
+
+// -----------------------------------------------------------------------------
+// Writes all queued messages, returning the number written.
+// history_mutex must be locked (this also makes it the only thread taking
+// messages from the queue)
+// -----------------------------------------------------------------------------
+unsigned writeQueuedLocked()
+{
+	unsigned      count = 0;
+	QueuedMessage msg;
+	while (queue.pop(msg))
+	{
+		addToHistory(msg);
+		++count;
+	}
+
+	// Flush once per batch rather than every message
+	if (count > 0)
+		sf::err().flush();
+
+	n_written += count;
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// Writes all queued messages, returning the number written
+// -----------------------------------------------------------------------------
+unsigned writeQueued()
+{
+	std::lock_guard lock(history_mutex);
+	return writeQueuedLocked();
+}
+
+// -----------------------------------------------------------------------------
+// Log writer thread loop
+// -----------------------------------------------------------------------------
+void writerLoop()
+{
+	while (writer_running)
+	{
+		if (writeQueued() > 0)
+			continue;
+
+		// Nothing to write, wait for more messages
+		std::unique_lock lock(writer_mutex);
+		writer_waiting = true;
+		writer_cv.wait_for(lock, std::chrono::milliseconds(50));
+		writer_waiting = false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Queues [text] to be added to the log by the writer thread, or adds it
+// directly if the writer thread isn't running
+// -----------------------------------------------------------------------------
+void queueMessage(MessageType type, string text)
+{
+	QueuedMessage msg{ std::move(text), type, std::time(nullptr) };
+
+	if (!writer_running)
+	{
+		std::lock_guard lock(history_mutex);
+		addToHistory(msg);
+		sf::err().flush();
+		return;
+	}
+
+	// Wait for the writer if the queue is full
+	while (!queue.push(msg))
+		std::this_thread::yield();
+	++n_queued;
+
+	if (writer_waiting)
+		writer_cv.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+// Checks the rate limit for messages logged from [callsite] (the format
+// string), returning false if the message should be dropped.
+// If any messages were dropped in the previous second, logs how many first
+// -----------------------------------------------------------------------------
+bool checkRateLimit(const char* callsite)
+{
+	if (log_rate_limit <= 0)
+		return true;
+
+	using namespace std::chrono;
+
+	auto&   limit  = rate_limits[(reinterpret_cast<uintptr_t>(callsite) >> 2) % RATE_LIMIT_SLOTS];
+	int64_t now    = duration_cast<seconds>(steady_clock::now().time_since_epoch()).count();
+	auto    second = limit.second.load();
+	if (second != now && limit.second.compare_exchange_strong(second, now))
+	{
+		limit.count = 0;
+		if (auto suppressed = limit.suppressed.exchange(0))
+			queueMessage(
+				MessageType::Warning,
+				fmt::format("{} repeated log messages suppressed (more than {} per second)", suppressed, *log_rate_limit));
+	}
+
+	if (++limit.count <= log_rate_limit)
+		return true;
+
+	++limit.suppressed;
+	return false;
+}
+} // namespace slade::log
+
+
 // -----------------------------------------------------------------------------
 //
 // Log Namespace Functions
@@ -126,12 +366,14 @@ string log::Message::formattedMessageLine() const
 
 
 // -----------------------------------------------------------------------------
-// Initialises the log file and logging stuff
+// Initialises the log file ([filename] in the user directory) and logging
+// stuff. If [append] is true, the log is added to the end of the file rather
+// than replacing it
 // -----------------------------------------------------------------------------
-void log::init()
+void log::init(string_view filename, bool append)
 {
 	// Redirect sf::err output to the log file
-	log_file.open(app::path("slade3.log", app::Dir::User));
+	log_file.open(app::path(filename, app::Dir::User), append ? std::ios::app : std::ios::out);
 	sf::err().rdbuf(log_file.rdbuf());
 
 	// Write logfile header
@@ -160,14 +402,89 @@ void log::init()
 
 	// Set up FreeImage to use our log:
 	FreeImage_SetOutputMessage(FreeImageErrorHandler);
+
+	// Start writer thread
+	writer_running = true;
+	writer_thread  = std::thread(writerLoop);
+}
+
+// -----------------------------------------------------------------------------
+// Stops the log writer thread, after writing any messages still queued.
+// Anything logged afterwards is written immediately
+// -----------------------------------------------------------------------------
+void log::close()
+{
+	if (!writer_running)
+		return;
+
+	writer_running = false;
+	writer_cv.notify_one();
+	writer_thread.join();
+	writeQueued();
+}
+
+// -----------------------------------------------------------------------------
+// Waits until all messages logged so far (from any thread) have been added to
+// the history and written to the log file
+// -----------------------------------------------------------------------------
+void log::flush()
+{
+	auto target = n_queued.load();
+	while (writer_running && n_written < target)
+	{
+		writer_cv.notify_one();
+		std::this_thread::yield();
+	}
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Writes all queued messages to the history and log file on the calling
+// thread, without relying on the writer thread (which may never run again
+// when handling a crash). Returns false if the history couldn't be locked
+// within a short time, eg. if the crashed thread was holding it, in which case
+// the history shouldn't be read either
 // -----------------------------------------------------------------------------
-const vector<log::Message>& log::history()
+bool log::drain()
 {
-	return log;
+	std::unique_lock lock(history_mutex, std::defer_lock);
+	for (int attempt = 0; !lock.try_lock(); ++attempt)
+	{
+		if (attempt == 100)
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	writeQueuedLocked();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all messages in the log history from index [next] onwards, and sets
+// [next] to the index after the last one. Messages that are no longer in the
+// (size-limited) history are skipped
+// -----------------------------------------------------------------------------
+vector<log::Message> log::newMessages(uint64_t& next)
+{
+	std::lock_guard lock(history_mutex);
+
+	vector<Message> list;
+	auto            first = std::max(next, history_start) - history_start;
+	for (auto a = first; a < history_list.size(); ++a)
+		list.push_back(history_list[a]);
+	next = history_start + history_list.size();
+
+	return list;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the last [count] messages in the log history
+// -----------------------------------------------------------------------------
+vector<log::Message> log::lastMessages(unsigned count)
+{
+	std::lock_guard lock(history_mutex);
+
+	auto first = history_list.size() > count ? history_list.size() - count : 0;
+	return { history_list.begin() + first, history_list.end() };
 }
 
 // -----------------------------------------------------------------------------
@@ -192,36 +509,47 @@ void log::setVerbosity(int verbosity)
 // -----------------------------------------------------------------------------
 void log::message(MessageType type, string_view text)
 {
-	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console) {
-		sf::err() << log.back().formattedMessageLine() << "\n";
-		sf::err().flush();
-	}
+	queueMessage(type, string{ text });
 }
 
+// -----------------------------------------------------------------------------
+// Logs a message of [type] at verbosity [level], formatted from [text] and
+// [args]. The message is only formatted if it will actually be logged, and
+// messages from the same [text] are rate limited
+// -----------------------------------------------------------------------------
 void log::message(MessageType type, int level, string_view text, fmt::format_args args)
 {
-	message(type, level, fmt::vformat(text, args));
+	if (level > log_verbosity || !checkRateLimit(text.data()))
+		return;
+
+	queueMessage(type, fmt::vformat(text, args));
 }
 
+// -----------------------------------------------------------------------------
+// Logs a message of [type], formatted from [text] and [args]. Messages from the
+// same [text] are rate limited
+// -----------------------------------------------------------------------------
 void log::message(MessageType type, string_view text, fmt::format_args args)
 {
-	message(type, fmt::vformat(text, args));
+	if (!checkRateLimit(text.data()))
+		return;
+
+	queueMessage(type, fmt::vformat(text, args));
 }
 
 // -----------------------------------------------------------------------------
 // Returns a list of log messages of [type] that have been recorded since [time]
 // -----------------------------------------------------------------------------
-vector<log::Message*> log::since(time_t time, MessageType type)
+vector<log::Message> log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
-	for (auto& msg : log)
+	flush();
+
+	std::lock_guard lock(history_mutex);
+
+	vector<Message> list;
+	for (auto& msg : history_list)
 		if (mktime(&msg.timestamp) >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -263,11 +591,5 @@ void log::message(MessageType type, int level, string_view text)
 	if (level > log_verbosity)
 		return;
 
-	// Add log message
-	auto t = std::time(nullptr);
-	log.emplace_back(text, type, *std::localtime(&t));
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console)
-		sf::err() << log.back().formattedMessageLine() << "\n";
+	queueMessage(type, string{ text });
 }
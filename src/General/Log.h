@@ -29,15 +29,19 @@ namespace log
 		string formattedMessageLine() const;
 	};
 
-	const vector<Message>& history();
-	int                    verbosity();
-	void                   setVerbosity(int verbosity);
-	void                   init();
-	void                   message(MessageType type, int level, string_view text);
-	void                   message(MessageType type, string_view text);
-	void                   message(MessageType type, int level, string_view text, fmt::format_args args);
-	void                   message(MessageType type, string_view text, fmt::format_args args);
-	vector<Message*>       since(time_t time, MessageType type = MessageType::Any);
+	int             verbosity();
+	void            setVerbosity(int verbosity);
+	void            init(string_view filename = "slade3.log", bool append = false);
+	void            close();
+	void            flush();
+	bool            drain();
+	void            message(MessageType type, int level, string_view text);
+	void            message(MessageType type, string_view text);
+	void            message(MessageType type, int level, string_view text, fmt::format_args args);
+	void            message(MessageType type, string_view text, fmt::format_args args);
+	vector<Message> newMessages(uint64_t& next);
+	vector<Message> lastMessages(unsigned count);
+	vector<Message> since(time_t time, MessageType type = MessageType::Any);
 
 
 	// Message shortcuts by type
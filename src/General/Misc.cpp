@@ -508,6 +508,22 @@ uint32_t misc::crc(const uint8_t* buf, uint32_t len)
 	return update_crc(0xffffffffL, buf, len) ^ 0xffffffffL;
 }
 
+// -----------------------------------------------------------------------------
+// Returns a 64-bit FNV-1a hash of the bytes buf[0..len-1], for identifying
+// data by content where a CRC is too collision-prone
+// -----------------------------------------------------------------------------
+uint64_t misc::hash64(const uint8_t* buf, uint32_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (uint32_t a = 0; a < len; ++a)
+	{
+		hash ^= buf[a];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
 
 // -----------------------------------------------------------------------------
 // Find the given name in a texture lump and returns a point2_t which contains
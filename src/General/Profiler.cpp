@@ -0,0 +1,296 @@
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    Profiler.cpp
+// Description: Lightweight scoped-zone profiler. Zones (see PROFILE_SCOPE) are
+//              recorded into a ring buffer per thread while capturing, and can
+//              be exported in the Chrome trace event JSON format (viewable in
+//              chrome://tracing or https://ui.perfetto.dev)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "Profiler.h"
+#include "App.h"
+#include "General/Console.h"
+#include "General/Jobs.h"
+#include "Utility/FileUtils.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, profiler_zones_per_thread, 65536, CVar::Flag::Save)
+
+namespace slade::profiler
+{
+std::atomic<bool> capture_enabled = false;
+
+struct ZoneRecord
+{
+	const char* name;
+	int64_t     start;
+	int64_t     end;
+};
+
+// Zones recorded on a single thread. The zones are a ring buffer, so only the
+// most recent zones are kept if a capture goes on for too long
+struct ThreadBuffer
+{
+	unsigned           id;
+	string             name;
+	std::mutex         mutex; // Only contended while exporting
+	vector<ZoneRecord> zones;
+	size_t             count = 0; // Total number of zones recorded
+};
+
+vector<shared_ptr<ThreadBuffer>>      thread_buffers;
+std::mutex                            thread_buffers_mutex;
+thread_local shared_ptr<ThreadBuffer> thread_buffer;
+int64_t                               capture_start = 0;
+} // namespace slade::profiler
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace slade::profiler
+{
+// -----------------------------------------------------------------------------
+// Returns the zone buffer for the current thread, creating it if needed
+// -----------------------------------------------------------------------------
+ThreadBuffer& threadBuffer()
+{
+	if (!thread_buffer)
+	{
+		thread_buffer = std::make_shared<ThreadBuffer>();
+		thread_buffer->zones.resize(std::max<int>(profiler_zones_per_thread, 1024));
+
+		std::lock_guard lock(thread_buffers_mutex);
+		thread_buffer->id = thread_buffers.size() + 1;
+		if (std::this_thread::get_id() == app::mainThreadId())
+			thread_buffer->name = "Main";
+		else if (jobs::isWorkerThread())
+			thread_buffer->name = fmt::format("Job Worker {}", thread_buffer->id);
+		else
+			thread_buffer->name = fmt::format("Thread {}", thread_buffer->id);
+		thread_buffers.push_back(thread_buffer);
+	}
+
+	return *thread_buffer;
+}
+
+// -----------------------------------------------------------------------------
+// Returns [str] escaped for use in a JSON string
+// -----------------------------------------------------------------------------
+string jsonEscape(string_view str)
+{
+	string escaped;
+	for (auto c : str)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		if (static_cast<unsigned char>(c) >= 0x20)
+			escaped += c;
+	}
+	return escaped;
+}
+} // namespace slade::profiler
+
+// -----------------------------------------------------------------------------
+// Returns the current profiler time, in nanoseconds
+// -----------------------------------------------------------------------------
+int64_t profiler::now()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------------------------------------------------------------------
+// Records a zone [name] from [start] to [end] for the current thread
+// -----------------------------------------------------------------------------
+void profiler::record(const char* name, int64_t start, int64_t end)
+{
+	auto&           buffer = threadBuffer();
+	std::lock_guard lock(buffer.mutex);
+	buffer.zones[buffer.count % buffer.zones.size()] = { name, start, end };
+	++buffer.count;
+}
+
+// -----------------------------------------------------------------------------
+// Starts a new capture, clearing any previously recorded zones.
+// Returns false if already capturing
+// -----------------------------------------------------------------------------
+bool profiler::start()
+{
+	if (capturing())
+		return false;
+
+	clear();
+	capture_start   = now();
+	capture_enabled = true;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Stops capturing zones
+// -----------------------------------------------------------------------------
+void profiler::stop()
+{
+	capture_enabled = false;
+}
+
+// -----------------------------------------------------------------------------
+// Clears all recorded zones
+// -----------------------------------------------------------------------------
+void profiler::clear()
+{
+	std::lock_guard lock(thread_buffers_mutex);
+	for (auto& buffer : thread_buffers)
+	{
+		std::lock_guard buffer_lock(buffer->mutex);
+		buffer->count = 0;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of zones currently recorded (on all threads)
+// -----------------------------------------------------------------------------
+unsigned profiler::nZones()
+{
+	std::lock_guard lock(thread_buffers_mutex);
+
+	size_t count = 0;
+	for (auto& buffer : thread_buffers)
+	{
+		std::lock_guard buffer_lock(buffer->mutex);
+		count += std::min(buffer->count, buffer->zones.size());
+	}
+	return static_cast<unsigned>(count);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the name shown for the current thread in exported traces
+// -----------------------------------------------------------------------------
+void profiler::setThreadName(string_view name)
+{
+	auto&           buffer = threadBuffer();
+	std::lock_guard lock(buffer.mutex);
+	buffer.name = name;
+}
+
+// -----------------------------------------------------------------------------
+// Writes all recorded zones to [filename] in the Chrome trace event JSON format
+// -----------------------------------------------------------------------------
+bool profiler::writeTrace(string_view filename)
+{
+	string json      = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool   first     = true;
+	auto   add_event = [&](const string& event)
+	{
+		if (!first)
+			json += ",\n";
+		json += event;
+		first = false;
+	};
+
+	std::lock_guard lock(thread_buffers_mutex);
+	for (auto& buffer : thread_buffers)
+	{
+		std::lock_guard buffer_lock(buffer->mutex);
+
+		// Thread name
+		add_event(fmt::format(
+			R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+			buffer->id,
+			jsonEscape(buffer->name)));
+
+		// Zones (oldest first), timestamps are in microseconds
+		auto capacity   = buffer->zones.size();
+		auto first_zone = buffer->count > capacity ? buffer->count - capacity : 0;
+		for (auto a = first_zone; a < buffer->count; ++a)
+		{
+			const auto& zone = buffer->zones[a % capacity];
+			add_event(fmt::format(
+				R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+				jsonEscape(zone.name),
+				buffer->id,
+				static_cast<double>(zone.start - capture_start) / 1000.,
+				static_cast<double>(zone.end - zone.start) / 1000.));
+		}
+	}
+	json += "]}\n";
+
+	return fileutil::writeStringToFile(json, string{ filename });
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+CONSOLE_COMMAND(profiler, 1, true)
+{
+	if (args[0] == "start")
+	{
+		if (profiler::start())
+			log::console("Profiler capture started");
+		else
+			log::console("Profiler is already capturing");
+	}
+	else if (args[0] == "stop")
+	{
+		profiler::stop();
+		log::console(wxString::Format("Profiler capture stopped, %u zones recorded", profiler::nZones()));
+	}
+	else if (args[0] == "clear")
+		profiler::clear();
+	else if (args[0] == "save")
+	{
+		auto path = args.size() > 1 ? args[1] : app::path("slade_trace.json", app::Dir::User);
+		if (profiler::writeTrace(path))
+			log::console(wxString::Format("Wrote %u profiler zones to %s", profiler::nZones(), path));
+		else
+			log::console(wxString::Format("Unable to write %s", path));
+	}
+	else
+		log::console("Usage: profiler <start|stop|clear|save [filename]>");
+}
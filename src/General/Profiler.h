@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+
+namespace slade::profiler
+{
+extern std::atomic<bool> capture_enabled;
+
+// Returns true if profiling zones are currently being captured
+inline bool capturing()
+{
+	return capture_enabled.load(std::memory_order_relaxed);
+}
+
+int64_t now();
+void    record(const char* name, int64_t start, int64_t end);
+
+// Records the time spent in the current scope as a zone named [name] (which
+// must be a string literal or otherwise outlive the capture), if capturing.
+// When not capturing this costs a single atomic load
+class Zone
+{
+public:
+	Zone(const char* name) : name_{ capturing() ? name : nullptr }, start_{ name_ ? now() : 0 } {}
+	~Zone()
+	{
+		if (name_)
+			record(name_, start_, now());
+	}
+
+	Zone(const Zone&)            = delete;
+	Zone& operator=(const Zone&) = delete;
+
+private:
+	const char* name_;
+	int64_t     start_;
+};
+
+bool     start();
+void     stop();
+void     clear();
+unsigned nZones();
+void     setThreadName(string_view name);
+bool     writeTrace(string_view filename);
+} // namespace slade::profiler
+
+// Profiles the current scope as a zone named [name]
+#ifndef NO_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)        slade::profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -36,6 +36,8 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "General/UndoRedo.h"
+#include "App.h"
+#include "Utility/FileUtils.h"
 
 using namespace slade;
 
@@ -45,9 +47,11 @@ using namespace slade;
 // Variables
 //
 // -----------------------------------------------------------------------------
+CVAR(Int, undo_memory_limit, 256, CVar::Flag::Save) // MB of undo data to keep in memory before spilling to disk
 namespace
 {
 UndoManager* current_undo_manager = nullptr;
+unsigned     spill_file_count     = 0;
 } // namespace
 
 
@@ -63,6 +67,16 @@ UndoManager* current_undo_manager = nullptr;
 // -----------------------------------------------------------------------------
 UndoLevel::UndoLevel(string_view name) : name_{ name }, timestamp_{ wxDateTime::Now() } {}
 
+// -----------------------------------------------------------------------------
+// UndoLevel class destructor
+// -----------------------------------------------------------------------------
+UndoLevel::~UndoLevel()
+{
+	// Remove spill file if any
+	if (isSpilled())
+		fileutil::removeFile(spill_file_);
+}
+
 // -----------------------------------------------------------------------------
 // Returns a string representation of the time at which the undo level was
 // recorded
@@ -83,6 +97,9 @@ string UndoLevel::timeStamp(bool date, bool time) const
 bool UndoLevel::doUndo()
 {
 	log::info(3, "Performing undo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (isSpilled() && !unspill())
+		return false;
+
 	bool ok = true;
 	for (int a = (int)undo_steps_.size() - 1; a >= 0; a--)
 	{
@@ -99,6 +116,9 @@ bool UndoLevel::doUndo()
 bool UndoLevel::doRedo()
 {
 	log::info(3, "Performing redo \"{}\" ({} steps)", name_, undo_steps_.size());
+	if (isSpilled() && !unspill())
+		return false;
+
 	bool ok = true;
 	for (auto& undo_step : undo_steps_)
 	{
@@ -110,19 +130,64 @@ bool UndoLevel::doRedo()
 }
 
 // -----------------------------------------------------------------------------
-// Reads the undo level from a file
+// Lets all undo steps in this level know that recording has finished
+// -----------------------------------------------------------------------------
+void UndoLevel::recordEnded() const
+{
+	for (auto& undo_step : undo_steps_)
+		undo_step->recordEnded();
+}
+
+// -----------------------------------------------------------------------------
+// Reads the undo level's step data from a file
 // -----------------------------------------------------------------------------
 bool UndoLevel::readFile(string_view filename) const
 {
+	MemChunk mc;
+	if (!mc.importFile(filename))
+		return false;
+
+	// Read each step's data (prefixed with its size)
+	MemChunk step_data;
+	for (auto& undo_step : undo_steps_)
+	{
+		uint32_t size = 0;
+		if (!mc.read(&size, 4) || mc.currentPos() + size > mc.size())
+			return false;
+		if (size == 0)
+			continue;
+
+		step_data.importMem(mc.data() + mc.currentPos(), size);
+		step_data.seek(0, SEEK_SET);
+		mc.seek(size, SEEK_CUR);
+		if (!undo_step->readFile(step_data))
+			return false;
+	}
+
 	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Writes the undo level to a file
+// Writes the undo level's step data to a file
 // -----------------------------------------------------------------------------
 bool UndoLevel::writeFile(string_view filename) const
 {
-	return true;
+	MemChunk mc;
+	MemChunk step_data;
+	for (auto& undo_step : undo_steps_)
+	{
+		// Steps with no spillable data are written as size 0
+		step_data.clear();
+		if (undo_step->dataSize() > 0 && !undo_step->writeFile(step_data))
+			return false;
+
+		uint32_t size = step_data.size();
+		mc.write(&size, 4);
+		if (size > 0)
+			mc.write(step_data.data(), size);
+	}
+
+	return mc.exportFile(filename);
 }
 
 // -----------------------------------------------------------------------------
@@ -132,6 +197,9 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 {
 	for (auto& level : levels)
 	{
+		if (level->isSpilled())
+			level->unspill();
+
 		for (auto& undo_step : level->undo_steps_)
 		{
 			auto ptr = undo_step.release();
@@ -142,6 +210,57 @@ void UndoLevel::createMerged(vector<unique_ptr<UndoLevel>>& levels)
 }
 
 
+// -----------------------------------------------------------------------------
+// Returns the total size of step data in this level that could be spilled
+// -----------------------------------------------------------------------------
+size_t UndoLevel::dataSize() const
+{
+	size_t size = 0;
+	for (auto& undo_step : undo_steps_)
+		size += undo_step->dataSize();
+
+	return size;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the level's step data to [filename] and clears it from memory. It will
+// be read back automatically when the level is undone/redone
+// -----------------------------------------------------------------------------
+bool UndoLevel::spill(string_view filename)
+{
+	if (isSpilled() || !writeFile(filename))
+		return false;
+
+	for (auto& undo_step : undo_steps_)
+		if (undo_step->dataSize() > 0)
+			undo_step->clearData();
+
+	spill_file_ = filename;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the level's step data back from its spill file
+// -----------------------------------------------------------------------------
+bool UndoLevel::unspill()
+{
+	if (!isSpilled())
+		return true;
+
+	if (!readFile(spill_file_))
+	{
+		log::error("Unable to read undo data for \"{}\" from {}", name_, spill_file_);
+		return false;
+	}
+
+	fileutil::removeFile(spill_file_);
+	spill_file_.clear();
+
+	return true;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // UndoManager Class Functions
@@ -196,10 +315,14 @@ void UndoManager::endRecord(bool success)
 
 	// Add current level to levels
 	// log::info(1, "Recording undo level \"%s\" succeeded", current_level->getName());
+	current_level_->recordEnded();
 	undo_levels_.push_back(std::move(current_level_));
 	current_level_.reset(nullptr);
 	current_level_index_ = undo_levels_.size() - 1;
 
+	// Spill old levels to disk if needed
+	limitMemoryUsage();
+
 	// Clear current undo manager
 	current_undo_manager = nullptr;
 
@@ -347,6 +470,38 @@ bool UndoManager::createMergedLevel(UndoManager* manager, string_view name)
 }
 
 
+// -----------------------------------------------------------------------------
+// Writes the step data of the oldest undo levels to disk until the total size
+// of undo data in memory is within the undo_memory_limit cvar
+// -----------------------------------------------------------------------------
+void UndoManager::limitMemoryUsage() const
+{
+	if (undo_memory_limit <= 0)
+		return;
+
+	size_t limit = static_cast<size_t>(undo_memory_limit) * 1024 * 1024;
+	size_t total = 0;
+	for (auto& level : undo_levels_)
+		total += level->dataSize();
+
+	// Never spill the most recent level
+	for (unsigned a = 0; a + 1 < undo_levels_.size() && total > limit; ++a)
+	{
+		auto size = undo_levels_[a]->dataSize();
+		if (size == 0)
+			continue;
+
+		auto filename = app::path(
+			fmt::format("undo_{}_{}.dat", wxGetProcessId(), spill_file_count++), app::Dir::Temp);
+		if (undo_levels_[a]->spill(filename))
+		{
+			log::info(2, "Spilled undo level \"{}\" ({} bytes) to disk", undo_levels_[a]->name(), size);
+			total -= size;
+		}
+	}
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // UndoRedo Namespace Functions
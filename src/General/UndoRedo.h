@@ -13,28 +13,41 @@ public:
 	virtual bool writeFile(MemChunk& mc) { return true; }
 	virtual bool readFile(MemChunk& mc) { return true; }
 	virtual bool isOk() { return true; }
+	virtual void recordEnded() {}
+
+	// Size of the step's data that can be written to a file and cleared
+	// (via writeFile/clearData) to free memory, 0 if not supported
+	virtual size_t dataSize() const { return 0; }
+	virtual void   clearData() {}
 };
 
 class UndoLevel
 {
 public:
 	UndoLevel(string_view name);
-	~UndoLevel() = default;
+	~UndoLevel();
 
 	string name() const { return name_; }
 	bool   doUndo();
 	bool   doRedo();
 	void   addStep(unique_ptr<UndoStep> step) { undo_steps_.push_back(std::move(step)); }
 	string timeStamp(bool date, bool time) const;
+	void   recordEnded() const;
 
 	bool writeFile(string_view filename) const;
 	bool readFile(string_view filename) const;
 	void createMerged(vector<unique_ptr<UndoLevel>>& levels);
 
+	size_t dataSize() const;
+	bool   isSpilled() const { return !spill_file_.empty(); }
+	bool   spill(string_view filename);
+	bool   unspill();
+
 private:
 	string                       name_;
 	vector<unique_ptr<UndoStep>> undo_steps_;
 	wxDateTime                   timestamp_;
+	string                       spill_file_; // File the level's step data was written to (if spilled)
 };
 
 class SLADEMap;
@@ -61,6 +74,7 @@ public:
 
 	void clear();
 	bool createMergedLevel(UndoManager* manager, string_view name);
+	void limitMemoryUsage() const;
 
 	// Signals
 	struct Signals
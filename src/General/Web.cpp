@@ -44,6 +44,17 @@ using namespace slade;
 wxDEFINE_EVENT(wxEVT_THREAD_WEBGET_COMPLETED, wxThreadEvent);
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const float http_timeout = 10.0f; // Seconds to wait for a response
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Web Namespace Functions
@@ -63,7 +74,7 @@ string web::getHttp(const string& host, const string& uri)
 	request.setUri(uri);
 
 	// Send HTTP request
-	auto response = http.sendRequest(request);
+	auto response = http.sendRequest(request, sf::seconds(http_timeout));
 
 	switch (response.getStatus())
 	{
@@ -74,16 +85,21 @@ string web::getHttp(const string& host, const string& uri)
 
 // -----------------------------------------------------------------------------
 // Gets a response via http from [host]/[url] (non-blocking). When the response
-// is received, an event is sent to [event_handler]
+// is received, an event is sent to [event_handler].
+// The request runs on its own detached thread rather than as a job, since it
+// spends its time waiting on the network and shouldn't hold up a job worker
+// (or shutting down the job pool on exit)
 // -----------------------------------------------------------------------------
 void web::getHttpAsync(const string& host, const string& uri, wxEvtHandler* event_handler)
 {
-	std::thread thread([=]() {
-		// Queue wx event with http request response
-		auto event = new wxThreadEvent(wxEVT_THREAD_WEBGET_COMPLETED);
-		event->SetString(getHttp(host, uri));
-		wxQueueEvent(event_handler, event);
-	});
+	std::thread thread(
+		[=]()
+		{
+			// Queue wx event with http request response
+			auto event = new wxThreadEvent(wxEVT_THREAD_WEBGET_COMPLETED);
+			event->SetString(getHttp(host, uri));
+			wxQueueEvent(event_handler, event);
+		});
 
 	thread.detach();
 }
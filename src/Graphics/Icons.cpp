@@ -33,8 +33,12 @@
 #include "Icons.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "General/Console.h"
+#include "General/Misc.h"
 #include "UI/WxUtils.h"
+#include "Utility/FileUtils.h"
 #include "Utility/Parser.h"
+#include <chrono>
 #include <wx/mstream.h>
 
 using namespace slade;
@@ -47,6 +51,7 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 CVAR(String, iconset_general, "Default", CVar::Flag::Save)
 CVAR(String, iconset_entry_list, "Default", CVar::Flag::Save)
+CVAR(Bool, icons_disk_cache, false, CVar::Flag::Save)
 
 namespace slade::icons
 {
@@ -65,12 +70,30 @@ struct IconSet
 	IconSet(string_view name) : name{ name } {}
 };
 
+#if wxCHECK_VERSION(3, 1, 6)
+typedef wxBitmapBundle Icon;
+#else
+typedef wxBitmap Icon;
+#endif
+
+// Loaded icons, keyed by definition (which also identifies the set/theme),
+// size and padding
+typedef std::tuple<const IconDef*, int, int, int> IconKey;
+struct IconCache
+{
+	std::map<IconKey, Icon> icons;
+	unsigned                hits    = 0;
+	unsigned                misses  = 0;
+	double                  load_ms = 0.;
+};
+
 bool            ui_icons_dark = false;
 vector<IconSet> iconsets_entry;
 vector<IconSet> iconsets_general;
 IconSet         iconset_text_editor{ "Default" };
 IconSet         iconset_ui_dark{ "Dark" };
 IconSet         iconset_ui_light{ "Light" };
+IconCache       icon_cache;
 } // namespace slade::icons
 
 
@@ -280,7 +303,24 @@ void parseGeneralBlock(const ParseTreeNode& node, const Archive& res_archive)
 // -----------------------------------------------------------------------------
 wxBitmap loadSVGIcon(const string& svg_data, int size, Point2i padding)
 {
-	const auto img = wxutil::createImageFromSVG(svg_data, size, size);
+	// Check for a previously rasterized image in the disk cache
+	wxImage img;
+	string  cache_file;
+	if (icons_disk_cache)
+	{
+		auto hash  = misc::hash64(reinterpret_cast<const uint8_t*>(svg_data.data()), svg_data.size());
+		cache_file = app::path(fmt::format("icon_cache/{:016x}_{}.png", hash, size), app::Dir::User);
+		if (fileutil::fileExists(cache_file))
+			img.LoadFile(cache_file, wxBITMAP_TYPE_PNG);
+	}
+
+	// Rasterize if needed
+	if (!img.IsOk())
+	{
+		img = wxutil::createImageFromSVG(svg_data, size, size);
+		if (!cache_file.empty() && img.IsOk())
+			img.SaveFile(cache_file, wxBITMAP_TYPE_PNG);
+	}
 
 	// Add padding if needed
 	if (padding.x > 0 || padding.y > 0)
@@ -365,6 +405,28 @@ wxBitmap loadPNGIcon(const IconDef& icon, int size, Point2i padding)
 
 	return { image };
 }
+
+// -----------------------------------------------------------------------------
+// Returns the cached icon for [icon_def] at [size] with [padding], loading it
+// via [load] and adding it to the cache if it isn't cached yet
+// -----------------------------------------------------------------------------
+template<typename F> Icon cachedIcon(const IconDef* icon_def, int size, Point2i padding, const F& load)
+{
+	const IconKey key{ icon_def, size, padding.x, padding.y };
+	if (auto i = icon_cache.icons.find(key); i != icon_cache.icons.end())
+	{
+		++icon_cache.hits;
+		return i->second;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	auto       icon  = load();
+	icon_cache.load_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	++icon_cache.misses;
+
+	icon_cache.icons[key] = icon;
+	return icon;
+}
 } // namespace slade::icons
 
 // -----------------------------------------------------------------------------
@@ -392,6 +454,11 @@ bool icons::loadIcons()
 	ui_icons_dark = fg_r > bg_r;
 #endif
 
+	// Clear cached icons (definitions are about to be replaced)
+	icon_cache.icons.clear();
+	if (icons_disk_cache)
+		fileutil::createDir(app::path("icon_cache", app::Dir::User));
+
 	// Get slade.pk3
 	auto* res_archive = app::archiveManager().programResourceArchive();
 	if (!res_archive)
@@ -445,8 +512,8 @@ bool icons::loadIcons()
 // Loads the icon [name] of [type] into a wxBitmapBundle of minimum [size], with
 // optional [padding] (png icons only).
 //
-// NOTE: this does not use any kind of caching and will generate/load the icon
-// from svg/png data each time
+// Icons are only generated/loaded from svg/png data the first time they are
+// requested, after that the cached icon is returned
 // -----------------------------------------------------------------------------
 wxBitmapBundle icons::getIcon(Type type, string_view name, int size, Point2i padding)
 {
@@ -462,31 +529,38 @@ wxBitmapBundle icons::getIcon(Type type, string_view name, int size, Point2i pad
 	if (size <= 0)
 		size = 16;
 
-	// If there is SVG data use that
-	if (!icon_def->svg_data.empty())
-		return wxBitmapBundle::FromSVG(icon_def->svg_data.c_str(), { size, size });
+	return cachedIcon(
+		icon_def,
+		size,
+		padding,
+		[icon_def, size, padding]() -> wxBitmapBundle
+		{
+			// If there is SVG data use that
+			if (!icon_def->svg_data.empty())
+				return wxBitmapBundle::FromSVG(icon_def->svg_data.c_str(), { size, size });
 
-	// Otherwise load from png
-	if (icon_def->entry_png16 || icon_def->entry_png32)
-	{
-		wxVector<wxBitmap> bitmaps;
-		if (size <= 16)
-			bitmaps.push_back(loadPNGIcon(*icon_def, 16, padding));
-		if (size <= 24)
-			bitmaps.push_back(loadPNGIcon(*icon_def, 24, padding));
-		bitmaps.push_back(loadPNGIcon(*icon_def, 32, padding));
-		return wxBitmapBundle::FromBitmaps(bitmaps);
-	}
+			// Otherwise load from png
+			if (icon_def->entry_png16 || icon_def->entry_png32)
+			{
+				wxVector<wxBitmap> bitmaps;
+				if (size <= 16)
+					bitmaps.push_back(loadPNGIcon(*icon_def, 16, padding));
+				if (size <= 24)
+					bitmaps.push_back(loadPNGIcon(*icon_def, 24, padding));
+				bitmaps.push_back(loadPNGIcon(*icon_def, 32, padding));
+				return wxBitmapBundle::FromBitmaps(bitmaps);
+			}
 
-	return wxNullBitmap;
+			return wxNullBitmap;
+		});
 }
 #else
 // -----------------------------------------------------------------------------
 // Loads the icon [name] of [type] into a wxBitmap of [size], with optional
 // [padding].
 //
-// NOTE: this does not use any kind of caching and will generate/load the icon
-// from svg/png data each time
+// Icons are only generated/loaded from svg/png data the first time they are
+// requested, after that the cached icon is returned
 // -----------------------------------------------------------------------------
 wxBitmap icons::getIcon(Type type, string_view name, int size, Point2i padding)
 {
@@ -502,15 +576,22 @@ wxBitmap icons::getIcon(Type type, string_view name, int size, Point2i padding)
 	if (size <= 0)
 		size = ui::scalePx(16);
 
-	// If there is SVG data use that
-	if (!icon_def->svg_data.empty())
-		return loadSVGIcon(icon_def->svg_data, size, padding);
+	return cachedIcon(
+		icon_def,
+		size,
+		padding,
+		[icon_def, size, padding]() -> wxBitmap
+		{
+			// If there is SVG data use that
+			if (!icon_def->svg_data.empty())
+				return loadSVGIcon(icon_def->svg_data, size, padding);
 
-	// Otherwise load from png
-	if (icon_def->entry_png16 || icon_def->entry_png32)
-		return loadPNGIcon(*icon_def, size, padding);
+			// Otherwise load from png
+			if (icon_def->entry_png16 || icon_def->entry_png32)
+				return loadPNGIcon(*icon_def, size, padding);
 
-	return wxNullBitmap;
+			return wxNullBitmap;
+		});
 }
 #endif
 
@@ -519,8 +600,8 @@ wxBitmap icons::getIcon(Type type, string_view name, int size, Point2i padding)
 // Loads the interface icon [name] from [theme] into a wxBitmapBundle of minimum
 // [size].
 //
-// NOTE: this does not use any kind of caching and will generate/load the icon
-// from svg/png data each time
+// Icons are only generated/loaded from svg/png data the first time they are
+// requested, after that the cached icon is returned
 // -----------------------------------------------------------------------------
 wxBitmapBundle icons::getInterfaceIcon(string_view name, int size, InterfaceTheme theme)
 {
@@ -550,7 +631,11 @@ wxBitmapBundle icons::getInterfaceIcon(string_view name, int size, InterfaceThem
 
 	// If there is SVG data use that
 	if (!icon_def->svg_data.empty())
-		return wxBitmapBundle::FromSVG(icon_def->svg_data.c_str(), { size, size });
+		return cachedIcon(
+			icon_def,
+			size,
+			{},
+			[icon_def, size]() { return wxBitmapBundle::FromSVG(icon_def->svg_data.c_str(), { size, size }); });
 
 	return wxNullBitmap;
 }
@@ -558,8 +643,8 @@ wxBitmapBundle icons::getInterfaceIcon(string_view name, int size, InterfaceThem
 // -----------------------------------------------------------------------------
 // Loads the interface icon [name] from [theme] into a wxBitmap of [size].
 //
-// NOTE: this does not use any kind of caching and will generate/load the icon
-// from svg/png data each time
+// Icons are only generated/loaded from svg/png data the first time they are
+// requested, after that the cached icon is returned
 // -----------------------------------------------------------------------------
 wxBitmap icons::getInterfaceIcon(string_view name, int size, InterfaceTheme theme)
 {
@@ -589,7 +674,7 @@ wxBitmap icons::getInterfaceIcon(string_view name, int size, InterfaceTheme them
 
 	// If there is SVG data use that
 	if (!icon_def->svg_data.empty())
-		return loadSVGIcon(icon_def->svg_data, size, {});
+		return cachedIcon(icon_def, size, {}, [icon_def, size]() { return loadSVGIcon(icon_def->svg_data, size, {}); });
 
 	return wxNullBitmap;
 }
@@ -620,3 +705,19 @@ bool icons::iconExists(Type type, string_view name)
 {
 	return iconDef(type, name) != nullptr;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+CONSOLE_COMMAND(icon_cache_stats, 0, false)
+{
+	log::console(fmt::format(
+		"{} icons cached, {} cache hits, {:.1f}ms spent loading icons",
+		icons::icon_cache.icons.size(),
+		icons::icon_cache.hits,
+		icons::icon_cache.load_ms));
+}
@@ -0,0 +1,573 @@
+
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    PNGOptimizer.cpp
+// Description: Built-in lossless PNG optimizer. Re-encodes PNG data using the
+//              smallest colour type that can represent the image, and tries
+//              various row filters and deflate settings to find the smallest
+//              encoding
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PNGOptimizer.h"
+#include "Graphics/SImage/SImage.h"
+#include "Utility/Memory.h"
+#include <chrono>
+#include <zlib.h>
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, png_opt_reduce_palette, true, CVar::Flag::Save)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const uint8_t PNG_SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+enum ColourType : uint8_t
+{
+	Greyscale  = 0,
+	Truecolour = 2,
+	Indexed    = 3,
+	RGBA       = 6,
+};
+
+// The raw (unfiltered) image to be encoded
+struct RawImage
+{
+	unsigned        width   = 0;
+	unsigned        height  = 0;
+	ColourType      coltype = Truecolour;
+	unsigned        bpp     = 3; // Bytes per pixel
+	vector<uint8_t> pixels;
+	vector<uint8_t> plte;
+	vector<uint8_t> trns;
+};
+
+// Info about the source PNG gathered from its chunks
+struct SourceInfo
+{
+	uint8_t              bit_depth  = 0;
+	uint8_t              coltype    = 0;
+	bool                 animated   = false;
+	bool                 alph_chunk = false;
+	std::optional<Vec2i> grab;
+};
+
+// -----------------------------------------------------------------------------
+// Writes [value] to [data] at [ofs] as a big-endian 32bit integer
+// -----------------------------------------------------------------------------
+void setB32(uint8_t* data, unsigned ofs, uint32_t value)
+{
+	data[ofs]     = value >> 24;
+	data[ofs + 1] = value >> 16;
+	data[ofs + 2] = value >> 8;
+	data[ofs + 3] = value;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [value] to [out] as a big-endian 32bit integer
+// -----------------------------------------------------------------------------
+void writeB32(MemChunk& out, uint32_t value)
+{
+	uint8_t bytes[4];
+	setB32(bytes, 0, value);
+	out.write(bytes, 4);
+}
+
+// -----------------------------------------------------------------------------
+// Writes a PNG chunk named [name] with [size] bytes of [data] to [out]
+// -----------------------------------------------------------------------------
+void writeChunk(MemChunk& out, const char* name, const uint8_t* data, uint32_t size)
+{
+	auto crc = crc32(0, reinterpret_cast<const Bytef*>(name), 4);
+	if (size > 0)
+		crc = crc32(crc, data, size);
+
+	writeB32(out, size);
+	out.write(name, 4);
+	if (size > 0)
+		out.write(data, size);
+	writeB32(out, crc);
+}
+
+// -----------------------------------------------------------------------------
+// Reads info from the chunks in [png_data] into [info].
+// Returns false if the data isn't a valid PNG
+// -----------------------------------------------------------------------------
+bool readSourceInfo(const MemChunk& png_data, SourceInfo& info)
+{
+	auto data = png_data.data();
+	auto size = png_data.size();
+	if (size < 33 || memcmp(data, PNG_SIGNATURE, 8) != 0)
+		return false;
+
+	for (size_t pos = 8; pos + 12 <= size;)
+	{
+		auto chunk_size = memory::readB32(data, pos);
+		auto name       = string_view(reinterpret_cast<const char*>(data) + pos + 4, 4);
+		if (pos + 12 + chunk_size > size)
+			return false;
+
+		if (name == "IHDR" && chunk_size >= 13)
+		{
+			info.bit_depth = data[pos + 16];
+			info.coltype   = data[pos + 17];
+		}
+		else if (name == "acTL")
+			info.animated = true;
+		else if (name == "alPh")
+			info.alph_chunk = true;
+		else if (name == "grAb" && chunk_size >= 8)
+			info.grab = Vec2i(
+				static_cast<int32_t>(memory::readB32(data, pos + 8)),
+				static_cast<int32_t>(memory::readB32(data, pos + 12)));
+		else if (name == "IEND")
+			break;
+
+		pos += 12 + chunk_size;
+	}
+
+	return info.bit_depth > 0;
+}
+
+// -----------------------------------------------------------------------------
+// Sets up [raw] as an indexed image from the paletted [image], keeping the
+// palette indices as they are (other than removing unused palette entries if
+// png_opt_reduce_palette is enabled).
+// Returns false if the image's transparency can't be represented by a tRNS
+// chunk (ie. pixels with the same index have different alpha)
+// -----------------------------------------------------------------------------
+bool setupIndexed(const SImage& image, RawImage& raw)
+{
+	SImage img(image);
+	if (png_opt_reduce_palette)
+		img.shrinkPalette();
+
+	MemChunk indices, rgba;
+	img.putIndexedData(indices);
+	img.putRGBAData(rgba);
+
+	// Get alpha for each palette index, and the number of indices used
+	int      alpha[256];
+	unsigned n_colours = 0;
+	std::fill_n(alpha, 256, -1);
+	for (unsigned a = 0; a < indices.size(); ++a)
+	{
+		auto index = indices[a];
+		if (alpha[index] < 0)
+			alpha[index] = rgba[a * 4 + 3];
+		else if (alpha[index] != rgba[a * 4 + 3])
+			return false;
+
+		n_colours = std::max(n_colours, index + 1u);
+	}
+
+	// Build PLTE and tRNS
+	raw.plte.resize(n_colours * 3);
+	unsigned n_trns = 0;
+	for (unsigned a = 0; a < n_colours; ++a)
+	{
+		auto col            = img.palette()->colour(a);
+		raw.plte[a * 3]     = col.r;
+		raw.plte[a * 3 + 1] = col.g;
+		raw.plte[a * 3 + 2] = col.b;
+		if (alpha[a] >= 0 && alpha[a] < 255)
+			n_trns = a + 1;
+	}
+	for (unsigned a = 0; a < n_trns; ++a)
+		raw.trns.push_back(alpha[a] < 0 ? 255 : alpha[a]);
+
+	raw.coltype = Indexed;
+	raw.bpp     = 1;
+	raw.pixels.assign(indices.data(), indices.data() + indices.size());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sets up [raw] with the smallest representation of the truecolour [rgba]
+// pixel data: indexed if there are 256 or less colours (and palette reduction
+// is enabled), otherwise RGB if fully opaque, otherwise RGBA
+// -----------------------------------------------------------------------------
+void setupTruecolour(const MemChunk& rgba, RawImage& raw)
+{
+	auto n_pixels = rgba.size() / 4;
+	auto pixel    = [&rgba](size_t index) { return memory::readB32(rgba.data(), index * 4); };
+
+	// Check for transparency and count colours
+	bool                                  opaque = true;
+	std::unordered_map<uint32_t, uint8_t> colours;
+	for (size_t a = 0; a < n_pixels; ++a)
+	{
+		if (rgba[a * 4 + 3] != 255)
+			opaque = false;
+
+		if (png_opt_reduce_palette && colours.size() <= 256)
+			colours.emplace(pixel(a), 0);
+	}
+
+	// Indexed
+	if (png_opt_reduce_palette && colours.size() <= 256)
+	{
+		// Sort colours so that translucent ones are first (to minimize tRNS)
+		vector<uint32_t> palette;
+		for (const auto& col : colours)
+			palette.push_back(col.first);
+		std::sort(
+			palette.begin(),
+			palette.end(),
+			[](uint32_t left, uint32_t right)
+			{ return std::make_pair(left & 0xFF, left) < std::make_pair(right & 0xFF, right); });
+
+		raw.plte.resize(palette.size() * 3);
+		for (unsigned a = 0; a < palette.size(); ++a)
+		{
+			colours[palette[a]] = a;
+			raw.plte[a * 3]     = palette[a] >> 24;
+			raw.plte[a * 3 + 1] = palette[a] >> 16;
+			raw.plte[a * 3 + 2] = palette[a] >> 8;
+			if ((palette[a] & 0xFF) != 255)
+				raw.trns.push_back(palette[a] & 0xFF);
+		}
+
+		raw.coltype = Indexed;
+		raw.bpp     = 1;
+		raw.pixels.resize(n_pixels);
+		for (size_t a = 0; a < n_pixels; ++a)
+			raw.pixels[a] = colours[pixel(a)];
+
+		return;
+	}
+
+	// RGB
+	if (opaque)
+	{
+		raw.coltype = Truecolour;
+		raw.bpp     = 3;
+		raw.pixels.resize(n_pixels * 3);
+		for (size_t a = 0; a < n_pixels; ++a)
+			memcpy(raw.pixels.data() + a * 3, rgba.data() + a * 4, 3);
+
+		return;
+	}
+
+	// RGBA
+	raw.coltype = RGBA;
+	raw.bpp     = 4;
+	raw.pixels.assign(rgba.data(), rgba.data() + rgba.size());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the paeth predictor for [a] (left), [b] (up) and [c] (up-left)
+// -----------------------------------------------------------------------------
+uint8_t paeth(int a, int b, int c)
+{
+	int p  = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+// -----------------------------------------------------------------------------
+// Applies PNG [filter] type to [row] (with [prev] as the previous row, or null
+// for the first row), writing the filtered bytes to [out]
+// -----------------------------------------------------------------------------
+void filterRow(int filter, const uint8_t* row, const uint8_t* prev, unsigned size, unsigned bpp, uint8_t* out)
+{
+	for (unsigned x = 0; x < size; ++x)
+	{
+		int left    = x >= bpp ? row[x - bpp] : 0;
+		int up      = prev ? prev[x] : 0;
+		int up_left = prev && x >= bpp ? prev[x - bpp] : 0;
+
+		switch (filter)
+		{
+		case 1: out[x] = row[x] - left; break;
+		case 2: out[x] = row[x] - up; break;
+		case 3: out[x] = row[x] - ((left + up) >> 1); break;
+		case 4: out[x] = row[x] - paeth(left, up, up_left); break;
+		default: out[x] = row[x]; break;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Filters all rows of [raw] into [out] (each row prefixed by its filter type).
+// If [filter] is negative, each row uses the filter that gives the smallest
+// sum of absolute (signed) differences, the usual adaptive heuristic
+// -----------------------------------------------------------------------------
+void filterImage(const RawImage& raw, int filter, vector<uint8_t>& out)
+{
+	auto stride = raw.width * raw.bpp;
+	out.resize((stride + 1) * raw.height);
+
+	vector<uint8_t> test(stride);
+	for (unsigned y = 0; y < raw.height; ++y)
+	{
+		auto row  = raw.pixels.data() + y * stride;
+		auto prev = y > 0 ? row - stride : nullptr;
+		auto dest = out.data() + y * (stride + 1);
+
+		auto row_filter = filter;
+		if (filter < 0)
+		{
+			unsigned best = std::numeric_limits<unsigned>::max();
+			for (int f = 0; f < 5; ++f)
+			{
+				filterRow(f, row, prev, stride, raw.bpp, test.data());
+
+				unsigned sum = 0;
+				for (auto byte : test)
+					sum += std::abs(static_cast<int8_t>(byte));
+				if (sum < best)
+				{
+					best       = sum;
+					row_filter = f;
+				}
+			}
+		}
+
+		dest[0] = row_filter;
+		filterRow(row_filter, row, prev, stride, raw.bpp, dest + 1);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Deflates [in] to [out] as a zlib stream with [strategy], at max compression.
+// Returns false on error
+// -----------------------------------------------------------------------------
+bool deflate(const vector<uint8_t>& in, int strategy, vector<uint8_t>& out)
+{
+	z_stream strm{};
+	if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS, 9, strategy) != Z_OK)
+		return false;
+
+	out.resize(deflateBound(&strm, in.size()));
+	strm.next_in   = const_cast<Bytef*>(in.data());
+	strm.avail_in  = in.size();
+	strm.next_out  = out.data();
+	strm.avail_out = out.size();
+	auto ret       = ::deflate(&strm, Z_FINISH);
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+
+	return ret == Z_STREAM_END;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the RGBA (or alpha map) pixels of [left] and [right] are
+// identical
+// -----------------------------------------------------------------------------
+bool samePixels(const SImage& left, const SImage& right)
+{
+	if (left.width() != right.width() || left.height() != right.height())
+		return false;
+
+	MemChunk left_data, right_data;
+	if (left.type() == SImage::Type::AlphaMap)
+	{
+		if (right.type() != SImage::Type::AlphaMap)
+			return false;
+
+		left.putIndexedData(left_data);
+		right.putIndexedData(right_data);
+	}
+	else
+	{
+		left.putRGBAData(left_data);
+		right.putRGBAData(right_data);
+	}
+
+	return left_data.size() == right_data.size()
+		   && memcmp(left_data.data(), right_data.data(), left_data.size()) == 0;
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Losslessly re-encodes [png_data] to [out], as small as possible.
+// Returns false if the result isn't smaller than the original (or the data
+// can't be re-encoded), and sets [stats] if given
+// -----------------------------------------------------------------------------
+bool gfx::optimizePNG(MemChunk& png_data, MemChunk& out, PNGOptStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+	out.clear();
+	if (stats)
+	{
+		stats->old_size = png_data.size();
+		stats->new_size = png_data.size();
+	}
+
+	auto finish = [&](bool optimized)
+	{
+		if (!optimized)
+			out.clear();
+		if (stats)
+		{
+			if (optimized)
+				stats->new_size = out.size();
+			stats->time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+								 .count();
+		}
+		return optimized;
+	};
+
+	// Check the PNG can be re-encoded losslessly
+	SourceInfo info;
+	if (!readSourceInfo(png_data, info))
+	{
+		global::error = "Invalid PNG data";
+		return finish(false);
+	}
+	if (info.bit_depth > 8)
+	{
+		global::error = "16-bit PNGs can't be optimized";
+		return finish(false);
+	}
+	if (info.animated)
+	{
+		global::error = "Animated PNGs can't be optimized";
+		return finish(false);
+	}
+	if (info.alph_chunk && info.coltype != Greyscale)
+	{
+		global::error = "Only greyscale alpha maps can be optimized";
+		return finish(false);
+	}
+
+	// Decode
+	SImage image;
+	if (!image.open(png_data, 0, "png"))
+	{
+		global::error = "Unable to decode PNG";
+		return finish(false);
+	}
+
+	// Get raw image data in the smallest colour type. 8-bit greyscale images
+	// (including alpha maps) are kept as greyscale since some ports treat them
+	// differently to paletted images
+	RawImage raw;
+	raw.width  = image.width();
+	raw.height = image.height();
+	if (info.coltype == Greyscale && info.bit_depth == 8 && image.type() != SImage::Type::RGBA)
+	{
+		raw.coltype = Greyscale;
+		raw.bpp     = 1;
+		MemChunk indices;
+		image.putIndexedData(indices);
+		raw.pixels.assign(indices.data(), indices.data() + indices.size());
+	}
+	else if (image.type() != SImage::Type::PalMask || !setupIndexed(image, raw))
+	{
+		MemChunk rgba;
+		image.putRGBAData(rgba);
+		setupTruecolour(rgba, raw);
+	}
+
+	// Find the smallest filter + deflate strategy combination. Filtering
+	// rarely helps indexed images, but it's cheap enough to try anyway
+	vector<uint8_t> filtered, compressed, best;
+	for (int filter = -1; filter < 5; ++filter)
+	{
+		filterImage(raw, filter, filtered);
+		for (auto strategy : { Z_DEFAULT_STRATEGY, Z_FILTERED, Z_RLE })
+		{
+			if (!deflate(filtered, strategy, compressed))
+				continue;
+			if (best.empty() || compressed.size() < best.size())
+				best.swap(compressed);
+		}
+	}
+	if (best.empty())
+	{
+		global::error = "Error compressing PNG data";
+		return finish(false);
+	}
+
+	// Write PNG
+	out.write(PNG_SIGNATURE, 8);
+	uint8_t ihdr[13];
+	setB32(ihdr, 0, raw.width);
+	setB32(ihdr, 4, raw.height);
+	ihdr[8]  = 8; // Bit depth
+	ihdr[9]  = raw.coltype;
+	ihdr[10] = 0; // Compression
+	ihdr[11] = 0; // Filter
+	ihdr[12] = 0; // Interlace
+	writeChunk(out, "IHDR", ihdr, 13);
+	if (info.grab || image.offset().x != 0 || image.offset().y != 0)
+	{
+		uint8_t grab[8];
+		setB32(grab, 0, image.offset().x);
+		setB32(grab, 4, image.offset().y);
+		writeChunk(out, "grAb", grab, 8);
+	}
+	if (image.type() == SImage::Type::AlphaMap)
+		writeChunk(out, "alPh", nullptr, 0);
+	if (!raw.plte.empty())
+		writeChunk(out, "PLTE", raw.plte.data(), raw.plte.size());
+	if (!raw.trns.empty())
+		writeChunk(out, "tRNS", raw.trns.data(), raw.trns.size());
+	writeChunk(out, "IDAT", best.data(), best.size());
+	writeChunk(out, "IEND", nullptr, 0);
+
+	if (out.size() >= png_data.size())
+	{
+		global::error = "Already optimal";
+		return finish(false);
+	}
+
+	// Make sure the result decodes to exactly the same image
+	SImage check;
+	if (!check.open(out, 0, "png") || !samePixels(image, check))
+	{
+		global::error = "Optimized PNG doesn't match the original image";
+		return finish(false);
+	}
+
+	return finish(true);
+}
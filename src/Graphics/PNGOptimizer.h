@@ -0,0 +1,20 @@
+#pragma once
+
+namespace slade::gfx
+{
+struct PNGOptStats
+{
+	size_t old_size = 0;
+	size_t new_size = 0;
+	double time_ms  = 0.;
+};
+
+// Losslessly re-encodes [png_data] as small as possible (colour type and
+// palette reduction, filter selection, deflate tuning, removing all ancillary
+// chunks except grAb/alPh), writing the result to [out].
+// Returns false if the data couldn't be made any smaller (or isn't a PNG that
+// can be safely re-encoded), in which case [out] is cleared and global::error
+// says why. global::error is per-thread and no other global state is touched,
+// so this is safe to call from multiple threads
+bool optimizePNG(MemChunk& png_data, MemChunk& out, PNGOptStats* stats = nullptr);
+} // namespace slade::gfx
@@ -35,6 +35,7 @@
 #include "SImage.h"
 #include "Graphics/Translation.h"
 #include "SIFormat.h"
+#include "SImageBlend.h"
 #include "Utility/MathStuff.h"
 #undef BOOL
 
@@ -1314,61 +1315,85 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 	// Handle truecolor images
 	if (type_ == Type::RGBA)
 		truecolor = true;
-	const size_t bpp = this->bpp();
 
 	// Get palette to use
 	if (has_palette_ || !pal)
 		pal = &palette_;
 
-	uint8_t* newdata;
-	if (truecolor && type_ == Type::PalMask)
+	// Get the translation compiled for the palette, so that each pixel is just
+	// a table lookup
+	const auto     lut      = tr->lookupTable(pal);
+	const auto     n_pixels = width_ * height_;
+	const uint8_t* mask     = mask_.hasData() ? mask_.data() : nullptr;
+	auto           data     = data_.data();
+
+	// Paletted -> paletted, just remap indices
+	if (type_ == Type::PalMask && !truecolor)
 	{
-		newdata = new uint8_t[width_ * height_ * 4];
-		memset(newdata, 0, width_ * height_ * 4);
+		for (int p = 0; p < n_pixels; p++)
+		{
+			// No need to process transparent pixels
+			if (mask && mask[p] == 0)
+				continue;
+
+			data[p] = lut->index[data[p]];
+		}
 	}
-	else
-		newdata = data_.data();
 
-	// Go through pixels
-	for (int p = 0; p < width_ * height_; p++)
+	// Paletted -> truecolour
+	else if (type_ == Type::PalMask)
 	{
-		// No need to process transparent pixels
-		if (mask_.hasData() && mask_[p] == 0)
-			continue;
-
-		ColRGBA col;
-		int     q = p * bpp;
-		if (type_ == Type::PalMask)
-			col.set(pal->colour(data_[p]));
-		else if (type_ == Type::RGBA)
+		vector<uint8_t> newdata(n_pixels * 4, 0);
+		for (int p = 0; p < n_pixels; p++)
 		{
-			col.set(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
-
-			// skip colours that don't match exactly to the palette
-			col.index = pal->nearestColour(col);
-			if (!col.equals(pal->colour(col.index)))
+			// No need to process transparent pixels
+			if (mask && mask[p] == 0)
 				continue;
+
+			const auto& col = lut->colour[data[p]];
+			const auto  q   = p * 4;
+			newdata[q + 0]  = col.r;
+			newdata[q + 1]  = col.g;
+			newdata[q + 2]  = col.b;
+			newdata[q + 3]  = mask ? mask[p] : col.a;
 		}
 
-		col = tr->translate(col, pal);
+		clearData(true);
+		data_.importMem(newdata.data(), newdata.size());
+		type_ = Type::RGBA;
+	}
 
-		if (truecolor)
+	// Truecolour
+	else
+	{
+		// Only colours that match the palette exactly are translated, so map
+		// each palette colour to its (first) index rather than searching the
+		// palette for every pixel
+		std::unordered_map<uint32_t, uint8_t> pal_indices;
+		for (int a = 255; a >= 0; a--)
 		{
-			q              = p * 4;
-			newdata[q + 0] = col.r;
-			newdata[q + 1] = col.g;
-			newdata[q + 2] = col.b;
-			newdata[q + 3] = mask_.hasData() ? mask_[p] : col.a;
+			const auto col = pal->colour(a);
+			pal_indices[col.r << 16 | col.g << 8 | col.b] = a;
 		}
-		else
-			data_[p] = col.index;
-	}
 
-	if (truecolor && type_ == Type::PalMask)
-	{
-		clearData(true);
-		data_.importMem(newdata, width_ * height_ * 4);
-		type_ = Type::RGBA;
+		for (int p = 0; p < n_pixels; p++)
+		{
+			// No need to process transparent pixels
+			if (mask && mask[p] == 0)
+				continue;
+
+			const auto q     = p * 4;
+			const auto index = pal_indices.find(data[q] << 16 | data[q + 1] << 8 | data[q + 2]);
+			if (index == pal_indices.end())
+				continue;
+
+			const auto& col = lut->colour[index->second];
+			data[q + 0]     = col.r;
+			data[q + 1]     = col.g;
+			data[q + 2]     = col.b;
+			if (mask)
+				data[q + 3] = mask[p];
+		}
 	}
 
 	return true;
@@ -1434,58 +1459,7 @@ bool SImage::drawPixel(int x, int y, ColRGBA colour, DrawProps& properties, Pale
 		d_colour = pal->colour(data_[p]);
 	else
 		d_colour.set(data_[p], data_[p + 1], data_[p + 2], data_[p + 3]);
-	const float alpha = static_cast<float>(colour.a) / 255.0f;
-
-	// Additive blending
-	if (properties.blend == BlendType::Add)
-	{
-		d_colour.set(
-			math::clamp(d_colour.r + colour.r * alpha, 0, 255),
-			math::clamp(d_colour.g + colour.g * alpha, 0, 255),
-			math::clamp(d_colour.b + colour.b * alpha, 0, 255),
-			math::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Subtractive blending
-	else if (properties.blend == BlendType::Subtract)
-	{
-		d_colour.set(
-			math::clamp(d_colour.r - colour.r * alpha, 0, 255),
-			math::clamp(d_colour.g - colour.g * alpha, 0, 255),
-			math::clamp(d_colour.b - colour.b * alpha, 0, 255),
-			math::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Reverse-Subtractive blending
-	else if (properties.blend == BlendType::ReverseSubtract)
-	{
-		d_colour.set(
-			math::clamp((-d_colour.r) + colour.r * alpha, 0, 255),
-			math::clamp((-d_colour.g) + colour.g * alpha, 0, 255),
-			math::clamp((-d_colour.b) + colour.b * alpha, 0, 255),
-			math::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// 'Modulate' blending
-	else if (properties.blend == BlendType::Modulate)
-	{
-		d_colour.set(
-			math::clamp(colour.r * static_cast<double>(d_colour.r) / 255., 0, 255),
-			math::clamp(colour.g * static_cast<double>(d_colour.g) / 255., 0, 255),
-			math::clamp(colour.b * static_cast<double>(d_colour.b) / 255., 0, 255),
-			math::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Normal blending (or unknown blend type)
-	else
-	{
-		const float inv_alpha = 1.0f - alpha;
-		d_colour.set(
-			d_colour.r * inv_alpha + colour.r * alpha,
-			d_colour.g * inv_alpha + colour.g * alpha,
-			d_colour.b * inv_alpha + colour.b * alpha,
-			math::clamp(d_colour.a + colour.a, 0, 255));
-	}
+	gfx::blendColour(d_colour, colour, properties.blend);
 
 	// Apply new colour
 	if (type_ == Type::PalMask)
@@ -1518,6 +1492,50 @@ bool SImage::drawImage(SImage& img, int x_pos, int y_pos, DrawProps& properties,
 	if (has_palette_ || !pal_dest)
 		pal_dest = &palette_;
 
+	// Blend whole rows at once if drawing onto an RGBA image
+	if (type_ == Type::RGBA && img.type_ != Type::Unknown)
+	{
+		// Clip source image area to this image
+		const int x_start = std::max(0, -x_pos);
+		const int x_end   = std::min(img.width_, width_ - x_pos);
+		const int y_start = std::max(0, -y_pos);
+		const int y_end   = std::min(img.height_, height_ - y_pos);
+		if (x_start >= x_end || y_start >= y_end)
+			return true;
+
+		// Get source palette as RGBA
+		uint8_t pal_rgba[256 * 4];
+		if (img.type_ == Type::PalMask)
+			for (unsigned c = 0; c < 256; ++c)
+				pal_src->colour(c).write(pal_rgba + c * 4);
+
+		const auto      count = static_cast<unsigned>(x_end - x_start);
+		vector<uint8_t> row(img.type_ == Type::RGBA ? 0 : count * 4);
+		for (int y = y_start; y < y_end; y++)
+		{
+			// Get source row as RGBA
+			const unsigned sp  = y * img.width_ + x_start;
+			const uint8_t* src = row.data();
+			if (img.type_ == Type::RGBA)
+				src = img.data_.data() + sp * 4;
+			else if (img.type_ == Type::PalMask)
+			{
+				for (unsigned x = 0; x < count; x++)
+				{
+					memcpy(row.data() + x * 4, pal_rgba + img.data_[sp + x] * 4, 3);
+					row[x * 4 + 3] = img.mask_[sp + x];
+				}
+			}
+			else
+				for (unsigned x = 0; x < count; x++)
+					memset(row.data() + x * 4, img.data_[sp + x], 4);
+
+			gfx::blendRowRGBA(data_.data() + ((y + y_pos) * width_ + x_start + x_pos) * 4, src, count, properties);
+		}
+
+		return true;
+	}
+
 	// Go through pixels
 	const unsigned s_stride = img.stride();
 	const uint8_t  s_bpp    = img.bpp();
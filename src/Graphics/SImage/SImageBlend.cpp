@@ -0,0 +1,391 @@
+
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    SImageBlend.cpp
+// Description: Pixel blending functions for SImage drawing. Rows of RGBA
+//              pixels are blended with SSE2 or AVX2 where available, using the
+//              same float operations (in the same order) as the scalar path so
+//              that the results are identical
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "SImageBlend.h"
+#include "Utility/MathStuff.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMAGE_BLEND_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMAGE_BLEND_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace slade;
+using BlendType = SImage::BlendType;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns source alpha [a] adjusted for the draw properties [props]
+// -----------------------------------------------------------------------------
+inline uint8_t sourceAlpha(uint8_t a, const SImage::DrawProps& props)
+{
+	return props.src_alpha ? static_cast<uint8_t>(a * props.alpha) : static_cast<uint8_t>(255 * props.alpha);
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto [dest] one at a time
+// -----------------------------------------------------------------------------
+void blendRowScalar(uint8_t* dest, const uint8_t* src, unsigned count, const SImage::DrawProps& props)
+{
+	for (unsigned a = 0; a < count; ++a, dest += 4, src += 4)
+	{
+		// Skip if source pixel is fully transparent
+		if (src[3] == 0)
+			continue;
+
+		ColRGBA colour(src[0], src[1], src[2], sourceAlpha(src[3], props));
+		if (colour.a == 0)
+			continue;
+
+		ColRGBA d_colour(dest[0], dest[1], dest[2], dest[3]);
+		gfx::blendColour(d_colour, colour, props.blend);
+		d_colour.write(dest);
+	}
+}
+
+#ifdef SIMAGE_BLEND_SSE2
+// -----------------------------------------------------------------------------
+// Blends source pixel [s] onto dest pixel [d] (both as 32-bit RGBA channels)
+// and returns the result. Each operation matches the scalar version in
+// gfx::blendColour, so results are identical
+// -----------------------------------------------------------------------------
+template<BlendType Blend> __m128i blendPixelSSE2(__m128i d, __m128i s, __m128 prop_alpha, bool src_alpha)
+{
+	const __m128  zero       = _mm_setzero_ps();
+	const __m128  max        = _mm_set1_ps(255.0f);
+	const __m128i alpha_lane = _mm_set_epi32(-1, 0, 0, 0);
+
+	const __m128 df = _mm_cvtepi32_ps(d);
+	const __m128 sf = _mm_cvtepi32_ps(s);
+
+	// Source alpha, adjusted for draw properties and broadcast to all channels
+	const __m128  sa_src = src_alpha ? _mm_shuffle_ps(sf, sf, 0xFF) : max;
+	const __m128i sa     = _mm_cvttps_epi32(_mm_mul_ps(sa_src, prop_alpha));
+	const __m128  saf    = _mm_cvtepi32_ps(sa);
+	const __m128  alpha  = _mm_div_ps(saf, max);
+
+	// Blend colour channels
+	__m128 rgb;
+	if constexpr (Blend == BlendType::Add)
+		rgb = _mm_add_ps(df, _mm_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::Subtract)
+		rgb = _mm_sub_ps(df, _mm_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::ReverseSubtract)
+		rgb = _mm_add_ps(_mm_sub_ps(zero, df), _mm_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::Modulate)
+		rgb = _mm_div_ps(_mm_mul_ps(sf, df), max);
+	else
+		rgb = _mm_add_ps(_mm_mul_ps(df, _mm_sub_ps(_mm_set1_ps(1.0f), alpha)), _mm_mul_ps(sf, alpha));
+	const __m128i rgb_i = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(rgb, zero), max));
+
+	// Alpha channel is always added
+	const __m128i a_i = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(df, saf), max));
+	const __m128i res = _mm_or_si128(_mm_andnot_si128(alpha_lane, rgb_i), _mm_and_si128(alpha_lane, a_i));
+
+	// Keep the dest pixel if the source is (or becomes) fully transparent
+	const __m128i keep = _mm_or_si128(
+		_mm_cmpeq_epi32(sa, _mm_setzero_si128()), _mm_cmpeq_epi32(_mm_shuffle_epi32(s, 0xFF), _mm_setzero_si128()));
+	return _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, res));
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto [dest], 4 pixels at a time with
+// SSE2. Returns the number of pixels blended
+// -----------------------------------------------------------------------------
+template<BlendType Blend>
+unsigned blendRowSSE2(uint8_t* dest, const uint8_t* src, unsigned count, const SImage::DrawProps& props)
+{
+	const __m128i zero       = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+	const __m128  prop_alpha = _mm_set1_ps(props.alpha);
+
+	unsigned a = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + a * 4));
+
+		// Skip if all source pixels are fully transparent
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero)) == 0xFFFF)
+			continue;
+
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + a * 4));
+
+		// Expand to 32-bit channels
+		const __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+		const __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+		const __m128i d_lo = _mm_unpacklo_epi8(d, zero);
+		const __m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+		const __m128i r0 = blendPixelSSE2<Blend>(
+			_mm_unpacklo_epi16(d_lo, zero), _mm_unpacklo_epi16(s_lo, zero), prop_alpha, props.src_alpha);
+		const __m128i r1 = blendPixelSSE2<Blend>(
+			_mm_unpackhi_epi16(d_lo, zero), _mm_unpackhi_epi16(s_lo, zero), prop_alpha, props.src_alpha);
+		const __m128i r2 = blendPixelSSE2<Blend>(
+			_mm_unpacklo_epi16(d_hi, zero), _mm_unpacklo_epi16(s_hi, zero), prop_alpha, props.src_alpha);
+		const __m128i r3 = blendPixelSSE2<Blend>(
+			_mm_unpackhi_epi16(d_hi, zero), _mm_unpackhi_epi16(s_hi, zero), prop_alpha, props.src_alpha);
+
+		// Pack back to 8-bit channels
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + a * 4), packed);
+	}
+
+	return a;
+}
+#endif
+
+#ifdef SIMAGE_BLEND_AVX2
+// -----------------------------------------------------------------------------
+// Loads 2 RGBA pixels from [p], expanded to 32-bit channels
+// -----------------------------------------------------------------------------
+__attribute__((target("avx2"))) inline __m256i load2(const uint8_t* p)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+// -----------------------------------------------------------------------------
+// AVX2 version of blendPixelSSE2, blends two pixels at once
+// -----------------------------------------------------------------------------
+template<BlendType Blend>
+__attribute__((target("avx2"))) __m256i blendPixelsAVX2(__m256i d, __m256i s, __m256 prop_alpha, bool src_alpha)
+{
+	const __m256  zero       = _mm256_setzero_ps();
+	const __m256  max        = _mm256_set1_ps(255.0f);
+	const __m256i alpha_lane = _mm256_set_epi32(-1, 0, 0, 0, -1, 0, 0, 0);
+
+	const __m256 df = _mm256_cvtepi32_ps(d);
+	const __m256 sf = _mm256_cvtepi32_ps(s);
+
+	// Source alpha, adjusted for draw properties and broadcast to all channels
+	const __m256  sa_src = src_alpha ? _mm256_shuffle_ps(sf, sf, 0xFF) : max;
+	const __m256i sa     = _mm256_cvttps_epi32(_mm256_mul_ps(sa_src, prop_alpha));
+	const __m256  saf    = _mm256_cvtepi32_ps(sa);
+	const __m256  alpha  = _mm256_div_ps(saf, max);
+
+	// Blend colour channels
+	__m256 rgb;
+	if constexpr (Blend == BlendType::Add)
+		rgb = _mm256_add_ps(df, _mm256_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::Subtract)
+		rgb = _mm256_sub_ps(df, _mm256_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::ReverseSubtract)
+		rgb = _mm256_add_ps(_mm256_sub_ps(zero, df), _mm256_mul_ps(sf, alpha));
+	else if constexpr (Blend == BlendType::Modulate)
+		rgb = _mm256_div_ps(_mm256_mul_ps(sf, df), max);
+	else
+		rgb = _mm256_add_ps(
+			_mm256_mul_ps(df, _mm256_sub_ps(_mm256_set1_ps(1.0f), alpha)), _mm256_mul_ps(sf, alpha));
+	const __m256i rgb_i = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(rgb, zero), max));
+
+	// Alpha channel is always added
+	const __m256i a_i = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(df, saf), max));
+	const __m256i res = _mm256_blendv_epi8(rgb_i, a_i, alpha_lane);
+
+	// Keep the dest pixel if the source is (or becomes) fully transparent
+	const __m256i keep = _mm256_or_si256(
+		_mm256_cmpeq_epi32(sa, _mm256_setzero_si256()),
+		_mm256_cmpeq_epi32(_mm256_shuffle_epi32(s, 0xFF), _mm256_setzero_si256()));
+	return _mm256_blendv_epi8(res, d, keep);
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto [dest], 8 pixels at a time with
+// AVX2. Returns the number of pixels blended
+// -----------------------------------------------------------------------------
+template<BlendType Blend>
+__attribute__((target("avx2"))) unsigned blendRowAVX2(
+	uint8_t*                  dest,
+	const uint8_t*            src,
+	unsigned                  count,
+	const SImage::DrawProps& props)
+{
+	const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+	const __m256i order      = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	const __m256  prop_alpha = _mm256_set1_ps(props.alpha);
+
+	unsigned a = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		const auto s_ptr = src + a * 4;
+		const auto d_ptr = dest + a * 4;
+
+		// Skip if all source pixels are fully transparent
+		const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s_ptr));
+		if (_mm256_testz_si256(s, alpha_mask))
+			continue;
+
+		const __m256i r01 = blendPixelsAVX2<Blend>(load2(d_ptr), load2(s_ptr), prop_alpha, props.src_alpha);
+		const __m256i r23 = blendPixelsAVX2<Blend>(load2(d_ptr + 8), load2(s_ptr + 8), prop_alpha, props.src_alpha);
+		const __m256i r45 = blendPixelsAVX2<Blend>(load2(d_ptr + 16), load2(s_ptr + 16), prop_alpha, props.src_alpha);
+		const __m256i r67 = blendPixelsAVX2<Blend>(load2(d_ptr + 24), load2(s_ptr + 24), prop_alpha, props.src_alpha);
+
+		// Pack back to 8-bit channels. Packing works within 128-bit lanes, so
+		// the pixels end up as 0,2,4,6 | 1,3,5,7 and need to be reordered
+		const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(r01, r23), _mm256_packs_epi32(r45, r67));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(d_ptr), _mm256_permutevar8x32_epi32(packed, order));
+	}
+
+	return a;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the CPU supports AVX2
+// -----------------------------------------------------------------------------
+bool hasAVX2()
+{
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+	return has_avx2;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto [dest] with [Blend], using the
+// widest SIMD instructions available and the scalar version for the rest
+// -----------------------------------------------------------------------------
+template<BlendType Blend>
+void blendRow(uint8_t* dest, const uint8_t* src, unsigned count, const SImage::DrawProps& props)
+{
+	unsigned done = 0;
+
+#ifdef SIMAGE_BLEND_AVX2
+	if (hasAVX2())
+		done = blendRowAVX2<Blend>(dest, src, count, props);
+#endif
+#ifdef SIMAGE_BLEND_SSE2
+	done += blendRowSSE2<Blend>(dest + done * 4, src + done * 4, count - done, props);
+#endif
+
+	blendRowScalar(dest + done * 4, src + done * 4, count - done, props);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Gfx Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Blends [colour] onto [dest] using [blend]. The alpha of [colour] should
+// already be adjusted for the draw properties (see SImage::drawPixel)
+// -----------------------------------------------------------------------------
+void gfx::blendColour(ColRGBA& dest, const ColRGBA& colour, SImage::BlendType blend)
+{
+	const float alpha = static_cast<float>(colour.a) / 255.0f;
+
+	// Additive blending
+	if (blend == BlendType::Add)
+	{
+		dest.set(
+			math::clamp(dest.r + colour.r * alpha, 0, 255),
+			math::clamp(dest.g + colour.g * alpha, 0, 255),
+			math::clamp(dest.b + colour.b * alpha, 0, 255),
+			math::clamp(dest.a + colour.a, 0, 255));
+	}
+
+	// Subtractive blending
+	else if (blend == BlendType::Subtract)
+	{
+		dest.set(
+			math::clamp(dest.r - colour.r * alpha, 0, 255),
+			math::clamp(dest.g - colour.g * alpha, 0, 255),
+			math::clamp(dest.b - colour.b * alpha, 0, 255),
+			math::clamp(dest.a + colour.a, 0, 255));
+	}
+
+	// Reverse-Subtractive blending
+	else if (blend == BlendType::ReverseSubtract)
+	{
+		dest.set(
+			math::clamp((-dest.r) + colour.r * alpha, 0, 255),
+			math::clamp((-dest.g) + colour.g * alpha, 0, 255),
+			math::clamp((-dest.b) + colour.b * alpha, 0, 255),
+			math::clamp(dest.a + colour.a, 0, 255));
+	}
+
+	// 'Modulate' blending
+	else if (blend == BlendType::Modulate)
+	{
+		dest.set(
+			math::clamp(colour.r * static_cast<double>(dest.r) / 255., 0, 255),
+			math::clamp(colour.g * static_cast<double>(dest.g) / 255., 0, 255),
+			math::clamp(colour.b * static_cast<double>(dest.b) / 255., 0, 255),
+			math::clamp(dest.a + colour.a, 0, 255));
+	}
+
+	// Normal blending (or unknown blend type)
+	else
+	{
+		const float inv_alpha = 1.0f - alpha;
+		dest.set(
+			dest.r * inv_alpha + colour.r * alpha,
+			dest.g * inv_alpha + colour.g * alpha,
+			dest.b * inv_alpha + colour.b * alpha,
+			math::clamp(dest.a + colour.a, 0, 255));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Blends [count] RGBA pixels from [src] onto the RGBA pixels at [dest] with
+// the blending options in [props]
+// -----------------------------------------------------------------------------
+void gfx::blendRowRGBA(uint8_t* dest, const uint8_t* src, unsigned count, const SImage::DrawProps& props)
+{
+	switch (props.blend)
+	{
+	case BlendType::Add: blendRow<BlendType::Add>(dest, src, count, props); break;
+	case BlendType::Subtract: blendRow<BlendType::Subtract>(dest, src, count, props); break;
+	case BlendType::ReverseSubtract: blendRow<BlendType::ReverseSubtract>(dest, src, count, props); break;
+	case BlendType::Modulate: blendRow<BlendType::Modulate>(dest, src, count, props); break;
+	default: blendRow<BlendType::Normal>(dest, src, count, props); break;
+	}
+}
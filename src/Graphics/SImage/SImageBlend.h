@@ -0,0 +1,15 @@
+#pragma once
+
+#include "SImage.h"
+
+namespace slade::gfx
+{
+// Blends [colour] (alpha already adjusted for the draw properties) onto [dest]
+// using [blend]
+void blendColour(ColRGBA& dest, const ColRGBA& colour, SImage::BlendType blend);
+
+// Blends [count] RGBA pixels from [src] onto the RGBA pixels at [dest], with
+// the blending options in [props]. Gives exactly the same result as drawing
+// each pixel with SImage::drawPixel, but uses SIMD (SSE2/AVX2) where available
+void blendRowRGBA(uint8_t* dest, const uint8_t* src, unsigned count, const SImage::DrawProps& props);
+} // namespace slade::gfx
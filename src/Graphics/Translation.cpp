@@ -47,6 +47,7 @@
 #include "Translation.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "General/Misc.h"
 #include "MainEditor/MainEditor.h"
 #include "Palette/Palette.h"
 #include "Utility/StringUtils.h"
@@ -641,6 +642,117 @@ ColRGBA Translation::translate(const ColRGBA& col, Palette* pal)
 	return colour;
 }
 
+// -----------------------------------------------------------------------------
+// Returns a lookup table of this translation applied to each colour in [pal].
+// The table is only recompiled if the translation or palette has changed since
+// it was last compiled, so this is much faster than calling translate for each
+// pixel of an image. Safe to call from multiple threads, the returned table is
+// never modified (a changed table is compiled as a new one)
+// -----------------------------------------------------------------------------
+shared_ptr<const Translation::LookupTable> Translation::lookupTable(Palette* pal)
+{
+	if (pal == nullptr)
+		pal = maineditor::currentPalette();
+
+	// Ranges can be modified directly so there's no simple way to track
+	// changes, compare hashes of the ranges and palette colours instead
+	auto trans_hash = stateHash();
+	auto pal_hash   = misc::hash64(
+		reinterpret_cast<const uint8_t*>(pal->colours().data()), pal->colours().size() * sizeof(ColRGBA));
+
+	std::lock_guard lock(lut_mutex_);
+
+	// Check if the existing table is still valid
+	if (lut_ && trans_hash == lut_trans_hash_ && pal_hash == lut_pal_hash_)
+		return lut_;
+
+	// Compile table
+	auto lut = std::make_shared<LookupTable>();
+	for (unsigned a = 0; a < 256; ++a)
+	{
+		const auto col = translate(pal->colour(a), pal);
+		lut->colour[a] = col;
+		lut->index[a]  = col.index >= 0 ? col.index : a;
+	}
+	lut_            = lut;
+	lut_trans_hash_ = trans_hash;
+	lut_pal_hash_   = pal_hash;
+
+	return lut_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a hash of everything that affects the result of this translation
+// -----------------------------------------------------------------------------
+uint64_t Translation::stateHash() const
+{
+	// Add each value's bytes to a buffer, fields are added individually so
+	// that struct padding isn't hashed
+	vector<uint8_t> state;
+	auto            add = [&state](const auto& value)
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(&value);
+		state.insert(state.end(), bytes, bytes + sizeof(value));
+	};
+	auto add_colour = [&add](const ColRGBA& col)
+	{
+		add(col.r);
+		add(col.g);
+		add(col.b);
+		add(col.a);
+	};
+
+	state.insert(state.end(), built_in_name_.begin(), built_in_name_.end());
+	add(desat_amount_);
+	for (const auto& tr : translations_)
+	{
+		add(tr->type_);
+		add(tr->range_.start);
+		add(tr->range_.end);
+		switch (tr->type_)
+		{
+		case TransRange::Type::Palette:
+		{
+			auto pr = dynamic_cast<TransRangePalette*>(tr.get());
+			add(pr->dest_range_.start);
+			add(pr->dest_range_.end);
+			break;
+		}
+		case TransRange::Type::Colour:
+		{
+			auto cr = dynamic_cast<TransRangeColour*>(tr.get());
+			add_colour(cr->col_start_);
+			add_colour(cr->col_end_);
+			break;
+		}
+		case TransRange::Type::Desat:
+		{
+			auto dr = dynamic_cast<TransRangeDesat*>(tr.get());
+			add(dr->rgb_start_);
+			add(dr->rgb_end_);
+			break;
+		}
+		case TransRange::Type::Blend: add_colour(dynamic_cast<TransRangeBlend*>(tr.get())->colour_); break;
+		case TransRange::Type::Tint:
+		{
+			auto tr_tint = dynamic_cast<TransRangeTint*>(tr.get());
+			add_colour(tr_tint->colour_);
+			add(tr_tint->amount_);
+			break;
+		}
+		case TransRange::Type::Special:
+		{
+			auto& special = dynamic_cast<TransRangeSpecial*>(tr.get())->special_;
+			state.insert(state.end(), special.begin(), special.end());
+			state.push_back(0);
+			break;
+		}
+		}
+	}
+
+	return misc::hash64(state.data(), state.size());
+}
+
 // -----------------------------------------------------------------------------
 // Adds a new translation range of [type] at [pos] in the list, with the range
 // spanning from [range_start] to [range_end]
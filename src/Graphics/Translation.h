@@ -1,5 +1,6 @@
 #pragma once
 #include "Utility/Colour.h"
+#include <mutex>
 
 namespace slade
 {
@@ -259,6 +260,13 @@ class Palette;
 class Translation
 {
 public:
+	// Translated colour and palette index for each index of a palette
+	struct LookupTable
+	{
+		uint8_t index[256];
+		ColRGBA colour[256];
+	};
+
 	Translation()  = default;
 	~Translation() = default;
 
@@ -280,7 +288,8 @@ public:
 	void setBuiltInName(string_view name) { built_in_name_ = name; }
 	void setDesaturationAmount(uint8_t amount) { desat_amount_ = amount; }
 
-	ColRGBA translate(const ColRGBA& col, Palette* pal = nullptr);
+	ColRGBA                       translate(const ColRGBA& col, Palette* pal = nullptr);
+	shared_ptr<const LookupTable> lookupTable(Palette* pal = nullptr);
 
 	TransRange* addRange(TransRange::Type type, int pos = -1, int range_start = 0, int range_end = 0);
 	void        removeRange(int pos);
@@ -293,5 +302,15 @@ private:
 	vector<unique_ptr<TransRange>> translations_;
 	string                         built_in_name_;
 	uint8_t                        desat_amount_ = 0;
+
+	// Lookup table compiled from this translation, and hashes of the ranges +
+	// palette it was compiled for. Images can be translated on worker threads,
+	// so it is only accessed with lut_mutex_ locked
+	shared_ptr<const LookupTable> lut_;
+	uint64_t                      lut_trans_hash_ = 0;
+	uint64_t                      lut_pal_hash_   = 0;
+	std::mutex                    lut_mutex_;
+
+	uint64_t stateHash() const;
 };
 } // namespace slade
@@ -41,8 +41,12 @@
 #include "Archive/Formats/DirArchive.h"
 #include "Archive/Formats/WadArchive.h"
 #include "General/Console.h"
+#include "General/Jobs.h"
 #include "General/ResourceManager.h"
+#include "General/UI.h"
 #include "Graphics/CTexture/TextureXList.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
 #include "SLADEMap/MapFormat/Doom64MapFormat.h"
@@ -50,12 +54,15 @@
 #include "SLADEMap/MapFormat/HexenMapFormat.h"
 #include "SLADEMap/MapFormat/Doom32XMapFormat.h"
 #include "SLADEMap/MapObject/MapSector.h"
+#include "SLADEMap/MapPreview.h"
 #include "UI/Dialogs/ExtMessageDialog.h"
 #include "UI/WxUtils.h"
 #include "Utility/FileUtils.h"
 #include "Utility/SFileDialog.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
+#include <atomic>
+#include <chrono>
 
 using namespace slade;
 
@@ -115,8 +122,8 @@ bool archiveoperations::save(Archive& archive)
 		{
 			auto   messages = log::since(time);
 			string msg_log_str;
-			for (const auto* msg : messages)
-				msg_log_str += msg->formattedMessageLine() + "\n";
+			for (const auto& msg : messages)
+				msg_log_str += msg.formattedMessageLine() + "\n";
 
 			ExtMessageDialog dlg(maineditor::windowWx(), "Directory Save Issues");
 			dlg.CenterOnParent();
@@ -2168,6 +2175,99 @@ bool archiveoperations::checkDuplicateZDoomPatches(Archive* archive)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Renders a [size]x[size] preview image of each map in [archive] to a png file
+// named after the map in [dir] (if empty, a directory named after the archive
+// in the user 'map_thumbnails' directory).
+// Maps are parsed and rendered on multiple threads, returns the number of
+// thumbnails written
+// -----------------------------------------------------------------------------
+unsigned archiveoperations::generateMapThumbnails(Archive* archive, int size, string_view dir)
+{
+	if (!archive)
+		return 0;
+
+	// Get output directory
+	string out_dir{ dir };
+	if (out_dir.empty())
+		out_dir = app::path(
+			fmt::format("map_thumbnails/{}", strutil::Path::fileNameOf(archive->filename(false), false)),
+			app::Dir::User);
+	if (!fileutil::dirExists(out_dir) && !fileutil::createDir(out_dir))
+	{
+		log::error("Unable to create map thumbnail directory {}", out_dir);
+		return 0;
+	}
+
+	// Read map data (has to be done on the main thread). Maps in wads within
+	// the archive (eg. maps/*.wad in a pk3) are named after the wad entry,
+	// since the map inside is often just MAP01. Names are made unique (case
+	// insensitively) so that no two maps are written to the same file
+	vector<MapPreview::Source> sources;
+	vector<string>             filenames;
+	std::set<string>           used_names;
+	for (auto& map : archive->detectMaps())
+	{
+		MapPreview::Source source;
+		if (!MapPreview::readSource(map, source))
+			continue;
+
+		string name = source.name;
+		if (auto head = map.head.lock(); head && map.archive)
+		{
+			name = head->nameNoExt();
+			if (!strutil::equalCI(name, source.name))
+				name += "_" + source.name;
+		}
+		auto unique_name = name;
+		for (int n = 2; !used_names.insert(strutil::lower(unique_name)).second; ++n)
+			unique_name = fmt::format("{}_{}", name, n);
+
+		filenames.push_back(fmt::format("{}/{}.png", out_dir, unique_name));
+		sources.push_back(std::move(source));
+	}
+	const auto total = static_cast<unsigned>(sources.size());
+	if (total == 0)
+		return 0;
+
+	// Render options are also read on the main thread (colour config). Each map
+	// is rendered on a single thread since there are multiple maps in flight
+	auto options    = MapPreview::imageOptions(size, size);
+	options.threads = 1;
+
+	// Parse, render and write thumbnails on worker threads
+	auto                  start   = std::chrono::steady_clock::now();
+	auto                  png     = SIFormat::getFormat("png");
+	std::atomic<unsigned> written = 0;
+	ui::showSplash("Generating map thumbnails...", true);
+	jobs::parallelFor(
+		total,
+		[&](unsigned index)
+		{
+			auto&      source = sources[index];
+			MapPreview preview;
+			SImage     image;
+			MemChunk   data;
+			if (preview.load(source) && preview.render(image, options) && png->saveImage(image, data)
+				&& data.exportFile(filenames[index]))
+				++written;
+			else
+				log::warning("Unable to create thumbnail {}", filenames[index]);
+		},
+		[&](unsigned done)
+		{
+			ui::setSplashProgressMessage(fmt::format("{} of {}", done, total));
+			ui::setSplashProgress(static_cast<float>(done) / static_cast<float>(total));
+			return true;
+		});
+	ui::hideSplash();
+
+	auto time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	log::info("Wrote {} of {} map thumbnails to {} in {:.0f}ms", written.load(), total, out_dir, time_ms);
+
+	return written;
+}
+
 CONSOLE_COMMAND(test_cleantex, 0, false)
 {
 	auto current = maineditor::currentArchive();
@@ -2393,6 +2493,21 @@ CONSOLE_COMMAND(replacethings, 2, true)
 	}
 }
 
+CONSOLE_COMMAND(map_thumbnails, 0, true)
+{
+	auto current = maineditor::currentArchive();
+	int  size    = 256;
+
+	if (!args.empty() && !strutil::toInt(args[0], size))
+	{
+		log::console("Usage: map_thumbnails [size] [directory]");
+		return;
+	}
+
+	if (current)
+		archiveoperations::generateMapThumbnails(current, size, args.size() > 1 ? args[1] : "");
+}
+
 CONSOLE_COMMAND(convertmapchex1to3, 0, false)
 {
 	Archive* current    = maineditor::currentArchive();
@@ -19,6 +19,8 @@ void removeEntriesUnchangedFromIWAD(Archive* archive);
 bool checkOverriddenEntriesInIWAD(Archive* archive);
 bool checkZDoomOverriddenEntriesInIWAD(Archive* archive);
 
+unsigned generateMapThumbnails(Archive* archive, int size = 256, string_view dir = {});
+
 // Search and replace in maps
 size_t replaceThings(Archive* archive, int oldtype, int newtype);
 size_t replaceTextures(
@@ -42,10 +42,15 @@
 #include "Archive/Formats/WadArchive.h"
 #include "BinaryControlLump.h"
 #include "General/Console.h"
+#include "General/Jobs.h"
 #include "General/Misc.h"
+#include "General/UI.h"
+#include "General/UndoRedo.h"
 #include "Graphics/Graphics.h"
+#include "Graphics/PNGOptimizer.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "MainEditor/MainEditor.h"
+#include "MainEditor/UI/ArchivePanel.h"
 #include "SLADEWxApp.h"
 #include "UI/Dialogs/ExtMessageDialog.h"
 #include "UI/Dialogs/Preferences/PreferencesDialog.h"
@@ -54,6 +59,7 @@
 #include "Utility/Memory.h"
 #include "Utility/SFileDialog.h"
 #include "Utility/Tokenizer.h"
+#include <chrono>
 
 using namespace slade;
 
@@ -72,6 +78,24 @@ CVAR(String, path_db2, "", CVar::Flag::Save)
 CVAR(Bool, acc_always_show_output, false, CVar::Flag::Save);
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if any of the external PNG optimizer paths are set up
+// -----------------------------------------------------------------------------
+bool pngToolsSetUp()
+{
+	auto valid = [](const string& path) { return !path.empty() && wxFileExists(path); };
+	return valid(path_pngcrush) || valid(path_pngout) || valid(path_deflopt);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // EntryOperations Namespace Functions
@@ -1184,9 +1208,10 @@ bool entryoperations::exportAsPNG(ArchiveEntry* entry, const wxString& filename)
 }
 
 // -----------------------------------------------------------------------------
-// Attempts to optimize [entry] using external PNG optimizers.
+// Attempts to optimize [entry] using the built-in PNG optimizer (if [builtin]
+// is true), then any external PNG optimizers that are set up.
 // -----------------------------------------------------------------------------
-bool entryoperations::optimizePNG(ArchiveEntry* entry)
+bool entryoperations::optimizePNG(ArchiveEntry* entry, bool builtin)
 {
 	// Check entry was given
 	if (!entry)
@@ -1203,16 +1228,31 @@ bool entryoperations::optimizePNG(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Check if the PNG tools path are set up, at least one of them should be
+	// Run built-in optimizer
+	bool optimized = false;
+	if (builtin)
+	{
+		MemChunk         out;
+		gfx::PNGOptStats stats;
+		optimized = gfx::optimizePNG(entry->data(), out, &stats) && entry->importMemChunk(out);
+		if (optimized)
+			log::info(
+				"PNG {} size {} =built-in=> {} ({:.1f}ms)",
+				entry->name(),
+				stats.old_size,
+				stats.new_size,
+				stats.time_ms);
+		else
+			log::info(1, "PNG {} not optimized: {}", entry->name(), global::error);
+	}
+
+	// Check if the PNG tools path are set up, if none are we're done
+	if (!pngToolsSetUp())
+		return optimized;
+
 	wxString pngpathc = path_pngcrush;
 	wxString pngpatho = path_pngout;
 	wxString pngpathd = path_deflopt;
-	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) && (pngpatho.IsEmpty() || !wxFileExists(pngpatho))
-		&& (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
-	{
-		log::error(1, "PNG tool paths not defined or invalid, no optimization done.");
-		return false;
-	}
 
 	// Save special chunks
 	bool          alphchunk     = gfx::pngGetalPh(entry->data());
@@ -1385,7 +1425,7 @@ bool entryoperations::optimizePNG(ArchiveEntry* entry)
 		entry->size());
 
 
-	if (!crushed && !outed && !errormessages.IsEmpty())
+	if (!optimized && !crushed && !outed && !errormessages.IsEmpty())
 	{
 		ExtMessageDialog dlg(nullptr, "Optimizing Report");
 		dlg.setMessage("The following issues were encountered while optimizing:");
@@ -1398,6 +1438,105 @@ bool entryoperations::optimizePNG(ArchiveEntry* entry)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Optimizes all PNG [entries] with the built-in PNG optimizer, on multiple
+// threads, then runs any external PNG optimizers that are set up on them.
+// If [undo_manager] is given, changes to entries are recorded to it
+// -----------------------------------------------------------------------------
+bool entryoperations::optimizePNGs(const vector<ArchiveEntry*>& entries, UndoManager* undo_manager)
+{
+	// Get PNG entries, copying their data since the optimizer can't work on
+	// entry data directly from other threads
+	vector<ArchiveEntry*> png_entries;
+	for (auto entry : entries)
+		if (entry->type()->formatId() == "img_png")
+			png_entries.push_back(entry);
+	const auto total = static_cast<unsigned>(png_entries.size());
+	if (total == 0)
+		return false;
+
+	struct PNGJob
+	{
+		MemChunk         data;
+		MemChunk         out;
+		gfx::PNGOptStats stats;
+		bool             optimized = false;
+		string           error;
+	};
+	vector<PNGJob> png_jobs(total);
+	for (unsigned a = 0; a < total; ++a)
+		png_jobs[a].data.importMem(png_entries[a]->rawData(), png_entries[a]->size());
+
+	// Optimize on worker threads
+	auto start = std::chrono::steady_clock::now();
+	ui::showSplash("Optimizing PNG images...", true);
+	jobs::parallelFor(
+		total,
+		[&](unsigned index)
+		{
+			auto& job     = png_jobs[index];
+			job.optimized = gfx::optimizePNG(job.data, job.out, &job.stats);
+			if (!job.optimized)
+				job.error = global::error;
+		},
+		[&](unsigned done)
+		{
+			ui::setSplashProgressMessage(fmt::format("{} of {}", done, total));
+			ui::setSplashProgress(static_cast<float>(done) / static_cast<float>(total));
+			return true;
+		});
+	ui::hideSplash();
+	auto time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Write optimized data back to entries
+	bool     external = pngToolsSetUp();
+	size_t   old_size = 0, new_size = 0;
+	unsigned count    = 0;
+	for (unsigned a = 0; a < total; ++a)
+	{
+		auto  entry = png_entries[a];
+		auto& job   = png_jobs[a];
+		old_size += job.stats.old_size;
+		new_size += job.stats.new_size;
+
+		if (undo_manager && (job.optimized || external))
+			undo_manager->recordUndoStep(std::make_unique<EntryDataUS>(entry));
+
+		if (job.optimized)
+		{
+			entry->importMemChunk(job.out);
+			++count;
+		}
+		else
+			log::info(1, "PNG {} not optimized: {}", entry->name(), job.error);
+	}
+
+	log::info(
+		"Optimized {} of {} PNGs: {} => {} bytes ({:.1f}% smaller) in {:.0f}ms",
+		count,
+		total,
+		old_size,
+		new_size,
+		old_size > 0 ? 100. * (old_size - new_size) / old_size : 0.,
+		time_ms);
+
+	// Run external optimizers
+	if (external)
+	{
+		ui::showSplash("Running external programs, please wait...", true);
+		for (unsigned a = 0; a < total; a++)
+		{
+			ui::setSplashProgressMessage(png_entries[a]->nameNoExt());
+			ui::setSplashProgress(static_cast<float>(a) / static_cast<float>(total));
+			if (optimizePNG(png_entries[a], false))
+				++count;
+		}
+		ui::hideSplash();
+	}
+
+	return count > 0;
+}
+
 // -----------------------------------------------------------------------------
 // Converts ANIMATED data in [entry] to ANIMDEFS format, written to [animdata]
 // -----------------------------------------------------------------------------
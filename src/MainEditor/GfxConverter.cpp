@@ -0,0 +1,320 @@
+
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    GfxConverter.cpp
+// Description: GfxConverter class, converts batches of images to other formats
+//              using a pool of worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "GfxConverter.h"
+#include "Archive/ArchiveEntry.h"
+#include "Archive/EntryType/EntryType.h"
+#include "General/Console.h"
+#include "General/Jobs.h"
+#include "General/Misc.h"
+#include "General/UndoRedo.h"
+#include "MainEditor/MainEditor.h"
+#include "MainEditor/UI/ArchivePanel.h"
+#include "Utility/StringUtils.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// GfxConverter Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the number of items that were successfully converted
+// -----------------------------------------------------------------------------
+unsigned GfxConverter::numConverted() const
+{
+	unsigned count = 0;
+	for (const auto& item : items_)
+		if (item->converted)
+			++count;
+
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] to be converted to [format] with [options], and saved with
+// [palette] if the format is paletted
+// -----------------------------------------------------------------------------
+GfxConverter::Item& GfxConverter::addEntry(
+	ArchiveEntry*                   entry,
+	SIFormat*                       format,
+	const SIFormat::ConvertOptions& options,
+	Palette*                        palette)
+{
+	auto& item   = *items_.emplace_back(std::make_unique<Item>());
+	item.entry   = entry;
+	item.format  = format;
+	item.options = options;
+	item.palette = palette;
+
+	// Check entry is an image
+	if (entry->type() == EntryType::unknownType())
+		EntryType::detectEntryType(*entry);
+	if (!entry->type()->extraProps().contains("image"))
+	{
+		item.error     = "Entry type is not a valid image";
+		item.processed = true;
+		return item;
+	}
+
+	// Some image types need info from the entry or its archive to load (or
+	// can't be detected from the data alone), so load those now
+	const auto& type_format = entry->type()->formatId();
+	if (strutil::startsWith(type_format, "font_") || strutil::startsWith(type_format, "img_jaguar_")
+		|| type_format == "img_raw")
+	{
+		if (!misc::loadImageFromEntry(&item.image, entry))
+		{
+			item.error     = global::error;
+			item.processed = true;
+		}
+
+		return item;
+	}
+
+	// Otherwise the image is decoded from a copy of the entry data when run
+	item.source.importMem(entry->rawData(), entry->size());
+	item.source_format = entry->type()->extraProps().getOr<string>("image_format", {});
+
+	return item;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [image] to be converted to [format] with [options], and saved with
+// [palette] if the format is paletted. The result is written to [entry] (if
+// given) in applyToEntries.
+// If [convert] is false, [image] is only encoded to [format] (ie. it has
+// already been converted)
+// -----------------------------------------------------------------------------
+GfxConverter::Item& GfxConverter::addImage(
+	const SImage&                   image,
+	ArchiveEntry*                   entry,
+	SIFormat*                       format,
+	const SIFormat::ConvertOptions& options,
+	Palette*                        palette,
+	bool                            convert)
+{
+	auto& item = *items_.emplace_back(std::make_unique<Item>());
+	item.image.copyImage(const_cast<SImage*>(&image));
+	item.entry   = entry;
+	item.format  = format;
+	item.options = options;
+	item.palette = palette;
+	item.convert = convert;
+
+	return item;
+}
+
+// -----------------------------------------------------------------------------
+// Processes all items that haven't been processed yet, on a pool of worker
+// threads. [progress] (if given) is called periodically from this thread, and
+// can cancel the conversion by returning false, in which case items that
+// weren't started are left unprocessed (see removeItems).
+// Returns false if the conversion was cancelled
+// -----------------------------------------------------------------------------
+bool GfxConverter::run(const ProgressFunc& progress)
+{
+	// Get items to process
+	vector<Item*> pending;
+	for (auto& item : items_)
+		if (!item->processed)
+			pending.push_back(item.get());
+	const auto total = static_cast<unsigned>(pending.size());
+	if (total == 0)
+		return true;
+
+	// Process items on worker threads, reporting progress until finished or
+	// cancelled
+	std::function<bool(unsigned)> report;
+	if (progress)
+		report = [&](unsigned done) { return progress(done, total); };
+	return jobs::parallelFor(total, [&](unsigned index) { processItem(*pending[index]); }, report);
+}
+
+// -----------------------------------------------------------------------------
+// Writes all converted images to their entries, processing any items that
+// haven't been processed yet first. If [undo_manager] is given, all entry
+// changes are recorded as a single undo level named [undo_name].
+// Returns the number of entries modified
+// -----------------------------------------------------------------------------
+unsigned GfxConverter::applyToEntries(UndoManager* undo_manager, string_view undo_name)
+{
+	run();
+
+	if (undo_manager)
+		undo_manager->beginRecord(undo_name);
+
+	unsigned count = 0;
+	for (auto& item : items_)
+	{
+		if (!item->converted || !item->entry)
+			continue;
+
+		if (undo_manager)
+			undo_manager->recordUndoStep(std::make_unique<EntryDataUS>(item->entry));
+
+		item->entry->importMemChunk(item->data);
+		EntryType::detectEntryType(*item->entry);
+		item->entry->setExtensionByType();
+		++count;
+	}
+
+	if (undo_manager)
+		undo_manager->endRecord(count > 0);
+
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// Runs the conversion pipeline for [item]: decodes the source data (if
+// needed), converts the image and encodes it to the target format.
+// Called from worker threads, so must not touch anything shared
+// -----------------------------------------------------------------------------
+void GfxConverter::processItem(Item& item)
+{
+	item.processed = true;
+
+	// Decode source image if needed
+	if (!item.image.isValid())
+	{
+		auto general = SIFormat::generalFormat();
+		if (!item.source.hasData()
+			|| (!item.image.open(item.source, 0, item.source_format)
+				&& !(general->isThisFormat(item.source) && general->loadImage(item.image, item.source))))
+		{
+			item.error = "Entry is not a known image format";
+			return;
+		}
+
+		item.source.clear();
+	}
+
+	// Check the image can be written to the target format
+	if (item.convert && item.format->canWrite(item.image) == SIFormat::Writable::No)
+	{
+		item.error = fmt::format("Image can't be written as {}", item.format->name());
+		return;
+	}
+
+	// Convert
+	if (item.convert)
+		item.format->convertWritable(item.image, item.options);
+
+	// Encode
+	if (!item.format->saveImage(item.image, item.data, item.palette))
+	{
+		item.error = fmt::format("Unable to write image as {}: {}", item.format->name(), global::error);
+		return;
+	}
+
+	item.converted = true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Converts the selected entries in the current archive to an image format.
+// Usage: gfx_convert <format id> [paletted|truecolour|alphamap]
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(gfx_convert, 1, true)
+{
+	auto format = SIFormat::getFormat(args[0]);
+	if (format == SIFormat::unknownFormat())
+	{
+		log::console(fmt::format("Unknown image format \"{}\"", args[0]));
+		return;
+	}
+
+	// Get pixel format to convert to
+	SIFormat::ConvertOptions opt;
+	opt.col_format = format->canWriteType(SImage::Type::PalMask) ? SImage::Type::PalMask : SImage::Type::RGBA;
+	if (args.size() > 1)
+	{
+		if (strutil::equalCI(args[1], "truecolour") || strutil::equalCI(args[1], "truecolor"))
+			opt.col_format = SImage::Type::RGBA;
+		else if (strutil::equalCI(args[1], "alphamap"))
+			opt.col_format = SImage::Type::AlphaMap;
+		else if (strutil::equalCI(args[1], "paletted"))
+			opt.col_format = SImage::Type::PalMask;
+	}
+	if (!format->canWriteType(opt.col_format))
+	{
+		log::console(fmt::format("Format \"{}\" can't be written with that pixel format", format->name()));
+		return;
+	}
+
+	auto selection = maineditor::currentEntrySelection();
+	if (selection.empty())
+	{
+		log::console("No entries selected");
+		return;
+	}
+
+	// Convert selected entries
+	GfxConverter converter;
+	for (auto entry : selection)
+	{
+		opt.pal_current = maineditor::currentPalette(entry);
+		opt.pal_target  = opt.pal_current;
+		converter.addEntry(entry, format, opt, opt.pal_target);
+	}
+	converter.run();
+
+	// Report any errors
+	for (unsigned a = 0; a < converter.numItems(); ++a)
+	{
+		const auto& item = converter.item(a);
+		if (!item.error.empty())
+			log::console(fmt::format("{}: {}", item.entry->name(), item.error));
+	}
+
+	// Write converted images to entries
+	auto panel = maineditor::currentArchivePanel();
+	auto count = converter.applyToEntries(panel ? panel->undoManager() : nullptr);
+	log::console(fmt::format("Converted {} of {} entries", count, selection.size()));
+}
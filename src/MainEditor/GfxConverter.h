@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+
+namespace slade
+{
+class UndoManager;
+
+// Converts a batch of images to other formats. The per-image pipeline
+// (decode -> convert -> encode) runs on a pool of worker threads, and the
+// converted data is written back to entries in one batch afterwards (as a
+// single undo level if an UndoManager is given)
+class GfxConverter
+{
+public:
+	struct Item
+	{
+		// Entry to write the converted image to (can be null)
+		ArchiveEntry* entry = nullptr;
+
+		// Source image, replaced with the converted image once processed
+		SImage image;
+
+		// Conversion settings
+		SIFormat*                format  = nullptr;
+		Palette*                 palette = nullptr; // Palette to save the converted image with
+		SIFormat::ConvertOptions options;
+		bool                     convert = true; // If false the image is already converted, just encode it
+
+		// Result
+		bool     processed = false;
+		bool     converted = false;
+		MemChunk data;
+		string   error;
+
+		// Source entry data, decoded on a worker thread if the image isn't
+		// already loaded
+		MemChunk source;
+		string   source_format;
+	};
+
+	// Called periodically on the thread that called run, with the number of
+	// items processed so far. Returning false cancels the conversion, leaving
+	// any items not yet started unprocessed
+	using ProgressFunc = std::function<bool(unsigned done, unsigned total)>;
+
+	GfxConverter()  = default;
+	~GfxConverter() = default;
+
+	unsigned    numItems() const { return items_.size(); }
+	Item&       item(unsigned index) { return *items_[index]; }
+	const Item& item(unsigned index) const { return *items_[index]; }
+	unsigned    numConverted() const;
+
+	Item& addEntry(
+		ArchiveEntry*                   entry,
+		SIFormat*                       format,
+		const SIFormat::ConvertOptions& options,
+		Palette*                        palette = nullptr);
+	Item& addImage(
+		const SImage&                   image,
+		ArchiveEntry*                   entry,
+		SIFormat*                       format,
+		const SIFormat::ConvertOptions& options,
+		Palette*                        palette = nullptr,
+		bool                            convert = true);
+
+	bool     run(const ProgressFunc& progress = {});
+	unsigned applyToEntries(UndoManager* undo_manager = nullptr, string_view undo_name = "Gfx Format Conversion");
+	void     clear() { items_.clear(); }
+	void     removeItems(unsigned from) { items_.resize(std::min<size_t>(from, items_.size())); }
+
+private:
+	vector<unique_ptr<Item>> items_;
+
+	static void processItem(Item& item);
+};
+} // namespace slade
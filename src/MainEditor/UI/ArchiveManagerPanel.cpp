@@ -70,6 +70,7 @@ CVAR(Bool, close_archive_with_tab, true, CVar::Flag::Save)
 CVAR(Int, am_current_tab, 0, CVar::Flag::Save)
 CVAR(Bool, am_file_browser_tab, false, CVar::Flag::Save)
 CVAR(Int, dir_archive_change_action, 2, CVar::Flag::Save) // 0=always ignore, 1=always apply, 2+=ask
+CVAR(Bool, dir_archive_watch, true, CVar::Flag::Save)     // Use OS change notifications rather than full rescans
 
 
 // -----------------------------------------------------------------------------
@@ -86,28 +87,38 @@ EXTERN_CVAR(Int, autosave_entry_changes)
 // DirArchiveCheck Class Functions
 //
 // -----------------------------------------------------------------------------
-wxDEFINE_EVENT(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED, wxThreadEvent);
-
 // -----------------------------------------------------------------------------
-// DirArchiveCheck class constructor
+// DirArchiveCheck class constructor.
+// If [changed_paths] is given, only those paths (and the contents of any new
+// directories within them) are checked, otherwise the whole directory is
+// rescanned
 // -----------------------------------------------------------------------------
-DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive) :
-	handler_{ handler },
+DirArchiveCheck::DirArchiveCheck(DirArchive* archive, const vector<string>* changed_paths) :
 	dir_path_{ archive->filename() },
-	removed_files_{ archive->removedFiles() },
+	removed_files_{ archive->removedFiles().begin(), archive->removedFiles().end() },
 	change_list_{ archive, {} },
-	ignore_hidden_{ archive->hiddenFilesIgnored() }
+	ignore_hidden_{ archive->hiddenFilesIgnored() },
+	full_scan_{ changed_paths == nullptr }
 {
+	if (changed_paths)
+		changed_paths_ = *changed_paths;
+
 	// Get flat entry list
 	vector<ArchiveEntry*> entries;
 	archive->putEntryTreeAsList(entries);
 
 	// Build entry info list
+	entry_info_.reserve(entries.size());
+	entry_index_.reserve(entries.size());
 	for (auto& entry : entries)
 	{
+		auto file_path = entry->exProps().getOr<string>("filePath", "");
+		if (!file_path.empty())
+			entry_index_[file_path] = entry_info_.size();
+
 		entry_info_.emplace_back(
 			entry->path(true),
-			entry->exProps().getOr<string>("filePath", ""),
+			file_path,
 			entry->type() == EntryType::folderType(),
 			archive->fileModificationTime(entry));
 	}
@@ -123,97 +134,144 @@ void DirArchiveCheck::addChange(DirEntryChange change)
 }
 
 // -----------------------------------------------------------------------------
-// DirArchiveCheck thread entry function
+// Returns the info for the entry at [file_path] on disk, or nullptr if there is
+// no entry for it in the archive
 // -----------------------------------------------------------------------------
-wxThread::ExitCode DirArchiveCheck::Entry()
+const DirArchiveCheck::EntryInfo* DirArchiveCheck::entryInfo(const string& file_path) const
 {
-	// Get current directory structure
-	vector<string>      files, dirs;
-	DirArchiveTraverser traverser(files, dirs, ignore_hidden_);
-	wxDir               dir(dir_path_);
-	dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
+	auto i = entry_index_.find(file_path);
+	return i != entry_index_.end() ? &entry_info_[i->second] : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [path] is (or is within) a hidden file or directory and
+// hidden files are being ignored
+// -----------------------------------------------------------------------------
+bool DirArchiveCheck::isHidden(const string& path) const
+{
+	if (!ignore_hidden_)
+		return false;
 
-	// Check for deleted files
-	for (auto& info : entry_info_)
+	auto        dir      = dir_path_.ToStdString();
+	string_view relative = path;
+	if (strutil::startsWith(relative, dir))
+		relative.remove_prefix(dir.size());
+
+	for (auto& name : strutil::splitV(relative, '/'))
+		if (strutil::startsWith(name, '.'))
+			return true;
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a deleted change for the entry [info] if its file no longer exists
+// -----------------------------------------------------------------------------
+void DirArchiveCheck::checkDeleted(const EntryInfo& info)
+{
+	auto path = info.file_path.ToStdString();
+
+	// Ignore if not on disk
+	if (path.empty())
+		return;
+
+	if (info.is_dir)
 	{
-		auto path = info.file_path.ToStdString();
+		if (!wxDirExists(path))
+			addChange(DirEntryChange(DirEntryChange::Action::DeletedDir, path, info.entry_path.ToStdString()));
+	}
+	else
+	{
+		if (!wxFileExists(path))
+			addChange(DirEntryChange(DirEntryChange::Action::DeletedFile, path, info.entry_path.ToStdString()));
+	}
+}
 
-		// Ignore if not on disk
-		if (path.empty())
-			continue;
+// -----------------------------------------------------------------------------
+// Checks the directory for changes, returning the list of changes found.
+// Doesn't access the archive itself, so can be run on any thread
+// -----------------------------------------------------------------------------
+DirArchiveChangeList DirArchiveCheck::run()
+{
+	vector<string> files, dirs;
+	if (full_scan_)
+	{
+		// Get current directory structure
+		DirArchiveTraverser traverser(files, dirs, ignore_hidden_);
+		wxDir               dir(dir_path_);
+		dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
 
-		if (info.is_dir)
-		{
-			if (!wxDirExists(path))
-				addChange(DirEntryChange(DirEntryChange::Action::DeletedDir, path, info.entry_path.ToStdString()));
-		}
-		else
+		// Check for deleted files
+		for (auto& info : entry_info_)
+			checkDeleted(info);
+	}
+	else
+	{
+		for (const auto& path : changed_paths_)
 		{
-			if (!wxFileExists(path))
-				addChange(DirEntryChange(DirEntryChange::Action::DeletedFile, path, info.entry_path.ToStdString()));
+			if (isHidden(path))
+				continue;
+
+			auto info = entryInfo(path);
+			if (wxDirExists(path))
+			{
+				dirs.push_back(path);
+
+				// Files in a new directory may have been created before it was
+				// being watched, so get its full contents
+				if (!info)
+				{
+					DirArchiveTraverser traverser(files, dirs, ignore_hidden_);
+					wxDir               dir(path);
+					dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
+				}
+			}
+			else if (wxFileExists(path))
+				files.push_back(path);
+			else if (info)
+				checkDeleted(*info);
 		}
+
+		// Paths within new directories may also have been reported as changed
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+		std::sort(dirs.begin(), dirs.end());
+		dirs.erase(std::unique(dirs.begin(), dirs.end()), dirs.end());
 	}
 
 	// Check for new/updated files
 	for (const auto& file : files)
 	{
 		// Ignore files removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, file))
+		if (removed_files_.count(file) > 0)
 			continue;
 
-		// Find file in archive
-		EntryInfo inf;
-		bool      found = false;
-		for (auto& info : entry_info_)
-		{
-			if (info.file_path == file)
-			{
-				inf   = info;
-				found = true;
-				break;
-			}
-		}
-
 		time_t mod = wxFileModificationTime(file);
 
 		// No match, added to archive
-		if (!found)
+		auto info = entryInfo(file);
+		if (!info)
 			addChange(DirEntryChange(DirEntryChange::Action::AddedFile, file, "", mod));
 		// Matched, check modification time
-		else if (mod > inf.file_modified)
-			addChange(DirEntryChange(DirEntryChange::Action::Updated, file, inf.entry_path.ToStdString(), mod));
+		else if (mod > info->file_modified)
+			addChange(DirEntryChange(DirEntryChange::Action::Updated, file, info->entry_path.ToStdString(), mod));
 	}
 
 	// Check for new dirs
 	for (const auto& subdir : dirs)
 	{
 		// Ignore dirs removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, subdir))
+		if (removed_files_.count(subdir) > 0)
 			continue;
 
-		bool found = false;
-		for (auto& info : entry_info_)
-		{
-			if (info.file_path == subdir)
-			{
-				found = true;
-				break;
-			}
-		}
-
 		time_t mod = wxDateTime::Now().GetTicks();
 
 		// No match, added to archive
-		if (!found)
+		if (!entryInfo(subdir))
 			addChange(DirEntryChange(DirEntryChange::Action::AddedDir, subdir, "", mod));
 	}
 
-	// Send changes via event
-	auto event = new wxThreadEvent(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED);
-	event->SetPayload<DirArchiveChangeList>(change_list_);
-	wxQueueEvent(handler_, event);
-
-	return nullptr;
+	return change_list_;
 }
 
 
@@ -340,7 +398,6 @@ ArchiveManagerPanel::ArchiveManagerPanel(wxWindow* parent, STabCtrl* nb_archives
 	stc_archives_->Bind(wxEVT_AUINOTEBOOK_PAGE_CLOSED, &ArchiveManagerPanel::onArchiveTabClosed, this);
 	stc_tabs_->Bind(
 		wxEVT_AUINOTEBOOK_PAGE_CHANGED, [&](wxAuiNotebookEvent&) { am_current_tab = stc_tabs_->GetSelection(); });
-	Bind(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED, &ArchiveManagerPanel::onDirArchiveCheckCompleted, this);
 
 	connectSignals();
 
@@ -1411,11 +1468,32 @@ void ArchiveManagerPanel::checkDirArchives()
 		if (VECTOR_EXISTS(checking_archives_, archive.get()))
 			continue;
 
+		auto dir_archive = dynamic_cast<DirArchive*>(archive.get());
+
+		// Get changed paths from the archive's watcher if possible. If there is
+		// no watcher yet, or it lost track of changes, do a full rescan
+		vector<string> changed_paths;
+		bool           full_scan = true;
+		auto&          watcher   = dir_watchers_[archive.get()];
+		if (!dir_archive_watch || !DirWatcher::isSupported())
+			watcher.reset();
+		else if (!watcher)
+			watcher = std::make_unique<DirWatcher>(archive->filename(), dir_archive->hiddenFilesIgnored());
+		else if (watcher->takeChangedPaths(changed_paths))
+		{
+			if (changed_paths.empty())
+				continue;
+
+			full_scan = false;
+		}
+
 		log::info(2, "Checking {} for external changes...", archive->filename());
 		checking_archives_.push_back(archive.get());
-		auto check = new DirArchiveCheck(this, dynamic_cast<DirArchive*>(archive.get()));
-		check->Create();
-		check->Run();
+		auto check = std::make_shared<DirArchiveCheck>(dir_archive, full_scan ? nullptr : &changed_paths);
+		jobs::run(
+			[check] { return check->run(); },
+			[this](const DirArchiveChangeList& change_list) { onDirArchiveCheckCompleted(change_list); },
+			jobs_token_);
 	}
 }
 
@@ -2240,13 +2318,11 @@ void ArchiveManagerPanel::onArchiveTabClosed(wxAuiNotebookEvent& e)
 }
 
 // -----------------------------------------------------------------------------
-// Called when a directory archive check thread finishes work.
+// Called when a directory archive check job finishes work.
 // Pops up a dialog to apply any changes found (if any)
 // -----------------------------------------------------------------------------
-void ArchiveManagerPanel::onDirArchiveCheckCompleted(wxThreadEvent& e)
+void ArchiveManagerPanel::onDirArchiveCheckCompleted(const DirArchiveChangeList& change_list)
 {
-	auto change_list = e.GetPayload<DirArchiveChangeList>();
-
 	// Check the archive is still open
 	if (app::archiveManager().archiveIndex(change_list.archive) >= 0)
 	{
@@ -2310,6 +2386,7 @@ void ArchiveManagerPanel::connectSignals()
 			closeTextureTab(index);
 			closeEntryTabs(app::archiveManager().getArchive(index).get());
 			closeTab(index);
+			dir_watchers_.erase(app::archiveManager().getArchive(index).get());
 		});
 
 	// When an archive is opened, open its tab
@@ -1,12 +1,12 @@
 #pragma once
 
 #include "Archive/Formats/DirArchive.h"
+#include "General/Jobs.h"
 #include "General/SAction.h"
 #include "General/Sigslot.h"
 #include "UI/Controls/DockPanel.h"
 #include "UI/Lists/ListView.h"
-
-wxDECLARE_EVENT(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED, wxThreadEvent);
+#include "Utility/DirWatcher.h"
 
 namespace slade
 {
@@ -23,13 +23,15 @@ struct DirArchiveChangeList
 	vector<DirEntryChange> changes;
 };
 
-class DirArchiveCheck : public wxThread
+// Checks a directory archive for changes made outside of SLADE. Constructed
+// on the main thread, after which run() can be called from a job
+class DirArchiveCheck
 {
 public:
-	DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive);
-	~DirArchiveCheck() override = default;
+	DirArchiveCheck(DirArchive* archive, const vector<string>* changed_paths = nullptr);
+	~DirArchiveCheck() = default;
 
-	ExitCode Entry() override;
+	DirArchiveChangeList run();
 
 private:
 	struct EntryInfo
@@ -49,14 +51,19 @@ private:
 		}
 	};
 
-	wxEvtHandler*        handler_;
-	wxString             dir_path_;
-	vector<EntryInfo>    entry_info_;
-	vector<string>       removed_files_;
-	DirArchiveChangeList change_list_;
-	bool                 ignore_hidden_ = true;
-
-	void addChange(DirEntryChange change);
+	wxString                           dir_path_;
+	vector<EntryInfo>                  entry_info_;
+	std::unordered_map<string, size_t> entry_index_; // File path -> entry_info_ index
+	std::unordered_set<string>         removed_files_;
+	DirArchiveChangeList               change_list_;
+	bool                               ignore_hidden_ = true;
+	bool                               full_scan_     = true;
+	vector<string>                     changed_paths_;
+
+	void             addChange(DirEntryChange change);
+	const EntryInfo* entryInfo(const string& file_path) const;
+	bool             isHidden(const string& path) const;
+	void             checkDeleted(const EntryInfo& info);
 };
 
 class WMFileBrowser : public wxGenericDirCtrl
@@ -74,7 +81,7 @@ class ArchiveManagerPanel : public DockPanel, SActionHandler
 {
 public:
 	ArchiveManagerPanel(wxWindow* parent, STabCtrl* nb_archives);
-	~ArchiveManagerPanel() override = default;
+	~ArchiveManagerPanel() override { jobs_token_.cancel(); }
 
 	wxMenu* recentFilesMenu() const { return menu_recent_; }
 	wxMenu* bookmarksMenu() const { return menu_bookmarks_; }
@@ -170,7 +177,7 @@ public:
 	void onArchiveTabChanged(wxAuiNotebookEvent& e);
 	void onArchiveTabClose(wxAuiNotebookEvent& e);
 	void onArchiveTabClosed(wxAuiNotebookEvent& e);
-	void onDirArchiveCheckCompleted(wxThreadEvent& e);
+	void onDirArchiveCheckCompleted(const DirArchiveChangeList& change_list);
 
 private:
 	STabCtrl*        stc_tabs_                    = nullptr;
@@ -189,6 +196,9 @@ private:
 	bool             asked_save_unchanged_        = false;
 	bool             checked_dir_archive_changes_ = false;
 	vector<Archive*> checking_archives_;
+	jobs::Token      jobs_token_;
+
+	std::map<Archive*, unique_ptr<DirWatcher>> dir_watchers_;
 
 	// Signal connections
 	ScopedConnectionList signal_connections;
@@ -117,9 +117,6 @@ CVAR(Bool, elist_no_tree, false, CVar::Flag::Save)
 // External Variables
 //
 // -----------------------------------------------------------------------------
-EXTERN_CVAR(String, path_pngout)
-EXTERN_CVAR(String, path_pngcrush)
-EXTERN_CVAR(String, path_deflopt)
 EXTERN_CVAR(Bool, confirm_entry_revert)
 EXTERN_CVAR(Bool, archive_dir_ignore_hidden)
 
@@ -1988,37 +1985,9 @@ bool ArchivePanel::gfxConvert() const
 	// Run the gcd
 	gcd.ShowModal();
 
-	// Show splash window
-	ui::showSplash("Writing converted image data...", true);
-
-	// Begin recording undo level
-	undo_manager_->beginRecord("Gfx Format Conversion");
-
-	// Write any changes
-	for (unsigned a = 0; a < selection.size(); a++)
-	{
-		// Update splash window
-		ui::setSplashProgressMessage(selection[a]->name());
-		ui::setSplashProgress((float)a / (float)selection.size());
-
-		// Skip if the image wasn't converted
-		if (!gcd.itemModified(a))
-			continue;
-
-		// Get image and conversion info
-		auto image  = gcd.itemImage(a);
-		auto format = gcd.itemFormat(a);
-
-		// Write converted image back to entry
-		MemChunk mc;
-		format->saveImage(*image, mc, gcd.itemPalette(a));
-		selection[a]->importMemChunk(mc);
-		EntryType::detectEntryType(*selection[a]);
-		selection[a]->setExtensionByType();
-	}
-
-	// Finish recording undo level
-	undo_manager_->endRecord(true);
+	// Write any changes (as a single undo level)
+	ui::showSplash("Writing converted image data...");
+	gcd.converter().applyToEntries(undo_manager_.get(), "Gfx Format Conversion");
 
 	// Hide splash window
 	ui::hideSplash();
@@ -2680,47 +2649,17 @@ bool ArchivePanel::compileACS(bool hexen) const
 }
 
 // -----------------------------------------------------------------------------
-// Compiles any selected text entries as ACS scripts
+// Optimizes any selected PNG entries
 // -----------------------------------------------------------------------------
 bool ArchivePanel::optimizePNG() const
 {
-	// Check if the PNG tools path are set up, at least one of them should be
-	wxString pngpathc = path_pngcrush;
-	wxString pngpatho = path_pngout;
-	wxString pngpathd = path_deflopt;
-	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) && (pngpatho.IsEmpty() || !wxFileExists(pngpatho))
-		&& (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
-	{
-		wxMessageBox(
-			"Error: PNG tool paths not defined or invalid, please configure in SLADE preferences",
-			"Error",
-			wxOK | wxCENTRE | wxICON_ERROR);
-		return false;
-	}
-
 	// Get selected entries
 	auto selection = entry_tree_->selectedEntries();
 
-	ui::showSplash("Running external programs, please wait...", true);
-
-	// Begin recording undo level
+	// Optimize (as a single undo level)
 	undo_manager_->beginRecord("Optimize PNG");
-
-	// Go through selection
-	for (unsigned a = 0; a < selection.size(); a++)
-	{
-		ui::setSplashProgressMessage(selection[a]->nameNoExt());
-		ui::setSplashProgress(static_cast<float>(a) / static_cast<float>(selection.size()));
-		if (selection[a]->type()->formatId() == "img_png")
-		{
-			undo_manager_->recordUndoStep(std::make_unique<EntryDataUS>(selection[a]));
-			entryoperations::optimizePNG(selection[a]);
-		}
-	}
-	ui::hideSplash();
-
-	// Finish recording undo level
-	undo_manager_->endRecord(true);
+	bool optimized = entryoperations::optimizePNGs(selection, undo_manager_.get());
+	undo_manager_->endRecord(optimized);
 
 	return true;
 }
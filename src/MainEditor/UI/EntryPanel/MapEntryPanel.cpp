@@ -137,23 +137,25 @@ bool MapEntryPanel::loadEntry(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Load map into preview canvas
-	if (map_canvas_->openMap(thismap))
-	{
-		label_stats_->SetLabel(wxString::Format(
-			"Vertices: %d, Sides: %d, Lines: %d, Sectors: %d, Things: %d, Total Size: %dx%d",
-			map_canvas_->nVertices(),
-			map_canvas_->nSides(),
-			map_canvas_->nLines(),
-			map_canvas_->nSectors(),
-			map_canvas_->nThings(),
-			map_canvas_->width(),
-			map_canvas_->height()));
-		return true;
-	}
-
+	// Load map into preview canvas, the stats are shown once it is loaded
 	label_stats_->SetLabel("");
-	return false;
+	return map_canvas_->openMap(
+		thismap,
+		[this](bool loaded)
+		{
+			if (!loaded)
+				return;
+
+			label_stats_->SetLabel(wxString::Format(
+				"Vertices: %d, Sides: %d, Lines: %d, Sectors: %d, Things: %d, Total Size: %dx%d",
+				map_canvas_->nVertices(),
+				map_canvas_->nSides(),
+				map_canvas_->nLines(),
+				map_canvas_->nSectors(),
+				map_canvas_->nThings(),
+				map_canvas_->width(),
+				map_canvas_->height()));
+		});
 }
 
 // -----------------------------------------------------------------------------
@@ -166,15 +168,8 @@ bool MapEntryPanel::createImage()
 		return false;
 
 	ArchiveEntry temp;
-
-	// Stupid OpenGL grumble grumble grumble
-	if (gl::fboSupport())
-		map_canvas_->createImage(temp, map_image_width, map_image_height);
-	else
-		map_canvas_->createImage(
-			temp,
-			min<int>(map_image_width, map_canvas_->GetSize().x),
-			min<int>(map_image_height, map_canvas_->GetSize().y));
+	if (!map_canvas_->createImage(temp, map_image_width, map_image_height))
+		return false;
 
 	wxString   name = wxString::Format("%s_%s", entry->parent()->filename(false), entry->name());
 	wxFileName fn(name);
@@ -38,11 +38,11 @@
 #include "MapBackupManager.h"
 #include "App.h"
 #include "Archive/Formats/ZipArchive.h"
-#include "General/Misc.h"
 #include "MapEditor.h"
 #include "UI/MapBackupPanel.h"
 #include "UI/SDialog.h"
 #include "UI/WxUtils.h"
+#include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
 
 using namespace slade;
@@ -59,84 +59,355 @@ namespace
 // List of entry names to be ignored for backups
 string mb_ignore_entries[] = { "NODES",    "SSECTORS", "ZNODES",  "SEGS",     "REJECT",
 							   "BLOCKMAP", "GL_VERT",  "GL_SEGS", "GL_SSECT", "GL_NODES" };
+
+// Backup store layout: each map gets a directory containing an append-only
+// pack of lump data (each unique lump stored once) and a small manifest per
+// backup listing the lumps that make it up
+const string   pack_filename      = "lumps.pack";
+const string   manifest_extension = ".manifest";
+const char     manifest_magic[4]  = { 'S', 'M', 'B', 'K' };
+const uint32_t manifest_version   = 1;
+
+struct BackupLump
+{
+	string   name;
+	uint32_t offset = 0; // Offset of the lump data in the pack
+	uint32_t size   = 0;
+	uint64_t hash   = 0;
+};
 } // namespace
 
 
 // -----------------------------------------------------------------------------
 //
-// MapBackupManager Class Functions
+// Functions
 //
 // -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the legacy (full copy zip) backup filename for [archive_name]
+// -----------------------------------------------------------------------------
+string legacyBackupFile(string_view archive_name)
+{
+	string fname{ archive_name };
+	std::replace(fname.begin(), fname.end(), '.', '_');
+	return fmt::format("{}/{}_backup.zip", app::path("backups", app::Dir::User), fname);
+}
 
+// -----------------------------------------------------------------------------
+// Returns the backup store directory for [map_name] in [archive_name]
+// -----------------------------------------------------------------------------
+string storeDir(string_view archive_name, string_view map_name)
+{
+	string fname{ archive_name };
+	std::replace(fname.begin(), fname.end(), '.', '_');
+	return fmt::format("{}/{}/{}", app::path("backups", app::Dir::User), fname, map_name);
+}
 
 // -----------------------------------------------------------------------------
-// Writes a backup for [map_name] in [archive_name], with the map data entries
-// in [map_data]
+// Returns true if the entry [name] should be ignored for backups
 // -----------------------------------------------------------------------------
-bool MapBackupManager::writeBackup(
-	vector<unique_ptr<ArchiveEntry>>& map_data,
-	std::string_view                  archive_name,
-	std::string_view                  map_name) const
+bool isIgnoredEntry(string_view name)
 {
-	// Create backup directory if needed
-	auto backup_dir = app::path("backups", app::Dir::User);
-	if (!wxDirExists(backup_dir))
-		wxMkdir(backup_dir);
+	for (auto& ignore_entry : mb_ignore_entries)
+		if (strutil::equalCI(ignore_entry, name))
+			return true;
 
-	// Open or create backup zip
-	shared_ptr<Archive> backup = std::make_shared<ZipArchive>();
-	string              fname{ archive_name };
-	std::replace(fname.begin(), fname.end(), '.', '_');
-	auto backup_file = fmt::format("{}/{}_backup.zip", backup_dir, fname);
-	if (!backup->open(backup_file))
-		backup->setFilename(backup_file);
+	return false;
+}
 
-	// Filter ignored entries
-	vector<ArchiveEntry*> backup_entries;
-	for (auto& entry : map_data)
+// -----------------------------------------------------------------------------
+// Returns a list of the timestamps of all backups in the store at [dir],
+// oldest first
+// -----------------------------------------------------------------------------
+vector<string> backupTimestamps(const string& dir)
+{
+	vector<string> timestamps;
+	if (!fileutil::dirExists(dir))
+		return timestamps;
+
+	for (const auto& file : fileutil::allFilesInDir(dir))
+		if (strutil::endsWith(file, manifest_extension))
+			timestamps.emplace_back(strutil::Path::fileNameOf(file, false));
+
+	// Timestamps are ISO format so they sort chronologically
+	std::sort(timestamps.begin(), timestamps.end());
+
+	return timestamps;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the backup manifest at [path] into [lumps]
+// -----------------------------------------------------------------------------
+bool readManifest(const string& path, vector<BackupLump>& lumps)
+{
+	MemChunk mc;
+	if (!mc.importFile(path) || mc.size() < 12 || memcmp(mc.data(), manifest_magic, 4) != 0)
 	{
-		// Check for ignored entry
-		bool ignored = false;
-		for (auto& ignore_entry : mb_ignore_entries)
+		log::warning("Invalid map backup manifest {}", path);
+		return false;
+	}
+
+	uint32_t version = mc.readL32(4);
+	uint32_t count   = mc.readL32(8);
+	if (version != manifest_version)
+	{
+		log::warning("Unsupported map backup manifest version {} in {}", version, path);
+		return false;
+	}
+
+	lumps.clear();
+	mc.seek(12, SEEK_SET);
+	for (unsigned a = 0; a < count; ++a)
+	{
+		BackupLump lump;
+		uint8_t    name_len = 0;
+		char       name[256];
+		if (!mc.read(&lump.offset, 4) || !mc.read(&lump.size, 4) || !mc.read(&lump.hash, 8) || !mc.read(&name_len, 1)
+			|| !mc.read(name, name_len))
 		{
-			if (strutil::equalCI(ignore_entry, entry->name()))
-			{
-				ignored = true;
-				break;
-			}
+			log::warning("Map backup manifest {} is truncated", path);
+			return false;
 		}
 
-		if (!ignored)
-			backup_entries.push_back(entry.get());
+		lump.offset = wxINT32_SWAP_ON_BE(lump.offset);
+		lump.size   = wxINT32_SWAP_ON_BE(lump.size);
+		lump.hash   = wxUINT64_SWAP_ON_BE(lump.hash);
+		lump.name.assign(name, name_len);
+		lumps.push_back(lump);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [lumps] to a backup manifest at [path]
+// -----------------------------------------------------------------------------
+bool writeManifest(const string& path, const vector<BackupLump>& lumps)
+{
+	MemChunk mc;
+	uint32_t version = wxINT32_SWAP_ON_BE(manifest_version);
+	uint32_t count   = wxINT32_SWAP_ON_BE(static_cast<uint32_t>(lumps.size()));
+	mc.write(manifest_magic, 4);
+	mc.write(&version, 4);
+	mc.write(&count, 4);
+	for (const auto& lump : lumps)
+	{
+		uint32_t offset   = wxINT32_SWAP_ON_BE(lump.offset);
+		uint32_t size     = wxINT32_SWAP_ON_BE(lump.size);
+		uint64_t hash     = wxUINT64_SWAP_ON_BE(lump.hash);
+		auto     name_len = static_cast<uint8_t>(std::min<size_t>(lump.name.size(), 255));
+		mc.write(&offset, 4);
+		mc.write(&size, 4);
+		mc.write(&hash, 8);
+		mc.write(&name_len, 1);
+		mc.write(lump.name.data(), name_len);
+	}
+
+	return mc.exportFile(path);
+}
+
+// -----------------------------------------------------------------------------
+// Replaces each file in [files] (target path -> new file path) with its new
+// file. The old files are kept aside until all new files are in place, and
+// restored if any replacement fails
+// -----------------------------------------------------------------------------
+bool replaceFiles(const vector<std::pair<string, string>>& files)
+{
+	vector<std::pair<string, string>> replaced; // target path -> old file path
+	bool                              ok = true;
+	for (const auto& [path, new_path] : files)
+	{
+		auto old_path = path + ".old";
+		if (!wxRenameFile(path, old_path, true))
+		{
+			ok = false;
+			break;
+		}
+		if (!wxRenameFile(new_path, path, true))
+		{
+			wxRenameFile(old_path, path, true);
+			ok = false;
+			break;
+		}
+		replaced.emplace_back(path, old_path);
+	}
+
+	if (ok)
+	{
+		for (const auto& [path, old_path] : replaced)
+			fileutil::removeFile(old_path);
+		return true;
+	}
+
+	// Put back the old files
+	for (auto i = replaced.rbegin(); i != replaced.rend(); ++i)
+		if (!wxRenameFile(i->second, i->first, true))
+			log::error("Unable to restore {} from {}", i->first, i->second);
+	for (const auto& [path, new_path] : files)
+		if (fileutil::fileExists(new_path))
+			fileutil::removeFile(new_path);
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Rewrites the lump pack in the store at [dir] if more than half of it is no
+// longer referenced by any backup manifest (eg. after old backups are removed).
+// The new pack and manifests are written to temp files first and only
+// replace the existing ones once they have all been written successfully
+// -----------------------------------------------------------------------------
+void compactPack(const string& dir)
+{
+	auto pack_path = fmt::format("{}/{}", dir, pack_filename);
+
+	// Read all manifests and determine the live lump data in the pack
+	auto                         timestamps = backupTimestamps(dir);
+	vector<vector<BackupLump>>   manifests(timestamps.size());
+	std::map<uint32_t, uint32_t> live; // offset -> size
+	uint64_t                     live_size = 0;
+	for (unsigned a = 0; a < timestamps.size(); ++a)
+	{
+		if (!readManifest(fmt::format("{}/{}{}", dir, timestamps[a], manifest_extension), manifests[a]))
+			return;
+
+		for (const auto& lump : manifests[a])
+			if (lump.size > 0 && live.emplace(lump.offset, lump.size).second)
+				live_size += lump.size;
+	}
+
+	SFile pack(pack_path);
+	if (!pack.isOpen() || pack.size() <= live_size * 2)
+		return;
+
+	// Copy live lump data to a new pack
+	vector<std::pair<string, string>> files; // target path -> temp path
+	auto                              temp_path = pack_path + ".tmp";
+	SFile                             new_pack(temp_path, SFile::Mode::Write);
+	std::map<uint32_t, uint32_t>      new_offsets;
+	uint32_t                          new_offset = 0;
+	MemChunk                          data;
+	bool                              ok = new_pack.isOpen();
+	for (auto i = live.begin(); ok && i != live.end(); ++i)
+	{
+		auto [offset, size] = *i;
+		if (!pack.seekFromStart(offset) || !pack.read(data, size) || !new_pack.write(data.data(), size))
+			ok = false;
+
+		new_offsets[offset] = new_offset;
+		new_offset += size;
+	}
+	pack.close();
+	new_pack.close();
+	files.emplace_back(pack_path, temp_path);
+
+	// Check the whole pack made it to disk
+	if (ok)
+	{
+		SFile written(temp_path);
+		ok = written.isOpen() && written.size() == new_offset;
+	}
+
+	// Write manifests with new offsets
+	for (unsigned a = 0; ok && a < timestamps.size(); ++a)
+	{
+		for (auto& lump : manifests[a])
+			if (lump.size > 0)
+				lump.offset = new_offsets[lump.offset];
+
+		auto path = fmt::format("{}/{}{}", dir, timestamps[a], manifest_extension);
+		files.emplace_back(path, path + ".tmp");
+		ok = writeManifest(files.back().second, manifests[a]);
+	}
+
+	// Replace the old pack and manifests
+	if (!ok)
+	{
+		log::warning("Unable to compact map backup pack {}", pack_path);
+		for (const auto& [path, temp] : files)
+			if (fileutil::fileExists(temp))
+				fileutil::removeFile(temp);
+		return;
+	}
+	if (!replaceFiles(files))
+	{
+		log::warning("Unable to replace map backup pack {}, keeping the uncompacted pack", pack_path);
+		return;
+	}
+
+	log::info(2, "Compacted map backup pack {} ({} bytes live)", pack_path, live_size);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the [size] bytes at [offset] in [pack] are the same as [data]
+// -----------------------------------------------------------------------------
+bool packDataMatches(SFile& pack, uint32_t offset, uint32_t size, const uint8_t* data)
+{
+	MemChunk pack_data;
+	return pack.seekFromStart(offset) && pack.read(pack_data, size) && pack_data.size() == size
+		   && memcmp(pack_data.data(), data, size) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a backup of [entries] with [timestamp] to the store at [dir]. Only lump
+// data not already in the store's pack is written. If [max_backups] is > 0,
+// the oldest backups are removed to keep within that number
+// -----------------------------------------------------------------------------
+bool storeBackup(const string& dir, const vector<ArchiveEntry*>& entries, const string& timestamp, int max_backups)
+{
+	// Build index of all lump data already in the pack (by content hash). The
+	// hash only finds candidates, the data itself is compared before reusing
+	// any, so a collision can't store the wrong data
+	auto                                             timestamps = backupTimestamps(dir);
+	std::unordered_map<uint64_t, vector<BackupLump>> index;
+	vector<BackupLump>                               last_backup, manifest;
+	for (const auto& ts : timestamps)
+	{
+		if (!readManifest(fmt::format("{}/{}{}", dir, ts, manifest_extension), manifest))
+		{
+			last_backup.clear();
+			continue;
+		}
+
+		for (const auto& lump : manifest)
+		{
+			auto& candidates = index[lump.hash];
+			if (std::none_of(
+					candidates.begin(),
+					candidates.end(),
+					[&lump](const BackupLump& c) { return c.offset == lump.offset && c.size == lump.size; }))
+				candidates.push_back(lump);
+		}
+		last_backup = manifest;
+	}
+	auto  pack_path = fmt::format("{}/{}", dir, pack_filename);
+	SFile pack_in(pack_path);
+
+	// Hash entry data
+	vector<BackupLump> lumps;
+	for (auto& entry : entries)
+	{
+		BackupLump lump;
+		lump.name = entry->name();
+		lump.size = entry->size();
+		lump.hash = entry->data().hash();
+		lumps.push_back(lump);
 	}
 
 	// Compare with last backup (if any)
-	auto map_dir = backup->dirAtPath(map_name);
-	if (map_dir && map_dir->numSubdirs() > 0)
-	{
-		auto last_backup = map_dir->subdirAt(map_dir->numSubdirs() - 1);
-		bool same        = true;
-		if (last_backup->numEntries() != backup_entries.size())
-			same = false;
-		else
+	if (!timestamps.empty() && last_backup.size() == lumps.size())
+	{
+		bool same = true;
+		for (unsigned a = 0; a < lumps.size(); ++a)
 		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
+			if (lumps[a].name != last_backup[a].name || lumps[a].size != last_backup[a].size
+				|| lumps[a].hash != last_backup[a].hash
+				|| (lumps[a].size > 0
+					&& !packDataMatches(pack_in, last_backup[a].offset, lumps[a].size, entries[a]->rawData())))
 			{
-				auto e1 = backup_entries[a];
-				auto e2 = last_backup->entryAt(a);
-				if (e1->size() != e2->size())
-				{
-					same = false;
-					break;
-				}
-
-				uint32_t crc1 = misc::crc(e1->rawData(), e1->size());
-				uint32_t crc2 = misc::crc(e2->rawData(), e2->size());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
+				same = false;
+				break;
 			}
 		}
 
@@ -147,24 +418,212 @@ bool MapBackupManager::writeBackup(
 		}
 	}
 
-	// Add map data to backup
+	// Append any new lump data to the pack. Data already in the pack is
+	// compared against the existing pack, data added by this backup against
+	// the entry it was written from
+	SFile pack(pack_path, SFile::Mode::Append);
+	if (!pack.isOpen())
+	{
+		log::error("Unable to open map backup pack {} for writing", pack_path);
+		return false;
+	}
+	auto                                   pack_size = pack.length();
+	std::unordered_map<uint32_t, unsigned> written; // Offset -> index of the entry written there
+	for (unsigned a = 0; a < lumps.size(); ++a)
+	{
+		auto& lump = lumps[a];
+		if (lump.size == 0)
+			continue;
+
+		auto  data       = entries[a]->rawData();
+		auto& candidates = index[lump.hash];
+		auto  existing   = std::find_if(
+			candidates.begin(),
+			candidates.end(),
+			[&](const BackupLump& c)
+			{
+				if (c.size != lump.size)
+					return false;
+				if (auto w = written.find(c.offset); w != written.end())
+					return memcmp(entries[w->second]->rawData(), data, lump.size) == 0;
+				return packDataMatches(pack_in, c.offset, lump.size, data);
+			});
+		if (existing != candidates.end())
+		{
+			lump.offset = existing->offset;
+			continue;
+		}
+
+		if (!pack.write(data, lump.size))
+		{
+			log::error("Unable to write to map backup pack {}", pack_path);
+			return false;
+		}
+
+		lump.offset = pack_size;
+		pack_size += lump.size;
+		written[lump.offset] = a;
+		candidates.push_back(lump);
+	}
+	pack.close();
+
+	// Write manifest
+	if (!writeManifest(fmt::format("{}/{}{}", dir, timestamp, manifest_extension), lumps))
+		return false;
+
+	// Check for max backups & remove old ones if over
+	if (max_backups > 0)
+	{
+		timestamps = backupTimestamps(dir);
+		if (static_cast<int>(timestamps.size()) > max_backups)
+		{
+			for (unsigned a = 0; a < timestamps.size() - max_backups; ++a)
+				fileutil::removeFile(fmt::format("{}/{}{}", dir, timestamps[a], manifest_extension));
+
+			compactPack(dir);
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the backup store directory for [map_name] in [archive_name]. If the
+// store doesn't exist yet, any backups for the map in the legacy backup zip
+// are imported into a new store. If [create] is false and there is nothing to
+// import, returns an empty string
+// -----------------------------------------------------------------------------
+string openStore(string_view archive_name, string_view map_name, bool create)
+{
+	auto dir = storeDir(archive_name, map_name);
+	if (fileutil::dirExists(dir))
+		return dir;
+
+	// Check for legacy backups
+	auto        legacy      = std::make_unique<ZipArchive>();
+	auto        legacy_file = legacyBackupFile(archive_name);
+	ArchiveDir* legacy_dir  = nullptr;
+	if (fileutil::fileExists(legacy_file) && legacy->open(legacy_file))
+	{
+		legacy_dir = legacy->dirAtPath(map_name);
+		if (legacy_dir == legacy->rootDir().get())
+			legacy_dir = nullptr;
+	}
+	if (!legacy_dir && !create)
+		return {};
+
+	// Create store directory
+	auto backup_dir = app::path("backups", app::Dir::User);
+	if (!fileutil::dirExists(backup_dir))
+		fileutil::createDir(backup_dir);
+	fileutil::createDir(strutil::Path::pathOf(dir, false));
+	fileutil::createDir(dir);
+
+	// Import legacy backups
+	if (legacy_dir)
+	{
+		for (unsigned a = 0; a < legacy_dir->numSubdirs(); ++a)
+		{
+			auto                  subdir = legacy_dir->subdirAt(a);
+			vector<ArchiveEntry*> entries;
+			for (unsigned e = 0; e < subdir->numEntries(); ++e)
+				entries.push_back(subdir->entryAt(e));
+
+			storeBackup(dir, entries, subdir->name(), 0);
+		}
+
+		log::info("Imported {} legacy map backups for {}", legacy_dir->numSubdirs(), map_name);
+	}
+
+	return dir;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapBackupManager Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Writes a backup for [map_name] in [archive_name], with the map data entries
+// in [map_data]
+// -----------------------------------------------------------------------------
+bool MapBackupManager::writeBackup(
+	vector<unique_ptr<ArchiveEntry>>& map_data,
+	std::string_view                  archive_name,
+	std::string_view                  map_name) const
+{
+	// Open or create backup store for the map
+	auto dir = openStore(archive_name, map_name, true);
+	if (!fileutil::dirExists(dir))
+	{
+		log::error("Unable to create map backup directory {}", dir);
+		return false;
+	}
+
+	// Filter ignored entries
+	vector<ArchiveEntry*> backup_entries;
+	for (auto& entry : map_data)
+		if (!isIgnoredEntry(entry->name()))
+			backup_entries.push_back(entry.get());
+
+	// Add backup
 	auto timestamp = wxDateTime::Now().FormatISOCombined('_').ToStdString();
 	strutil::replaceIP(timestamp, ":", "");
-	auto dir = fmt::format("{}/{}", map_name, timestamp);
-	for (auto& entry : backup_entries)
-		backup->addEntry(std::make_shared<ArchiveEntry>(*entry), dir);
+	return storeBackup(dir, backup_entries, timestamp, max_map_backups);
+}
 
-	// Check for max backups & remove old ones if over
-	map_dir = backup->dirAtPath(map_name);
-	while ((int)map_dir->numSubdirs() > max_map_backups)
-		backup->removeDir(map_dir->subdirAt(0)->name(), map_dir);
+// -----------------------------------------------------------------------------
+// Returns a list of timestamps of all existing backups for [map_name] in
+// [archive_name], oldest first
+// -----------------------------------------------------------------------------
+vector<string> MapBackupManager::backupList(string_view archive_name, string_view map_name) const
+{
+	auto dir = openStore(archive_name, map_name, false);
+	return dir.empty() ? vector<string>{} : backupTimestamps(dir);
+}
 
-	// Save backup file
-	Archive::save_backup = false;
-	bool ok              = backup->save();
-	Archive::save_backup = true;
+// -----------------------------------------------------------------------------
+// Reads the map data entries of the backup for [map_name] in [archive_name]
+// with [timestamp], and adds them to [target]
+// -----------------------------------------------------------------------------
+bool MapBackupManager::readBackup(
+	string_view archive_name,
+	string_view map_name,
+	string_view timestamp,
+	Archive&    target) const
+{
+	auto               dir = storeDir(archive_name, map_name);
+	vector<BackupLump> lumps;
+	if (!readManifest(fmt::format("{}/{}{}", dir, timestamp, manifest_extension), lumps))
+		return false;
+
+	// Read each lump's data directly from its position in the pack
+	SFile pack(fmt::format("{}/{}", dir, pack_filename));
+	if (!pack.isOpen())
+		return false;
+
+	MemChunk data;
+	for (const auto& lump : lumps)
+	{
+		auto entry = std::make_shared<ArchiveEntry>(lump.name);
+		if (lump.size > 0)
+		{
+			if (!pack.seekFromStart(lump.offset) || !pack.read(data, lump.size) || data.size() != lump.size)
+			{
+				log::error("Map backup {} of {} is corrupt", timestamp, map_name);
+				return false;
+			}
+			entry->importMemChunk(data);
+		}
+
+		target.addEntry(entry, "");
+	}
 
-	return ok;
+	return true;
 }
 
 // -----------------------------------------------------------------------------
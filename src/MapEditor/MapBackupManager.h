@@ -12,5 +12,8 @@ public:
 
 	bool writeBackup(vector<unique_ptr<ArchiveEntry>>& map_data, string_view archive_name, string_view map_name) const;
 	Archive* openBackup(string_view archive_name, string_view map_name) const;
+
+	vector<string> backupList(string_view archive_name, string_view map_name) const;
+	bool readBackup(string_view archive_name, string_view map_name, string_view timestamp, Archive& target) const;
 };
 } // namespace slade
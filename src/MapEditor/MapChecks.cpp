@@ -38,6 +38,7 @@
 #include "MapChecks.h"
 #include "Game/Configuration.h"
 #include "Game/ThingType.h"
+#include "General/Profiler.h"
 #include "General/SAction.h"
 #include "MapEditor/MapEditContext.h"
 #include "MapEditor/MapEditor.h"
@@ -95,6 +96,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("MissingTextureCheck::doCheck");
+
 		string sky_flat = game::configuration().skyFlat();
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
@@ -268,6 +271,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("SpecialTagsCheck::doCheck");
+
 		using game::TagType;
 
 		for (auto& line : map_->lines())
@@ -371,6 +376,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("MissingTaggedCheck::doCheck");
+
 		using game::TagType;
 
 		unsigned nlines  = map_->nLines();
@@ -526,6 +533,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("LinesIntersectCheck::doCheck");
+
 		// Get all map lines
 		vector<MapLine*> all_lines;
 		for (unsigned a = 0; a < map_->nLines(); a++)
@@ -647,6 +656,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("LinesOverlapCheck::doCheck");
+
 		// Go through lines
 		for (unsigned a = 0; a < map_->nLines(); a++)
 		{
@@ -752,6 +763,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("ThingsOverlapCheck::doCheck");
+
 		double r1, r2;
 
 		// Go through things
@@ -992,6 +1005,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("UnknownTexturesCheck::doCheck");
+
 		bool mixed = game::configuration().featureSupported(game::Feature::MixTexFlats);
 
 		// Go through lines
@@ -1173,6 +1188,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("UnknownFlatsCheck::doCheck");
+
 		bool mixed = game::configuration().featureSupported(game::Feature::MixTexFlats);
 
 		// Go through sectors
@@ -1279,6 +1296,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("UnknownThingTypesCheck::doCheck");
+
 		for (unsigned a = 0; a < map_->nThings(); a++)
 		{
 			auto& tt = game::configuration().thingType(map_->thing(a)->type());
@@ -1354,6 +1373,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("StuckThingsCheck::doCheck");
+
 		double radius;
 
 		// Get list of lines to check
@@ -1490,6 +1511,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("SectorReferenceCheck::doCheck");
+
 		// Go through map lines
 		for (unsigned a = 0; a < map_->nLines(); a++)
 			checkLine(map_->line(a));
@@ -1620,6 +1643,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("InvalidLineCheck::doCheck");
+
 		// Go through map lines
 		lines_.clear();
 		for (unsigned a = 0; a < map_->nLines(); a++)
@@ -1736,6 +1761,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("UnknownSectorCheck::doCheck");
+
 		// Go through map lines
 		sectors_.clear();
 		for (unsigned a = 0; a < map_->nSectors(); a++)
@@ -1809,6 +1836,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("UnknownSpecialCheck::doCheck");
+
 		// Go through map lines
 		objects_.clear();
 		for (unsigned a = 0; a < map_->nLines(); ++a)
@@ -1899,6 +1928,8 @@ public:
 
 	void doCheck() override
 	{
+		PROFILE_SCOPE("ObsoleteThingCheck::doCheck");
+
 		// Go through map lines
 		things_.clear();
 		for (unsigned a = 0; a < map_->nThings(); ++a)
@@ -42,6 +42,7 @@
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/Console.h"
+#include "General/Profiler.h"
 #include "General/UndoRedo.h"
 #include "MapChecks.h"
 #include "MapEditor/Renderer/Overlays/InfoOverlay3d.h"
@@ -1634,6 +1635,8 @@ void MapEditContext::updateInfoOverlay()
 // -----------------------------------------------------------------------------
 void MapEditContext::drawInfoOverlay(const Vec2i& size, float alpha)
 {
+	PROFILE_SCOPE("MapEditContext::drawInfoOverlay");
+
 	switch (edit_mode_)
 	{
 	case Mode::Vertices: info_vertex_.draw(size.y, size.x, alpha); return;
@@ -42,6 +42,7 @@
 #include "Archive/ArchiveManager.h"
 #include "Game/Configuration.h"
 #include "General/Misc.h"
+#include "General/Profiler.h"
 #include "General/ResourceManager.h"
 #include "Graphics/CTexture/CTexture.h"
 #include "Graphics/SImage/SImage.h"
@@ -68,6 +69,62 @@ MapTextureManager::Texture tex_invalid;
 CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the average colour of rows [row_start] to [row_end] in RGBA [data] of
+// [width] pixels wide
+// -----------------------------------------------------------------------------
+ColRGBA averageColour(const uint8_t* data, unsigned width, unsigned row_start, unsigned row_end)
+{
+	unsigned red   = 0;
+	unsigned green = 0;
+	unsigned blue  = 0;
+	unsigned npix  = (row_end - row_start) * width;
+	if (npix == 0)
+		return ColRGBA::BLACK;
+
+	auto pixel = data + row_start * width * 4;
+	auto end   = data + row_end * width * 4;
+	for (; pixel < end; pixel += 4)
+	{
+		red += pixel[0];
+		green += pixel[1];
+		blue += pixel[2];
+	}
+
+	return {
+		static_cast<uint8_t>(red / npix), static_cast<uint8_t>(green / npix), static_cast<uint8_t>(blue / npix), 255
+	};
+}
+
+// -----------------------------------------------------------------------------
+// Creates the OpenGL texture for [mtex] from [image], and calculates its
+// average colours from the image data (avoids reading back from the GPU later)
+// -----------------------------------------------------------------------------
+void loadTexture(MapTextureManager::Texture& mtex, const SImage& image, Palette* pal, gl::TexFilter filter)
+{
+	MemChunk rgba;
+	if (!image.putRGBAData(rgba, pal))
+		return;
+
+	mtex.gl_id = gl::Texture::createFromData(rgba.data(), image.width(), image.height(), filter);
+	if (!mtex.gl_id)
+		return;
+
+	unsigned height    = image.height();
+	unsigned avg_rows  = height * 0.4;
+	mtex.colour_top    = averageColour(rgba.data(), image.width(), 0, avg_rows);
+	mtex.colour_bottom = averageColour(rgba.data(), image.width(), height - avg_rows, height);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapTextureManager Class Functions
@@ -147,6 +204,8 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		mtex.gl_id = 0;
 	}
 
+	PROFILE_SCOPE("MapTextureManager::loadTexture");
+
 	// Texture not found or unloaded, look for it
 
 	// Look for composite textures first
@@ -159,7 +218,7 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		SImage image;
 		if (ctex->toImage(image, archive, palette_.get(), true))
 		{
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+			loadTexture(mtex, image, palette_.get(), filter);
 
 			double sx = ctex->scaleX();
 			if (sx == 0.0)
@@ -182,7 +241,7 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 			SImage image;
 			if (misc::loadImageFromEntry(&image, etex))
 			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+				loadTexture(mtex, image, palette_.get(), filter);
 
 				if (auto* ref = app::resources().getTextureEntry(name, "textures", archive))
 				{
@@ -207,7 +266,7 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 			SImage image;
 			etex = app::resources().getTextureEntry(name, "textures", archive);
 			if (misc::loadImageFromEntry(&image, etex))
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+				loadTexture(mtex, image, palette_.get(), filter);
 		}
 	}
 
@@ -256,6 +315,8 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 		mtex.gl_id = 0;
 	}
 
+	PROFILE_SCOPE("MapTextureManager::loadFlat");
+
 	// Prioritize standalone textures
 	auto archive = archive_.lock().get();
 	if (mixed && app::resources().getTextureEntry(name, "textures", archive))
@@ -271,7 +332,7 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 			SImage image;
 			if (ctex->toImage(image, archive, palette_.get(), true))
 			{
-				mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+				loadTexture(mtex, image, palette_.get(), filter);
 
 				double sx = ctex->scaleX();
 				if (sx == 0.0)
@@ -306,7 +367,7 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 		// Load the image
 		SImage image;
 		if (misc::loadImageFromEntry(&image, image_entry))
-			mtex.gl_id = gl::Texture::createFromImage(image, palette_.get(), filter);
+			loadTexture(mtex, image, palette_.get(), filter);
 		
 		// Get high-res texture scale
 		if (scale_entry)
@@ -380,6 +441,8 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		}
 	}
 
+	PROFILE_SCOPE("MapTextureManager::loadSprite");
+
 	// Sprite not found, look for it
 	bool   found  = false;
 	bool   mirror = false;
@@ -26,6 +26,8 @@ public:
 		unsigned gl_id         = 0;
 		bool     world_panning = false;
 		Vec2d    scale         = { 1., 1. };
+		ColRGBA  colour_top;    // Average colour of the top 40% of the image (for skies)
+		ColRGBA  colour_bottom; // Average colour of the bottom 40% of the image (for skies)
 		~Texture() { gl::Texture::clear(gl_id); }
 	};
 	typedef std::map<string, Texture> MapTexHashMap;
@@ -40,6 +40,7 @@
 #include "App.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
+#include "General/Profiler.h"
 #include "MapEditor/Edit/ObjectEdit.h"
 #include "MapEditor/MapEditContext.h"
 #include "MapEditor/MapEditor.h"
@@ -187,6 +188,8 @@ bool MapRenderer2D::setupVertexRendering(float size_scale, bool overlay) const
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderVertices(float alpha)
 {
+	PROFILE_SCOPE("MapRenderer2D::renderVertices");
+
 	// Check there are any vertices to render
 	if (map_->nVertices() == 0)
 		return;
@@ -376,6 +379,8 @@ ColRGBA MapRenderer2D::lineColour(MapLine* line, bool ignore_filter) const
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderLines(bool show_direction, float alpha)
 {
+	PROFILE_SCOPE("MapRenderer2D::renderLines");
+
 	// Check there are any lines to render
 	if (map_->nLines() == 0)
 		return;
@@ -1204,6 +1209,8 @@ void MapRenderer2D::renderSimpleSquareThing(
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderThings(float alpha, bool force_dir)
 {
+	PROFILE_SCOPE("MapRenderer2D::renderThings");
+
 	// Don't bother if (practically) invisible
 	if (alpha <= 0.01f)
 		return;
@@ -1948,6 +1955,8 @@ void MapRenderer2D::renderPointLightPreviews(float alpha, int hilight_index) con
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderFlats(int type, bool texture, float alpha)
 {
+	PROFILE_SCOPE("MapRenderer2D::renderFlats");
+
 	// Don't bother if (practically) invisible
 	if (alpha <= 0.01f)
 		return;
@@ -40,6 +40,7 @@
 #include "App.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
+#include "General/Profiler.h"
 #include "General/ResourceManager.h"
 #include "MainEditor/MainEditor.h"
 #include "MainEditor/UI/MainWindow.h"
@@ -88,6 +89,32 @@ EXTERN_CVAR(Bool, flats_use_vbo)
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns a key to sort [surface] (quad or flat) by, so that surfaces sharing
+// the same texture, [state_flags], light level, colour and fog colour are
+// rendered together and their GL state only needs to be set once
+// -----------------------------------------------------------------------------
+template<typename T>
+std::tuple<unsigned, uint8_t, uint8_t, uint32_t, uint32_t> stateSortKey(const T& surface, uint8_t state_flags)
+{
+	const auto& c = surface.colour;
+	const auto& f = surface.fogcolour;
+	return { surface.texture,
+			 static_cast<uint8_t>(surface.flags & state_flags),
+			 surface.light,
+			 static_cast<uint32_t>(c.r) << 24 | c.g << 16 | c.b << 8 | c.a,
+			 static_cast<uint32_t>(f.r) << 16 | f.g << 8 | f.b };
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapRenderer3D Class Functions
@@ -525,7 +552,16 @@ void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
 	// closer resemble the software renderer light level
 	float mult = (float)light / 255.0f;
 	mult *= (mult * 1.3f);
-	glColor4f(colour.fr() * mult, colour.fg() * mult, colour.fb() * mult, colour.fa() * alpha);
+	const float col[4] = { colour.fr() * mult, colour.fg() * mult, colour.fb() * mult, colour.fa() * alpha };
+
+	// Skip if the colour is already set
+	if (colour_last_valid_ && std::equal(col, col + 4, colour_last_))
+		return;
+
+	glColor4fv(col);
+	std::copy(col, col + 4, colour_last_);
+	colour_last_valid_ = true;
+	state_changes_++;
 }
 
 // -----------------------------------------------------------------------------
@@ -542,6 +578,7 @@ void MapRenderer3D::setFog(ColRGBA& fogcol, uint8_t light)
 	{
 		glFogfv(GL_FOG_COLOR, fogColor);
 		fog_colour_last_ = fogcol;
+		state_changes_++;
 	}
 
 
@@ -561,14 +598,30 @@ void MapRenderer3D::setFog(ColRGBA& fogcol, uint8_t light)
 	{
 		glFogf(GL_FOG_END, depth);
 		fog_depth_last_ = depth;
+		state_changes_++;
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Clears the last set colour and blend mode, so that they will be set again
+// on the next setLight/renderQuad. Must be called after anything else changes
+// the GL colour or blend function
+// -----------------------------------------------------------------------------
+void MapRenderer3D::invalidateStateCache()
+{
+	colour_last_valid_ = false;
+	blend_last_        = -1;
+}
+
 // -----------------------------------------------------------------------------
 // Renders the map in 3d
 // -----------------------------------------------------------------------------
 void MapRenderer3D::renderMap()
 {
+	PROFILE_SCOPE("MapRenderer3D::renderMap");
+
+	state_changes_ = 0;
+
 	// Setup GL stuff
 	glEnable(GL_DEPTH_TEST);
 	glCullFace(GL_BACK);
@@ -773,11 +826,8 @@ void MapRenderer3D::renderSky()
 	glTranslatef(0.0f, 0.0f, -10.0f);
 
 	// Get sky texture
-	unsigned sky;
-	if (!skytex2_.empty())
-		sky = mapeditor::textureManager().texture(skytex2_, false).gl_id;
-	else
-		sky = mapeditor::textureManager().texture(skytex1_, false).gl_id;
+	auto& sky_tex = mapeditor::textureManager().texture(skytex2_.empty() ? skytex1_ : skytex2_, false);
+	auto  sky     = sky_tex.gl_id;
 	if (sky)
 	{
 		// Bind texture
@@ -787,10 +837,18 @@ void MapRenderer3D::renderSky()
 		auto& tex_info = gl::Texture::info(sky);
 		if (skycol_top_.a == 0)
 		{
-			int theight    = tex_info.size.y * 0.4;
-			skycol_top_    = gl::Texture::averageColour(sky, { 0, 0, tex_info.size.x, theight });
-			skycol_bottom_ = gl::Texture::averageColour(
-				sky, { 0, tex_info.size.y - theight, tex_info.size.x, tex_info.size.y });
+			skycol_top_    = sky_tex.colour_top;
+			skycol_bottom_ = sky_tex.colour_bottom;
+
+			// No averages from the source image (eg. 'missing' texture), read
+			// back from the GPU instead
+			if (skycol_top_.a == 0)
+			{
+				int theight    = tex_info.size.y * 0.4;
+				skycol_top_    = gl::Texture::averageColour(sky, { 0, 0, tex_info.size.x, theight });
+				skycol_bottom_ = gl::Texture::averageColour(
+					sky, { 0, tex_info.size.y - theight, tex_info.size.x, tex_info.size.y });
+			}
 		}
 
 		// Render top cap
@@ -838,6 +896,7 @@ void MapRenderer3D::renderSky()
 
 	// Render all sky quads
 	glDisable(GL_TEXTURE_2D);
+	invalidateStateCache();
 	for (unsigned a = 0; a < n_quads_; a++)
 	{
 		// Ignore if not sky
@@ -1039,6 +1098,7 @@ void MapRenderer3D::renderFlat(Flat* flat)
 				glBindBuffer(GL_ARRAY_BUFFER, vbo_ceilings_);
 				Polygon2D::setupVBOPointers();
 				flat_last_ = 2;
+				state_changes_++;
 			}
 		}
 		else
@@ -1049,6 +1109,7 @@ void MapRenderer3D::renderFlat(Flat* flat)
 				glBindBuffer(GL_ARRAY_BUFFER, vbo_floors_);
 				Polygon2D::setupVBOPointers();
 				flat_last_ = 1;
+				state_changes_++;
 			}
 		}
 
@@ -1087,41 +1148,39 @@ void MapRenderer3D::renderFlat(Flat* flat)
 // -----------------------------------------------------------------------------
 void MapRenderer3D::renderFlats()
 {
+	PROFILE_SCOPE("MapRenderer3D::renderFlats");
+
 	// Check for map
 	if (!map_)
 		return;
 
 	// Init textures
 	glEnable(GL_TEXTURE_2D);
+	invalidateStateCache();
 
-	// Render all visible flats, ordered by texture
-	unsigned a        = 0;
+	// Sort flats by texture and render state (including floor/ceiling, which
+	// switches the vbo in use)
+	constexpr uint8_t state_flags = SKY | CEIL;
+	std::sort(
+		flats_,
+		flats_ + n_flats_,
+		[](const Flat* l, const Flat* r) { return stateSortKey(*l, state_flags) < stateSortKey(*r, state_flags); });
+
+	// Render all visible flats, only changing texture when needed
 	unsigned tex_last = 0;
 	flat_last_        = 0;
-	while (n_flats_ > 0)
+	for (unsigned a = 0; a < n_flats_; a++)
 	{
-		a        = 0;
-		tex_last = 0;
-		while (a < n_flats_)
+		if (flats_[a]->texture && flats_[a]->texture != tex_last)
 		{
-			// Check texture
-			if (!tex_last && flats_[a]->texture)
-			{
-				tex_last = flats_[a]->texture;
-				gl::Texture::bind(flats_[a]->texture);
-			}
-			if (flats_[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
-
-			// Render flat
-			renderFlat(flats_[a]);
-			flats_[a] = flats_[n_flats_ - 1];
-			n_flats_--;
+			tex_last = flats_[a]->texture;
+			gl::Texture::bind(tex_last);
+			state_changes_++;
 		}
+
+		renderFlat(flats_[a]);
 	}
+	n_flats_ = 0;
 
 	// Reset gl stuff
 	glDisable(GL_TEXTURE_2D);
@@ -1920,10 +1979,16 @@ void MapRenderer3D::renderQuad(MapRenderer3D::Quad* quad, float alpha)
 	}
 
 	// Checking for additive renderstyle
-	if (quad->flags & TRANSADD)
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-	else
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	int blend = quad->flags & TRANSADD ? 1 : 0;
+	if (blend != blend_last_)
+	{
+		if (blend)
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		else
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		blend_last_ = blend;
+		state_changes_++;
+	}
 
 	// Setup colour/light
 	setLight(quad->colour, quad->light, alpha);
@@ -1958,47 +2023,39 @@ void MapRenderer3D::renderQuad(MapRenderer3D::Quad* quad, float alpha)
 // -----------------------------------------------------------------------------
 void MapRenderer3D::renderWalls()
 {
+	PROFILE_SCOPE("MapRenderer3D::renderWalls");
+
 	// Init
-	quads_transparent_.clear();
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
+	invalidateStateCache();
+
+	// Set aside transparent quads to render last
+	auto opaque_end = std::partition(quads_, quads_ + n_quads_, [](const Quad* quad) { return quad->colour.a == 255; });
+	quads_transparent_.assign(opaque_end, quads_ + n_quads_);
+	n_quads_ = opaque_end - quads_;
 
-	// Render all visible quads, ordered by texture
-	unsigned a        = 0;
+	// Sort quads by texture and render state
+	constexpr uint8_t state_flags = TRANSADD | SKY | MIDTEX;
+	std::sort(
+		quads_,
+		quads_ + n_quads_,
+		[](const Quad* l, const Quad* r) { return stateSortKey(*l, state_flags) < stateSortKey(*r, state_flags); });
+
+	// Render all visible quads, only changing texture when needed
 	unsigned tex_last = 0;
-	while (n_quads_ > 0)
+	for (unsigned a = 0; a < n_quads_; a++)
 	{
-		tex_last = 0;
-		a        = 0;
-		while (a < n_quads_)
+		if (quads_[a]->texture && quads_[a]->texture != tex_last)
 		{
-			// Check alpha
-			if (quads_[a]->colour.a < 255)
-			{
-				quads_transparent_.push_back(quads_[a]);
-				quads_[a] = quads_[n_quads_ - 1];
-				n_quads_--;
-				continue;
-			}
-
-			// Check texture
-			if (!tex_last && quads_[a]->texture)
-			{
-				tex_last = quads_[a]->texture;
-				gl::Texture::bind(quads_[a]->texture);
-			}
-			if (quads_[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
-
-			// Render quad
-			renderQuad(quads_[a], quads_[a]->alpha);
-			quads_[a] = quads_[n_quads_ - 1];
-			n_quads_--;
+			tex_last = quads_[a]->texture;
+			gl::Texture::bind(tex_last);
+			state_changes_++;
 		}
+
+		renderQuad(quads_[a], quads_[a]->alpha);
 	}
+	n_quads_ = 0;
 
 	glDisable(GL_TEXTURE_2D);
 }
@@ -2014,10 +2071,18 @@ void MapRenderer3D::renderTransparentWalls()
 	glDisable(GL_ALPHA_TEST);
 	glCullFace(GL_BACK);
 
+	invalidateStateCache();
+
 	// Render all transparent quads
+	unsigned tex_last = 0;
 	for (auto& quad : quads_transparent_)
 	{
 		// Bind texture
+		if (quad->texture != tex_last)
+		{
+			tex_last = quad->texture;
+			state_changes_++;
+		}
 		gl::Texture::bind(quad->texture, false);
 
 		// Render quad
@@ -2217,9 +2282,12 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 // -----------------------------------------------------------------------------
 void MapRenderer3D::renderThings()
 {
+	PROFILE_SCOPE("MapRenderer3D::renderThings");
+
 	// Init
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
+	invalidateStateCache();
 	unsigned tex = 0;
 
 	// Go through things
@@ -2360,6 +2428,7 @@ void MapRenderer3D::renderThings()
 
 			// Fill
 			glColor4f(col.fr(), col.fg(), col.fb(), 0.21f);
+			colour_last_valid_ = false;
 			uint8_t light2  = 255;
 			auto    fogcol2 = ColRGBA(0, 0, 0, 0);
 			if (things_[a].sector)
@@ -2539,6 +2608,8 @@ void MapRenderer3D::renderThingSelection(const ItemSelection& selection, float a
 // -----------------------------------------------------------------------------
 void MapRenderer3D::updateFlatsVBO()
 {
+	PROFILE_SCOPE("MapRenderer3D::updateFlatsVBO");
+
 	if (!flats_use_vbo)
 		return;
 
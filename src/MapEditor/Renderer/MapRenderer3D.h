@@ -90,13 +90,14 @@ public:
 	MapRenderer3D(SLADEMap* map = nullptr);
 	~MapRenderer3D();
 
-	bool fullbrightEnabled() const { return fullbright_; }
-	bool fogEnabled() const { return fog_; }
-	void enableFullbright(bool enable = true) { fullbright_ = enable; }
-	void enableFog(bool enable = true) { fog_ = enable; }
-	int  itemDistance() const { return item_dist_; }
-	void enableHilight(bool render) { render_hilight_ = render; }
-	void enableSelection(bool render) { render_selection_ = render; }
+	bool     fullbrightEnabled() const { return fullbright_; }
+	bool     fogEnabled() const { return fog_; }
+	void     enableFullbright(bool enable = true) { fullbright_ = enable; }
+	void     enableFog(bool enable = true) { fog_ = enable; }
+	int      itemDistance() const { return item_dist_; }
+	unsigned stateChanges() const { return state_changes_; }
+	void     enableHilight(bool render) { render_hilight_ = render; }
+	void     enableSelection(bool render) { render_selection_ = render; }
 
 	bool init();
 	void refresh();
@@ -127,6 +128,7 @@ public:
 	void setupView(int width, int height);
 	void setLight(ColRGBA& colour, uint8_t light, float alpha = 1.0f) const;
 	void setFog(ColRGBA& fogcol, uint8_t light);
+	void invalidateStateCache();
 	void renderMap();
 	void renderSkySlice(
 		float top,
@@ -195,6 +197,12 @@ private:
 	ColRGBA   fog_colour_last_;
 	float     fog_depth_last_ = 0.f;
 
+	// GL state tracking (to skip redundant state changes)
+	mutable float    colour_last_[4]    = { 0.f, 0.f, 0.f, 0.f };
+	mutable bool     colour_last_valid_ = false;
+	int              blend_last_        = -1;
+	mutable unsigned state_changes_     = 0; // Number of GL state changes in the last frame
+
 	// Visibility
 	vector<float> dist_sectors_;
 
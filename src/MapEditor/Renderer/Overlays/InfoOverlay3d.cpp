@@ -53,6 +53,14 @@
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, info_overlay_3d_render_stats, false, CVar::Flag::Save)
+
+
 // -----------------------------------------------------------------------------
 //
 // External Variables
@@ -559,6 +567,16 @@ void InfoOverlay3D::draw(int bottom, int right, int middle, float alpha)
 		y -= line_height;
 	}
 
+	// Draw render stats (bottom right)
+	if (info_overlay_3d_render_stats)
+		drawing::drawText(
+			fmt::format("{} GL state changes", mapeditor::editContext().renderer().renderer3D().stateChanges()),
+			right - 4,
+			bottom - line_height - 2,
+			col_fg,
+			drawing::Font::Condensed,
+			drawing::Align::Right);
+
 	// Draw texture if any
 	drawTexture(alpha, middle - (40 * scale), bottom);
 
@@ -41,6 +41,7 @@
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/ColourConfiguration.h"
+#include "General/Profiler.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
 #include "OpenGL/Drawing.h"
@@ -981,6 +982,8 @@ void Renderer::drawAnimations() const
 // -----------------------------------------------------------------------------
 void Renderer::drawMap2d()
 {
+	PROFILE_SCOPE("Renderer::drawMap2d");
+
 	// Apply the current 2d view
 	view_.apply();
 
@@ -1208,6 +1211,8 @@ void Renderer::drawMap2d()
 // -----------------------------------------------------------------------------
 void Renderer::drawMap3d()
 {
+	PROFILE_SCOPE("Renderer::drawMap3d");
+
 	// Setup 3d renderer view
 	renderer_3d_.setupView(view_.size().x, view_.size().y);
 
@@ -1233,6 +1238,8 @@ void Renderer::drawMap3d()
 // -----------------------------------------------------------------------------
 void Renderer::draw()
 {
+	PROFILE_SCOPE("Renderer::draw");
+
 	// Setup the viewport
 	glViewport(0, 0, view_.size().x, view_.size().y);
 
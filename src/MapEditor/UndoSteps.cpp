@@ -6,37 +6,283 @@
 using namespace slade;
 using namespace mapeditor;
 
+namespace
+{
+void writeString(MemChunk& mc, const string& str)
+{
+	uint32_t len = str.size();
+	mc.write(&len, 4);
+	if (len > 0)
+		mc.write(str.data(), len);
+}
+
+bool readString(MemChunk& mc, string& str)
+{
+	uint32_t len = 0;
+	if (!mc.read(&len, 4) || mc.currentPos() + len > mc.size())
+		return false;
+
+	str.assign(reinterpret_cast<const char*>(mc.data() + mc.currentPos()), len);
+	return mc.seek(len, SEEK_CUR);
+}
+
+void writeProperty(MemChunk& mc, const std::optional<Property>& prop)
+{
+	// Type index, 0xFF if no value
+	uint8_t type = prop ? static_cast<uint8_t>(prop->index()) : 0xFF;
+	mc.write(&type, 1);
+	if (!prop)
+		return;
+
+	switch (property::valueType(*prop))
+	{
+	case property::ValueType::Bool:
+	{
+		uint8_t val = std::get<bool>(*prop) ? 1 : 0;
+		mc.write(&val, 1);
+		break;
+	}
+	case property::ValueType::Int: mc.write(&std::get<int>(*prop), sizeof(int)); break;
+	case property::ValueType::UInt: mc.write(&std::get<unsigned>(*prop), sizeof(unsigned)); break;
+	case property::ValueType::Float: mc.write(&std::get<double>(*prop), sizeof(double)); break;
+	case property::ValueType::String: writeString(mc, std::get<string>(*prop)); break;
+	}
+}
+
+bool readProperty(MemChunk& mc, std::optional<Property>& prop)
+{
+	uint8_t type = 0xFF;
+	if (!mc.read(&type, 1))
+		return false;
+
+	if (type == 0xFF)
+	{
+		prop.reset();
+		return true;
+	}
+
+	switch (static_cast<property::ValueType>(type))
+	{
+	case property::ValueType::Bool:
+	{
+		uint8_t val = 0;
+		if (!mc.read(&val, 1))
+			return false;
+
+		prop = val != 0;
+		return true;
+	}
+	case property::ValueType::Int:
+	{
+		int val = 0;
+		prop    = val;
+		return mc.read(&std::get<int>(*prop), sizeof(int));
+	}
+	case property::ValueType::UInt:
+	{
+		unsigned val = 0;
+		prop         = val;
+		return mc.read(&std::get<unsigned>(*prop), sizeof(unsigned));
+	}
+	case property::ValueType::Float:
+	{
+		double val = 0.;
+		prop       = val;
+		return mc.read(&std::get<double>(*prop), sizeof(double));
+	}
+	case property::ValueType::String:
+	{
+		prop = string{};
+		return readString(mc, std::get<string>(*prop));
+	}
+	default: return false;
+	}
+}
+
+size_t propertySize(const std::optional<Property>& prop)
+{
+	if (prop && property::valueType(*prop) == property::ValueType::String)
+		return std::get<string>(*prop).capacity();
+
+	return 0;
+}
+
+// Adds fields for all properties in [before] and [after] that differ to [fields]
+void addChangedFields(
+	const PropertyList&            before,
+	const PropertyList&            after,
+	bool                           internal,
+	vector<MapObjectDelta::Field>& fields)
+{
+	for (const auto& prop : before.properties())
+	{
+		auto after_val = after.getIf(prop.name);
+		if (!after_val || *after_val != prop.value)
+			fields.push_back({ prop.name, internal, prop.value, after_val });
+	}
+
+	for (const auto& prop : after.properties())
+		if (!before.contains(prop.name))
+			fields.push_back({ prop.name, internal, std::nullopt, prop.value });
+}
+
+void writeIdList(MemChunk& mc, const vector<unsigned>& list)
+{
+	uint32_t count = list.size();
+	mc.write(&count, 4);
+	if (count > 0)
+		mc.write(list.data(), count * sizeof(unsigned));
+}
+
+bool readIdList(MemChunk& mc, vector<unsigned>& list)
+{
+	uint32_t count = 0;
+	if (!mc.read(&count, 4) || mc.currentPos() + count * sizeof(unsigned) > mc.size())
+		return false;
+
+	list.resize(count);
+	return count == 0 || mc.read(list.data(), count * sizeof(unsigned));
+}
+} // namespace
+
+
+MapObjectDelta::MapObjectDelta(const MapObject::Backup& before, const MapObject::Backup& after) :
+	id{ before.id },
+	type{ before.type }
+{
+	addChangedFields(before.properties, after.properties, false, fields);
+	addChangedFields(before.props_internal, after.props_internal, true, fields);
+}
+
+void MapObjectDelta::apply(MapObject* object, bool undo) const
+{
+	// Apply changed fields on top of the object's current state
+	MapObject::Backup backup;
+	object->backupTo(&backup);
+	for (const auto& field : fields)
+	{
+		auto& props = field.internal ? backup.props_internal : backup.properties;
+		auto& value = undo ? field.before : field.after;
+		if (value)
+			props[field.name] = *value;
+		else
+			props.remove(field.name);
+	}
+
+	object->loadFromBackup(&backup);
+}
+
+size_t MapObjectDelta::dataSize() const
+{
+	size_t size = sizeof(MapObjectDelta) + fields.capacity() * sizeof(Field);
+	for (const auto& field : fields)
+		size += field.name.capacity() + propertySize(field.before) + propertySize(field.after);
+
+	return size;
+}
+
+void MapObjectDelta::write(MemChunk& mc) const
+{
+	uint8_t  obj_type = static_cast<uint8_t>(type);
+	uint32_t count    = fields.size();
+	mc.write(&id, 4);
+	mc.write(&obj_type, 1);
+	mc.write(&count, 4);
+	for (const auto& field : fields)
+	{
+		uint8_t internal = field.internal ? 1 : 0;
+		writeString(mc, field.name);
+		mc.write(&internal, 1);
+		writeProperty(mc, field.before);
+		writeProperty(mc, field.after);
+	}
+}
+
+bool MapObjectDelta::read(MemChunk& mc)
+{
+	uint8_t  obj_type = 0;
+	uint32_t count    = 0;
+	if (!mc.read(&id, 4) || !mc.read(&obj_type, 1) || !mc.read(&count, 4))
+		return false;
+
+	type = static_cast<MapObject::Type>(obj_type);
+	fields.clear();
+	fields.resize(count);
+	for (auto& field : fields)
+	{
+		uint8_t internal = 0;
+		if (!readString(mc, field.name) || !mc.read(&internal, 1) || !readProperty(mc, field.before)
+			|| !readProperty(mc, field.after))
+			return false;
+
+		field.internal = internal != 0;
+	}
+
+	return true;
+}
+
+
+
 PropertyChangeUS::PropertyChangeUS(MapObject* object) : backup_{ new MapObject::Backup() }
 {
 	object->backupTo(backup_.get());
+	delta_.id   = backup_->id;
+	delta_.type = backup_->type;
 }
 
-void PropertyChangeUS::doSwap(MapObject* obj)
+void PropertyChangeUS::recordEnded()
 {
-	auto temp = std::make_unique<MapObject::Backup>();
-	obj->backupTo(temp.get());
-	obj->loadFromBackup(backup_.get());
-	backup_.swap(temp);
+	// Keep only what changed between the initial backup and the object's
+	// current state
+	if (!backup_)
+		return;
+
+	if (auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id))
+	{
+		MapObject::Backup current;
+		obj->backupTo(&current);
+		delta_ = MapObjectDelta(*backup_, current);
+	}
+
+	backup_.reset();
 }
 
 bool PropertyChangeUS::doUndo()
 {
-	auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id);
+	recordEnded();
+
+	auto obj = undoredo::currentMap()->mapData().getObjectById(delta_.id);
 	if (obj)
-		doSwap(obj);
+		delta_.apply(obj, true);
 
 	return true;
 }
 
 bool PropertyChangeUS::doRedo()
 {
-	auto obj = undoredo::currentMap()->mapData().getObjectById(backup_->id);
+	auto obj = undoredo::currentMap()->mapData().getObjectById(delta_.id);
 	if (obj)
-		doSwap(obj);
+		delta_.apply(obj, false);
+
+	return true;
+}
 
+bool PropertyChangeUS::writeFile(MemChunk& mc)
+{
+	delta_.write(mc);
 	return true;
 }
 
+bool PropertyChangeUS::readFile(MemChunk& mc)
+{
+	return delta_.read(mc);
+}
+
+size_t PropertyChangeUS::dataSize() const
+{
+	return backup_ ? 0 : delta_.dataSize();
+}
+
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
@@ -210,6 +456,37 @@ void MapObjectCreateDeleteUS::checkChanges()
 	}
 }
 
+bool MapObjectCreateDeleteUS::writeFile(MemChunk& mc)
+{
+	writeIdList(mc, vertices_);
+	writeIdList(mc, lines_);
+	writeIdList(mc, sides_);
+	writeIdList(mc, sectors_);
+	writeIdList(mc, things_);
+	return true;
+}
+
+bool MapObjectCreateDeleteUS::readFile(MemChunk& mc)
+{
+	return readIdList(mc, vertices_) && readIdList(mc, lines_) && readIdList(mc, sides_) && readIdList(mc, sectors_)
+		   && readIdList(mc, things_);
+}
+
+size_t MapObjectCreateDeleteUS::dataSize() const
+{
+	return (vertices_.capacity() + lines_.capacity() + sides_.capacity() + sectors_.capacity() + things_.capacity())
+		   * sizeof(unsigned);
+}
+
+void MapObjectCreateDeleteUS::clearData()
+{
+	vector<unsigned>().swap(vertices_);
+	vector<unsigned>().swap(lines_);
+	vector<unsigned>().swap(sides_);
+	vector<unsigned>().swap(sectors_);
+	vector<unsigned>().swap(things_);
+}
+
 bool MapObjectCreateDeleteUS::isOk()
 {
 	// Check for any changes at all
@@ -222,42 +499,39 @@ bool MapObjectCreateDeleteUS::isOk()
 
 MultiMapObjectPropertyChangeUS::MultiMapObjectPropertyChangeUS()
 {
-	// Get backups of recently modified map objects
-	auto objects = undoredo::currentMap()->mapData().allModifiedObjects(MapObject::propBackupTime());
+	// Get backups of map objects modified since recording began, and keep
+	// only what changed in each
+	vector<MapObject*> objects;
+	MapObject::putPropBackupObjects(objects);
 	for (auto& object : objects)
 	{
-		auto bak = object->backup(true);
-		if (bak)
-		{
-			backups_.emplace_back(bak);
-			// log::info(1, "%s #%d modified", objects[a]->getTypeName(), objects[a]->getIndex());
-		}
+		unique_ptr<MapObject::Backup> bak{ object->backup(true) };
+		if (!bak)
+			continue;
+
+		MapObject::Backup current;
+		object->backupTo(&current);
+		MapObjectDelta delta(*bak, current);
+		if (!delta.empty())
+			deltas_.push_back(std::move(delta));
 	}
 
 	if (log::verbosity() >= 2)
 	{
 		string msg = "Modified ids: ";
-		for (auto& backup : backups_)
-			msg += fmt::format("{}, ", backup->id);
+		for (auto& delta : deltas_)
+			msg += fmt::format("{}, ", delta.id);
 		log::info(msg);
 	}
 }
 
-void MultiMapObjectPropertyChangeUS::doSwap(MapObject* obj, unsigned index)
-{
-	auto temp = std::make_unique<MapObject::Backup>();
-	obj->backupTo(temp.get());
-	obj->loadFromBackup(backups_[index].get());
-	backups_[index].swap(temp);
-}
-
 bool MultiMapObjectPropertyChangeUS::doUndo()
 {
-	for (unsigned a = 0; a < backups_.size(); a++)
+	for (auto& delta : deltas_)
 	{
-		auto obj = undoredo::currentMap()->mapData().getObjectById(backups_[a]->id);
+		auto obj = undoredo::currentMap()->mapData().getObjectById(delta.id);
 		if (obj)
-			doSwap(obj, a);
+			delta.apply(obj, true);
 	}
 
 	return true;
@@ -265,13 +539,45 @@ bool MultiMapObjectPropertyChangeUS::doUndo()
 
 bool MultiMapObjectPropertyChangeUS::doRedo()
 {
-	// log::info(2, "Restore %lu objects", backups.size());
-	for (unsigned a = 0; a < backups_.size(); a++)
+	for (auto& delta : deltas_)
 	{
-		auto obj = undoredo::currentMap()->mapData().getObjectById(backups_[a]->id);
+		auto obj = undoredo::currentMap()->mapData().getObjectById(delta.id);
 		if (obj)
-			doSwap(obj, a);
+			delta.apply(obj, false);
 	}
 
 	return true;
 }
+
+bool MultiMapObjectPropertyChangeUS::writeFile(MemChunk& mc)
+{
+	uint32_t count = deltas_.size();
+	mc.write(&count, 4);
+	for (auto& delta : deltas_)
+		delta.write(mc);
+
+	return true;
+}
+
+bool MultiMapObjectPropertyChangeUS::readFile(MemChunk& mc)
+{
+	uint32_t count = 0;
+	if (!mc.read(&count, 4))
+		return false;
+
+	deltas_.resize(count);
+	for (auto& delta : deltas_)
+		if (!delta.read(mc))
+			return false;
+
+	return true;
+}
+
+size_t MultiMapObjectPropertyChangeUS::dataSize() const
+{
+	size_t size = deltas_.capacity() * sizeof(MapObjectDelta);
+	for (auto& delta : deltas_)
+		size += delta.dataSize() - sizeof(MapObjectDelta);
+
+	return size;
+}
@@ -5,6 +5,32 @@
 
 namespace slade::mapeditor
 {
+// The changed properties of a MapObject between two states, so that an undo
+// step only needs to keep what actually changed rather than full backups
+struct MapObjectDelta
+{
+	struct Field
+	{
+		string                  name;
+		bool                    internal = false; // Object-specific (Backup::props_internal) property
+		std::optional<Property> before;           // No value if the property didn't exist before
+		std::optional<Property> after;            // No value if the property doesn't exist after
+	};
+
+	unsigned        id   = 0;
+	MapObject::Type type = MapObject::Type::Object;
+	vector<Field>   fields;
+
+	MapObjectDelta() = default;
+	MapObjectDelta(const MapObject::Backup& before, const MapObject::Backup& after);
+
+	bool   empty() const { return fields.empty(); }
+	void   apply(MapObject* object, bool undo) const;
+	size_t dataSize() const;
+	void   write(MemChunk& mc) const;
+	bool   read(MemChunk& mc);
+};
+
 // UndoStep for when a MapObject has properties changed
 class PropertyChangeUS : public UndoStep
 {
@@ -12,12 +38,18 @@ public:
 	PropertyChangeUS(MapObject* object);
 	~PropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj);
 	bool doUndo() override;
 	bool doRedo() override;
+	void recordEnded() override;
+
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t dataSize() const override;
+	void   clearData() override { delta_.fields.clear(); }
 
 private:
-	unique_ptr<MapObject::Backup> backup_;
+	unique_ptr<MapObject::Backup> backup_; // Object state before the change, until recording ends
+	MapObjectDelta                delta_;
 };
 
 // UndoStep for when a MapObject is either created or deleted
@@ -34,6 +66,11 @@ public:
 	void checkChanges();
 	bool isOk() override;
 
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t dataSize() const override;
+	void   clearData() override;
+
 private:
 	vector<unsigned> vertices_;
 	vector<unsigned> lines_;
@@ -49,12 +86,16 @@ public:
 	MultiMapObjectPropertyChangeUS();
 	~MultiMapObjectPropertyChangeUS() = default;
 
-	void doSwap(MapObject* obj, unsigned index);
 	bool doUndo() override;
 	bool doRedo() override;
-	bool isOk() override { return !backups_.empty(); }
+	bool isOk() override { return !deltas_.empty(); }
+
+	bool   writeFile(MemChunk& mc) override;
+	bool   readFile(MemChunk& mc) override;
+	size_t dataSize() const override;
+	void   clearData() override { deltas_.clear(); }
 
 private:
-	vector<unique_ptr<MapObject::Backup>> backups_;
+	vector<MapObjectDelta> deltas_;
 };
 } // namespace slade::mapeditor
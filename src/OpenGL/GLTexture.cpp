@@ -31,6 +31,8 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "GLTexture.h"
+#include "General/Jobs.h"
+#include "General/Profiler.h"
 #include "Graphics/SImage/SImage.h"
 #include "OpenGL.h"
 
@@ -53,6 +55,167 @@ unsigned                        last_bound_tex = 0;
 } // namespace
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Runs [fn] for bands of rows covering [0, height) of a [width]x[height]
+// image. Images large enough for it to pay off are split across the job
+// threads, smaller ones are done in a single band on the calling thread
+// -----------------------------------------------------------------------------
+void forRowBands(unsigned width, unsigned height, const std::function<void(unsigned, unsigned)>& fn)
+{
+	static constexpr unsigned band_pixels = 64 * 1024;
+
+	auto band_rows = std::max(band_pixels / width, 1u);
+	auto n_bands   = (height + band_rows - 1) / band_rows;
+	if (n_bands < 2)
+	{
+		fn(0, height);
+		return;
+	}
+
+	jobs::parallelFor(
+		n_bands,
+		[&](unsigned band) { fn(band * band_rows, std::min((band + 1) * band_rows, height)); });
+}
+
+// -----------------------------------------------------------------------------
+// Returns the power of two closest to [size], limited to [max]
+// -----------------------------------------------------------------------------
+unsigned nearestPowerOfTwo(unsigned size, unsigned max)
+{
+	unsigned pow2 = 1;
+	while (pow2 * 2 <= size)
+		pow2 *= 2;
+	if (size - pow2 > pow2 / 2)
+		pow2 *= 2;
+
+	return std::min(pow2, max);
+}
+
+// -----------------------------------------------------------------------------
+// Bilinearly rescales RGBA [data] of [width]x[height] to
+// [new_width]x[new_height] into [scaled]
+// -----------------------------------------------------------------------------
+void scaleImage(
+	const uint8_t*   data,
+	unsigned         width,
+	unsigned         height,
+	unsigned         new_width,
+	unsigned         new_height,
+	vector<uint8_t>& scaled)
+{
+	scaled.resize(new_width * new_height * 4);
+
+	auto scale_x = static_cast<float>(width) / new_width;
+	auto scale_y = static_cast<float>(height) / new_height;
+	forRowBands(
+		new_width,
+		new_height,
+		[&](unsigned y_start, unsigned y_end)
+		{
+			for (auto y = y_start; y < y_end; ++y)
+			{
+				auto sy   = std::max((y + 0.5f) * scale_y - 0.5f, 0.f);
+				auto y1   = std::min(static_cast<unsigned>(sy), height - 1);
+				auto y2   = std::min(y1 + 1, height - 1);
+				auto fy   = sy - y1;
+				auto row1 = data + y1 * width * 4;
+				auto row2 = data + y2 * width * 4;
+				auto out  = scaled.data() + y * new_width * 4;
+				for (unsigned x = 0; x < new_width; ++x)
+				{
+					auto sx = std::max((x + 0.5f) * scale_x - 0.5f, 0.f);
+					auto x1 = std::min(static_cast<unsigned>(sx), width - 1);
+					auto x2 = std::min(x1 + 1, width - 1);
+					auto fx = sx - x1;
+					for (unsigned c = 0; c < 4; ++c)
+					{
+						auto top    = row1[x1 * 4 + c] + (row1[x2 * 4 + c] - row1[x1 * 4 + c]) * fx;
+						auto bottom = row2[x1 * 4 + c] + (row2[x2 * 4 + c] - row2[x1 * 4 + c]) * fx;
+						*out++      = static_cast<uint8_t>(top + (bottom - top) * fy + 0.5f);
+					}
+				}
+			}
+		});
+}
+
+// -----------------------------------------------------------------------------
+// Generates the next mipmap level down from RGBA [data] of [width]x[height]
+// into [mip], using a 2x2 box filter. Odd edges are clamped
+// -----------------------------------------------------------------------------
+void generateMipLevel(const uint8_t* data, unsigned width, unsigned height, vector<uint8_t>& mip)
+{
+	auto mip_width  = std::max(width / 2, 1u);
+	auto mip_height = std::max(height / 2, 1u);
+	mip.resize(mip_width * mip_height * 4);
+
+	forRowBands(
+		mip_width,
+		mip_height,
+		[&](unsigned y_start, unsigned y_end)
+		{
+			for (auto y = y_start; y < y_end; ++y)
+			{
+				auto row1 = data + std::min(y * 2, height - 1) * width * 4;
+				auto row2 = data + std::min(y * 2 + 1, height - 1) * width * 4;
+				auto out  = mip.data() + y * mip_width * 4;
+				for (unsigned x = 0; x < mip_width; ++x)
+				{
+					auto x1 = std::min(x * 2, width - 1) * 4;
+					auto x2 = std::min(x * 2 + 1, width - 1) * 4;
+					for (unsigned c = 0; c < 4; ++c)
+						*out++ = (row1[x1 + c] + row1[x2 + c] + row2[x1 + c] + row2[x2 + c] + 2) / 4;
+				}
+			}
+		});
+}
+
+// -----------------------------------------------------------------------------
+// Uploads RGBA [data] of [width]x[height] to the currently bound texture along
+// with a full chain of mipmaps generated from it on the CPU. If the OpenGL
+// implementation doesn't support non-power-of-two textures, the image is
+// first rescaled to the nearest power of two size (as gluBuild2DMipmaps did)
+// -----------------------------------------------------------------------------
+void uploadMipmapped(const uint8_t* data, unsigned width, unsigned height)
+{
+	vector<uint8_t> prev, mip;
+	if (!gl::np2TexSupport())
+	{
+		auto max_size    = std::max(gl::maxTextureSize(), 1u);
+		auto pow2_width  = nearestPowerOfTwo(width, max_size);
+		auto pow2_height = nearestPowerOfTwo(height, max_size);
+		if (pow2_width != width || pow2_height != height)
+		{
+			scaleImage(data, width, height, pow2_width, pow2_height, prev);
+			data   = prev.data();
+			width  = pow2_width;
+			height = pow2_height;
+		}
+	}
+
+	glTexImage2D(GL_TEXTURE_2D, 0, 4, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+	int level = 0;
+	while (width > 1 || height > 1)
+	{
+		generateMipLevel(level == 0 ? data : prev.data(), width, height, mip);
+		width  = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		glTexImage2D(GL_TEXTURE_2D, ++level, 4, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.data());
+		prev.swap(mip);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Texture Struct Static Functions
@@ -190,6 +353,8 @@ unsigned gl::Texture::createFromData(
 // -----------------------------------------------------------------------------
 unsigned gl::Texture::createFromImage(const SImage& image, Palette* pal, TexFilter filter, bool tiling)
 {
+	PROFILE_SCOPE("gl::Texture::createFromImage");
+
 	auto id = create(filter, tiling);
 	if (!loadImage(id, image, pal))
 	{
@@ -249,13 +414,13 @@ bool gl::Texture::loadData(unsigned id, const uint8_t* data, unsigned width, uns
 	{
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		uploadMipmapped(data, width, height);
 	}
 	else if (tex_info.filter == TexFilter::NearestMipmap)
 	{
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		uploadMipmapped(data, width, height);
 	}
 	else if (tex_info.filter == TexFilter::NearestLinearMin)
 	{
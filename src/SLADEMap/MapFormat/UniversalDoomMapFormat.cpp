@@ -38,6 +38,7 @@
 #include "UniversalDoomMapFormat.h"
 #include "App.h"
 #include "Game/Configuration.h"
+#include "General/Profiler.h"
 #include "General/UI.h"
 #include "SLADEMap/MapObject/MapLine.h"
 #include "SLADEMap/MapObject/MapSector.h"
@@ -245,81 +246,91 @@ vector<unique_ptr<ArchiveEntry>> UniversalDoomMapFormat::writeMap(
 	tempfile.Write(map_extra_props.toString(true));
 	tempfile.Write("\n");
 
-	// sf::Clock clock;
-
 	// Locale for float number format
 	setlocale(LC_NUMERIC, "C");
 
-	// Write things
 	string object_def;
-	for (const auto& thing : map_data.things())
+
+	// Write things
 	{
-		// Cleanup properties
-		if (!thing->props().empty())
+		PROFILE_SCOPE("UniversalDoomMapFormat::writeThings");
+
+		for (const auto& thing : map_data.things())
 		{
-			thing->props().remove("flags");
-			game::configuration().cleanObjectUDMFProps(thing);
+			// Cleanup properties
+			if (!thing->props().empty())
+			{
+				thing->props().remove("flags");
+				game::configuration().cleanObjectUDMFProps(thing);
+			}
+
+			thing->writeUDMF(object_def);
+			tempfile.Write(object_def);
 		}
-
-		thing->writeUDMF(object_def);
-		tempfile.Write(object_def);
 	}
-	// log::info(1, "Writing things took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write lines
-	// clock.restart();
-	for (const auto& line : map_data.lines())
 	{
-		// Cleanup properties
-		if (!line->props().empty())
+		PROFILE_SCOPE("UniversalDoomMapFormat::writeLines");
+
+		for (const auto& line : map_data.lines())
 		{
-			line->props().remove("flags");
-			game::configuration().cleanObjectUDMFProps(line);
+			// Cleanup properties
+			if (!line->props().empty())
+			{
+				line->props().remove("flags");
+				game::configuration().cleanObjectUDMFProps(line);
+			}
+
+			line->writeUDMF(object_def);
+			tempfile.Write(object_def);
 		}
-
-		line->writeUDMF(object_def);
-		tempfile.Write(object_def);
 	}
-	// log::info(1, "Writing lines took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write sides
-	// clock.restart();
-	for (const auto& side : map_data.sides())
 	{
-		// Cleanup properties
-		if (!side->props().empty())
-			game::configuration().cleanObjectUDMFProps(side);
+		PROFILE_SCOPE("UniversalDoomMapFormat::writeSides");
 
-		side->writeUDMF(object_def);
-		tempfile.Write(object_def);
+		for (const auto& side : map_data.sides())
+		{
+			// Cleanup properties
+			if (!side->props().empty())
+				game::configuration().cleanObjectUDMFProps(side);
+
+			side->writeUDMF(object_def);
+			tempfile.Write(object_def);
+		}
 	}
-	// log::info(1, "Writing sides took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write vertices
-	// clock.restart();
-	for (const auto& vertex : map_data.vertices())
 	{
-		// Cleanup properties
-		if (!vertex->props().empty())
-			game::configuration().cleanObjectUDMFProps(vertex);
+		PROFILE_SCOPE("UniversalDoomMapFormat::writeVertices");
+
+		for (const auto& vertex : map_data.vertices())
+		{
+			// Cleanup properties
+			if (!vertex->props().empty())
+				game::configuration().cleanObjectUDMFProps(vertex);
 
-		vertex->writeUDMF(object_def);
-		tempfile.Write(object_def);
+			vertex->writeUDMF(object_def);
+			tempfile.Write(object_def);
+		}
 	}
-	// log::info(1, "Writing vertices took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Write sectors
-	// clock.restart();
-	for (const auto& sector : map_data.sectors())
 	{
-		// Cleanup properties
-		if (!sector->props().empty())
-			game::configuration().cleanObjectUDMFProps(sector);
+		PROFILE_SCOPE("UniversalDoomMapFormat::writeSectors");
+
+		for (const auto& sector : map_data.sectors())
+		{
+			// Cleanup properties
+			if (!sector->props().empty())
+				game::configuration().cleanObjectUDMFProps(sector);
 
-		sector->writeUDMF(object_def);
-		tempfile.Write(object_def);
+			sector->writeUDMF(object_def);
+			tempfile.Write(object_def);
+		}
 	}
-	// log::info(1, "Writing sectors took %dms", clock.getElapsedTime().asMilliseconds());
 
 	// Close file
 	tempfile.Close();
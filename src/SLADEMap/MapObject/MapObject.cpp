@@ -51,7 +51,8 @@ using namespace slade;
 // -----------------------------------------------------------------------------
 namespace
 {
-long prop_backup_time = -1;
+long               prop_backup_time = -1;
+vector<MapObject*> prop_backup_objects; // Objects backed up since prop_backup_time
 } // namespace
 
 
@@ -106,6 +107,7 @@ void MapObject::setModified()
 	{
 		obj_backup_ = std::make_unique<Backup>();
 		backupTo(obj_backup_.get());
+		prop_backup_objects.push_back(this);
 	}
 
 	modified_time_ = app::runTimer();
@@ -332,6 +334,18 @@ long MapObject::propBackupTime()
 void MapObject::beginPropBackup(long current_time)
 {
 	prop_backup_time = current_time;
+	if (current_time >= 0)
+		prop_backup_objects.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds all objects that have been backed up since the last call to
+// beginPropBackup to [list], so they can be found without checking every
+// object in the map
+// -----------------------------------------------------------------------------
+void MapObject::putPropBackupObjects(vector<MapObject*>& list)
+{
+	list.insert(list.end(), prop_backup_objects.begin(), prop_backup_objects.end());
 }
 
 // -----------------------------------------------------------------------------
@@ -102,6 +102,7 @@ public:
 	static long propBackupTime();
 	static void beginPropBackup(long current_time);
 	static void endPropBackup();
+	static void putPropBackupObjects(vector<MapObject*>& list);
 
 	static bool multiBoolProperty(vector<MapObject*>& objects, string_view prop, bool& value);
 	static bool multiIntProperty(vector<MapObject*>& objects, string_view prop, int& value);
@@ -0,0 +1,714 @@
+
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    MapPreview.cpp
+// Description: MapPreview class, reads basic map geometry from map data and
+//              renders map overview images with a multi-threaded software
+//              rasterizer (no OpenGL context needed)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapPreview.h"
+#include "Archive/ArchiveEntry.h"
+#include "Archive/EntryType/EntryType.h"
+#include "Archive/Formats/WadArchive.h"
+#include "General/ColourConfiguration.h"
+#include "General/Jobs.h"
+#include "Graphics/SImage/SImage.h"
+#include "SLADEMap/MapFormat/Doom32XMapFormat.h"
+#include "SLADEMap/MapFormat/Doom64MapFormat.h"
+#include "SLADEMap/MapFormat/DoomMapFormat.h"
+#include "SLADEMap/MapFormat/HexenMapFormat.h"
+#include "Utility/Tokenizer.h"
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Float, map_image_thickness, 1.5, CVar::Flag::Save)
+
+namespace
+{
+constexpr int BAND_HEIGHT = 16; // Height (in pixels) of the image bands rendered by each job
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A line or thing to be rasterized, in image coordinates
+struct Primitive
+{
+	double  x1, y1, x2, y2; // Line ends, or thing centre (x1,y1)
+	double  radius;         // Half line thickness, or thing radius
+	bool    disc;           // True if this is a thing
+	ColRGBA colour;
+};
+
+// -----------------------------------------------------------------------------
+// Blends [colour] with [coverage] (0-1) onto the RGBA pixel at [dest]
+// -----------------------------------------------------------------------------
+void blendPixel(uint8_t* dest, const ColRGBA& colour, double coverage)
+{
+	auto alpha = colour.a * coverage / 255.;
+	dest[0]    = static_cast<uint8_t>(dest[0] + (colour.r - dest[0]) * alpha + 0.5);
+	dest[1]    = static_cast<uint8_t>(dest[1] + (colour.g - dest[1]) * alpha + 0.5);
+	dest[2]    = static_cast<uint8_t>(dest[2] + (colour.b - dest[2]) * alpha + 0.5);
+	dest[3]    = static_cast<uint8_t>(dest[3] + (255 - dest[3]) * alpha + 0.5);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the coverage (0-1) of a pixel at distance [dist] from the centre of
+// a shape edge [radius] away
+// -----------------------------------------------------------------------------
+double coverage(double dist, double radius)
+{
+	return std::clamp(radius + 0.5 - dist, 0., 1.);
+}
+
+// -----------------------------------------------------------------------------
+// Rasterizes [prim] (anti-aliased) into rows [row_start] to [row_end] of the
+// RGBA [pixels] of an image [width] pixels wide
+// -----------------------------------------------------------------------------
+void rasterize(const Primitive& prim, uint8_t* pixels, int width, int row_start, int row_end)
+{
+	auto margin = prim.radius + 1.;
+	auto dx     = prim.x2 - prim.x1;
+	auto dy     = prim.y2 - prim.y1;
+	auto len_sq = dx * dx + dy * dy;
+
+	for (int y = row_start; y < row_end; ++y)
+	{
+		auto py = y + 0.5;
+
+		// Get x range of pixels the shape could touch on this row
+		double x_min, x_max;
+		if (prim.disc || std::abs(dy) < 1e-9)
+		{
+			x_min = std::min(prim.x1, prim.x2);
+			x_max = std::max(prim.x1, prim.x2);
+		}
+		else
+		{
+			auto t1 = std::clamp((py - margin - prim.y1) / dy, 0., 1.);
+			auto t2 = std::clamp((py + margin - prim.y1) / dy, 0., 1.);
+			x_min   = prim.x1 + dx * std::min(t1, t2);
+			x_max   = prim.x1 + dx * std::max(t1, t2);
+		}
+		int x_start = std::max(0, static_cast<int>(std::floor(x_min - margin)));
+		int x_end   = std::min(width, static_cast<int>(std::ceil(x_max + margin)) + 1);
+
+		auto row = pixels + static_cast<size_t>(y) * width * 4;
+		for (int x = x_start; x < x_end; ++x)
+		{
+			auto px = x + 0.5;
+
+			// Get distance from pixel centre to the line segment (or point)
+			auto t   = len_sq > 0. ? std::clamp(((px - prim.x1) * dx + (py - prim.y1) * dy) / len_sq, 0., 1.) : 0.;
+			auto cx  = px - (prim.x1 + dx * t);
+			auto cy  = py - (prim.y1 + dy * t);
+			auto cov = coverage(std::sqrt(cx * cx + cy * cy), prim.radius);
+			if (cov > 0.)
+				blendPixel(row + x * 4, prim.colour, cov);
+		}
+	}
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapPreview Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the number of (attached) vertices in the map
+// -----------------------------------------------------------------------------
+unsigned MapPreview::nVertices() const
+{
+	vector<bool> v_used(verts_.size());
+	for (const auto& line : lines_)
+	{
+		if (line.v1 < v_used.size())
+			v_used[line.v1] = true;
+		if (line.v2 < v_used.size())
+			v_used[line.v2] = true;
+	}
+
+	return std::count(v_used.begin(), v_used.end(), true);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the width (in map units) of the map
+// -----------------------------------------------------------------------------
+unsigned MapPreview::width() const
+{
+	Vec2d min, max;
+	return bounds(min, max) ? static_cast<int>(max.x) - static_cast<int>(min.x) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the height (in map units) of the map
+// -----------------------------------------------------------------------------
+unsigned MapPreview::height() const
+{
+	Vec2d min, max;
+	return bounds(min, max) ? static_cast<int>(max.y) - static_cast<int>(min.y) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Sets [min] and [max] to the extents of the map's vertices.
+// Returns false if the map has no vertices
+// -----------------------------------------------------------------------------
+bool MapPreview::bounds(Vec2d& min, Vec2d& max) const
+{
+	if (verts_.empty())
+		return false;
+
+	min = { verts_[0].x, verts_[0].y };
+	max = min;
+	for (const auto& vert : verts_)
+	{
+		min.x = std::min(min.x, vert.x);
+		min.y = std::min(min.y, vert.y);
+		max.x = std::max(max.x, vert.x);
+		max.y = std::max(max.y, vert.y);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Clears map data
+// -----------------------------------------------------------------------------
+void MapPreview::clear()
+{
+	verts_.clear();
+	lines_.clear();
+	things_.clear();
+	n_sides_   = 0;
+	n_sectors_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Reads and loads the map data for [map]
+// -----------------------------------------------------------------------------
+bool MapPreview::open(const Archive::MapDesc& map)
+{
+	Source source;
+	if (!readSource(map, source))
+		return false;
+
+	if (!load(source))
+	{
+		log::error(global::error);
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Loads map data from [source], which can be done on any thread.
+// Returns false if the map data is invalid, with the reason in global::error
+// -----------------------------------------------------------------------------
+bool MapPreview::load(const Source& source)
+{
+	// Parse UDMF map
+	if (source.format == MapFormat::UDMF)
+		return loadUDMF(source.textmap, source.name);
+
+	// Read vertices (required)
+	if (!loadVertices(source.vertexes, source.format))
+		return false;
+
+	// Read linedefs (required)
+	if (!loadLines(source.linedefs, source.format))
+		return false;
+
+	// Read things
+	loadThings(source.things, source.format);
+
+	n_sides_   = source.n_sides;
+	n_sectors_ = source.n_sectors;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Renders the map to [image] (as RGBA) with [options].
+// The image is split into bands which are rasterized on multiple threads.
+// Returns false if there is nothing to render
+// -----------------------------------------------------------------------------
+bool MapPreview::render(SImage& image, const RenderOptions& options) const
+{
+	// Find extents of map
+	Vec2d m_min, m_max;
+	if (!bounds(m_min, m_max))
+		return false;
+	double mapwidth  = m_max.x - m_min.x;
+	double mapheight = m_max.y - m_min.y;
+	if (mapwidth <= 0. || mapheight <= 0.)
+		return false;
+
+	// Determine image size
+	int width  = options.width == 0 ? -5 : options.width;
+	int height = options.height == 0 ? -5 : options.height;
+	if (width < 0)
+		width = mapwidth / std::abs(width);
+	if (height < 0)
+		height = mapheight / std::abs(height);
+	if (width <= 0 || height <= 0)
+		return false;
+
+	// Zoom/offset to show the full map centered
+	Vec2d  offset = { m_min.x + (mapwidth * 0.5), m_min.y + (mapheight * 0.5) };
+	double zoom   = std::min<double>(width / mapwidth, height / mapheight) * 0.95;
+	auto   toImage = [&](double x, double y)
+	{ return Vec2d{ width * 0.5 + (x - offset.x) * zoom, height * 0.5 - (y - offset.y) * zoom }; };
+
+	// Build primitives to draw, 2-sided lines first so 1-sided lines are drawn
+	// over them
+	vector<Primitive> prims;
+	auto              line_radius = std::max(options.thickness, 0.1f) * 0.5;
+	for (auto twosided : { true, false })
+	{
+		for (const auto& line : lines_)
+		{
+			if (line.twosided != twosided || line.v1 >= verts_.size() || line.v2 >= verts_.size())
+				continue;
+
+			auto v1 = toImage(verts_[line.v1].x, verts_[line.v1].y);
+			auto v2 = toImage(verts_[line.v2].x, verts_[line.v2].y);
+
+			ColRGBA colour;
+			if (line.special)
+				colour = options.col_line_special;
+			else if (line.macro)
+				colour = options.col_line_macro;
+			else if (line.twosided)
+				colour = options.col_line_2s;
+			else
+				colour = options.col_line_1s;
+
+			prims.push_back({ v1.x, v1.y, v2.x, v2.y, line_radius, false, colour });
+		}
+	}
+	if (options.draw_things)
+	{
+		auto radius = std::max(20. * zoom, 1.5);
+		for (const auto& thing : things_)
+		{
+			auto pos = toImage(thing.x, thing.y);
+			prims.push_back({ pos.x, pos.y, pos.x, pos.y, radius, true, options.col_thing });
+		}
+	}
+
+	// Sort primitives into the image bands they touch (keeping draw order)
+	int                      n_bands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	vector<vector<unsigned>> bands(n_bands);
+	for (unsigned a = 0; a < prims.size(); ++a)
+	{
+		const auto& prim   = prims[a];
+		auto        margin = prim.radius + 1.;
+		int         first  = std::floor((std::min(prim.y1, prim.y2) - margin) / BAND_HEIGHT);
+		int         last   = std::floor((std::max(prim.y1, prim.y2) + margin) / BAND_HEIGHT);
+		for (int band = std::max(first, 0); band <= std::min(last, n_bands - 1); ++band)
+			bands[band].push_back(a);
+	}
+
+	// Fill background
+	vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	for (size_t a = 0; a < pixels.size(); a += 4)
+		options.col_background.write(pixels.data() + a);
+
+	// Rasterize bands on worker threads
+	jobs::parallelFor(
+		n_bands,
+		[&](unsigned band)
+		{
+			int row_start = static_cast<int>(band) * BAND_HEIGHT;
+			int row_end   = std::min(row_start + BAND_HEIGHT, height);
+			for (auto index : bands[band])
+				rasterize(prims[index], pixels.data(), width, row_start, row_end);
+		},
+		{},
+		std::max(options.threads, 0));
+
+	return image.setImageData(pixels, width, height, SImage::Type::RGBA);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the map data entries for [map] into [source]. If the map is in an
+// archive (eg. a wad in a zip), the first map in it is read.
+// Must be called from the main thread
+// -----------------------------------------------------------------------------
+bool MapPreview::readSource(Archive::MapDesc map, Source& source)
+{
+	auto m_head = map.head.lock();
+	if (!m_head)
+		return false;
+
+	// All errors = invalid map
+	global::error = "Invalid map";
+
+	// Check if this map is a pk3 map
+	unique_ptr<Archive> temp_archive;
+	if (map.archive)
+	{
+		// Attempt to open entry as wad archive
+		temp_archive = std::make_unique<WadArchive>();
+		if (!temp_archive->open(m_head->data()))
+			return false;
+
+		// Detect maps
+		auto maps = temp_archive->detectMaps();
+
+		// Set map if there are any in the archive
+		if (maps.empty())
+			return false;
+
+		map    = maps[0];
+		m_head = maps[0].head.lock();
+	}
+
+	source.name   = m_head->name();
+	source.format = map.format;
+
+	// Copy needed map data entries
+	auto entry = m_head.get();
+	auto m_end = map.end.lock().get();
+	while (entry)
+	{
+		const auto& type = entry->type()->id();
+		if (type == "udmf_textmap")
+			source.textmap.importMem(entry->rawData(), entry->size());
+		else if (type == "map_vertexes" && !source.vertexes.hasData())
+			source.vertexes.importMem(entry->rawData(), entry->size());
+		else if (type == "map_linedefs" && !source.linedefs.hasData())
+			source.linedefs.importMem(entry->rawData(), entry->size());
+		else if (type == "map_things" && !source.things.hasData())
+			source.things.importMem(entry->rawData(), entry->size());
+
+		// Sides & sectors (count only)
+		else if (type == "map_sidedefs")
+			source.n_sides = entry->size() / (map.format == MapFormat::Doom64 ? 12 : 30);
+		else if (type == "map_sectors")
+			source.n_sectors = entry->size() / (map.format == MapFormat::Doom64 ? 16 : 26);
+
+		// Exit loop if we've reached the end of the map entries
+		if (entry == m_end)
+			break;
+		entry = entry->nextEntry();
+	}
+
+	if (temp_archive)
+		temp_archive->close();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns render options for saving map images [width]x[height] in size, using
+// the current map image colour configuration
+// -----------------------------------------------------------------------------
+MapPreview::RenderOptions MapPreview::imageOptions(int width, int height)
+{
+	RenderOptions opt;
+	opt.width            = width;
+	opt.height           = height;
+	opt.thickness        = map_image_thickness;
+	opt.col_background   = colourconfig::colour("map_image_background");
+	opt.col_line_1s      = colourconfig::colour("map_image_line_1s");
+	opt.col_line_2s      = colourconfig::colour("map_image_line_2s");
+	opt.col_line_special = colourconfig::colour("map_image_line_special");
+	opt.col_line_macro   = colourconfig::colour("map_image_line_macro");
+	opt.col_thing        = colourconfig::colour("map_view_thing");
+
+	return opt;
+}
+
+// -----------------------------------------------------------------------------
+// Parses the UDMF [textmap] data
+// -----------------------------------------------------------------------------
+bool MapPreview::loadUDMF(const MemChunk& textmap, string_view name)
+{
+	if (!textmap.hasData())
+		return false;
+
+	// Start parsing
+	Tokenizer tz;
+	tz.openMem(textmap, name);
+	size_t vertcounter = 0, linecounter = 0, thingcounter = 0;
+	while (!tz.atEnd())
+	{
+		// Namespace
+		if (tz.checkNC("namespace"))
+			tz.advUntil(";");
+
+		// Sidedef
+		else if (tz.checkNC("sidedef"))
+		{
+			// Just increase count
+			n_sides_++;
+			tz.advUntil("}");
+		}
+
+		// Sector
+		else if (tz.checkNC("sector"))
+		{
+			// Just increase count
+			n_sectors_++;
+			tz.advUntil("}");
+		}
+
+		// Vertex or Thing
+		else if (tz.checkNC("vertex") || tz.checkNC("thing"))
+		{
+			bool   vertex  = tz.checkNC("vertex");
+			auto   counter = vertex ? vertcounter++ : thingcounter++;
+			bool   gotx    = false;
+			bool   goty    = false;
+			double x       = 0.;
+			double y       = 0.;
+
+			tz.adv(2); // skip {
+
+			while (!tz.check("}"))
+			{
+				if (tz.checkNC("x") || tz.checkNC("y"))
+				{
+					if (!tz.checkNext("="))
+					{
+						global::error = fmt::format(
+							"Bad syntax for {} {} in UDMF map data", vertex ? "vertex" : "thing", counter);
+						return false;
+					}
+
+					if (tz.checkNC("x"))
+					{
+						tz.adv(2);
+						x    = tz.current().asFloat();
+						gotx = true;
+					}
+					else
+					{
+						tz.adv(2);
+						y    = tz.current().asFloat();
+						goty = true;
+					}
+				}
+
+				tz.advUntil(";");
+				tz.adv();
+			}
+
+			if (!gotx || !goty)
+			{
+				global::error = fmt::format("Wrong {} {} in UDMF map data", vertex ? "vertex" : "thing", counter);
+				return false;
+			}
+
+			if (vertex)
+				addVertex(x, y);
+			else
+				addThing(x, y);
+		}
+
+		// Linedef
+		else if (tz.checkNC("linedef"))
+		{
+			bool     special  = false;
+			bool     twosided = false;
+			bool     gotv1 = false, gotv2 = false;
+			unsigned v1 = 0, v2 = 0;
+
+			tz.adv(2); // skip {
+
+			while (!tz.check("}"))
+			{
+				if (tz.checkNC("v1") || tz.checkNC("v2"))
+				{
+					if (!tz.checkNext("="))
+					{
+						global::error = fmt::format("Bad syntax for linedef {} in UDMF map data", linecounter);
+						return false;
+					}
+
+					if (tz.checkNC("v1"))
+					{
+						tz.adv(2);
+						v1    = tz.current().asInt();
+						gotv1 = true;
+					}
+					else
+					{
+						tz.adv(2);
+						v2    = tz.current().asInt();
+						gotv2 = true;
+					}
+				}
+				else if (tz.checkNC("special"))
+					special = true;
+				else if (tz.checkNC("sideback"))
+					twosided = true;
+
+				tz.advUntil(";");
+				tz.adv();
+			}
+
+			if (gotv1 && gotv2)
+				addLine(v1, v2, twosided, special);
+			else
+			{
+				global::error = fmt::format("Wrong line {} in UDMF map data", linecounter);
+				return false;
+			}
+
+			linecounter++;
+		}
+
+		tz.adv();
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads non-UDMF vertex [data]
+// -----------------------------------------------------------------------------
+bool MapPreview::loadVertices(const MemChunk& data, MapFormat map_format)
+{
+	// Can't open a map without vertices
+	if (!data.hasData())
+		return false;
+
+	if (map_format == MapFormat::Doom64)
+	{
+		Doom64MapFormat::Vertex v;
+		for (unsigned offset = 0; data.read(offset, &v, 8); offset += 8)
+			addVertex((double)v.x / 65536, (double)v.y / 65536);
+	}
+	else if (map_format == MapFormat::Doom32X)
+	{
+		Doom32XMapFormat::Vertex32BE v;
+		for (unsigned offset = 0; data.read(offset, &v, 8); offset += 8)
+			addVertex((double)wxINT32_SWAP_ON_LE(v.x) / 65536, (double)wxINT32_SWAP_ON_LE(v.y) / 65536);
+	}
+	else
+	{
+		DoomMapFormat::Vertex v;
+		for (unsigned offset = 0; data.read(offset, &v, 4); offset += 4)
+			addVertex((double)v.x, (double)v.y);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads non-UDMF line [data]
+// -----------------------------------------------------------------------------
+bool MapPreview::loadLines(const MemChunk& data, MapFormat map_format)
+{
+	// Can't open a map without linedefs
+	if (!data.hasData())
+		return false;
+
+	if (map_format == MapFormat::Doom || map_format == MapFormat::Doom32X)
+	{
+		DoomMapFormat::LineDef l;
+		for (unsigned offset = 0; data.read(offset, &l, sizeof(l)); offset += sizeof(l))
+			addLine(l.vertex1, l.vertex2, l.side2 != 0xFFFF, l.type > 0);
+	}
+	else if (map_format == MapFormat::Doom64)
+	{
+		Doom64MapFormat::LineDef l;
+		for (unsigned offset = 0; data.read(offset, &l, sizeof(l)); offset += sizeof(l))
+		{
+			// Check properties
+			bool macro   = false;
+			bool special = false;
+			if (l.type > 0)
+			{
+				if (l.type & 0x100)
+					macro = true;
+				else
+					special = true;
+			}
+
+			addLine(l.vertex1, l.vertex2, l.side2 != 0xFFFF, special, macro);
+		}
+	}
+	else if (map_format == MapFormat::Hexen)
+	{
+		HexenMapFormat::LineDef l;
+		for (unsigned offset = 0; data.read(offset, &l, sizeof(l)); offset += sizeof(l))
+			addLine(l.vertex1, l.vertex2, l.side2 != 0xFFFF, l.type > 0);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads non-UDMF thing [data]
+// -----------------------------------------------------------------------------
+void MapPreview::loadThings(const MemChunk& data, MapFormat map_format)
+{
+	if (map_format == MapFormat::Doom || map_format == MapFormat::Doom32X)
+	{
+		DoomMapFormat::Thing t;
+		for (unsigned offset = 0; data.read(offset, &t, sizeof(t)); offset += sizeof(t))
+			addThing(t.x, t.y);
+	}
+	else if (map_format == MapFormat::Doom64)
+	{
+		Doom64MapFormat::Thing t;
+		for (unsigned offset = 0; data.read(offset, &t, sizeof(t)); offset += sizeof(t))
+			addThing(t.x, t.y);
+	}
+	else if (map_format == MapFormat::Hexen)
+	{
+		HexenMapFormat::Thing t;
+		for (unsigned offset = 0; data.read(offset, &t, sizeof(t)); offset += sizeof(t))
+			addThing(t.x, t.y);
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Archive/Archive.h"
+
+namespace slade
+{
+class SImage;
+
+// Basic map geometry (vertices, lines and things) used to draw map preview
+// images, without needing a full SLADEMap or an OpenGL context.
+// Loading is split into gathering the map data from archive entries (which
+// must be done on the main thread) and parsing it, which can be done on any
+// thread along with rendering
+class MapPreview
+{
+public:
+	struct Vertex
+	{
+		double x;
+		double y;
+		Vertex(double x, double y) : x{ x }, y{ y } {}
+	};
+
+	struct Line
+	{
+		unsigned v1       = 0;
+		unsigned v2       = 0;
+		bool     twosided = false;
+		bool     special  = false;
+		bool     macro    = false;
+
+		Line(unsigned v1, unsigned v2, bool twosided = false, bool special = false, bool macro = false) :
+			v1{ v1 }, v2{ v2 }, twosided{ twosided }, special{ special }, macro{ macro }
+		{
+		}
+	};
+
+	struct Thing
+	{
+		double x;
+		double y;
+		Thing(double x, double y) : x{ x }, y{ y } {}
+	};
+
+	// Copy of the map data entries needed to build the preview
+	struct Source
+	{
+		string    name;
+		MapFormat format = MapFormat::Unknown;
+		MemChunk  vertexes;
+		MemChunk  linedefs;
+		MemChunk  things;
+		MemChunk  textmap;
+		unsigned  n_sides   = 0;
+		unsigned  n_sectors = 0;
+	};
+
+	struct RenderOptions
+	{
+		int     width       = 0; // If <= 0, 1 pixel per -width map units (0 = 5)
+		int     height      = 0; // If <= 0, 1 pixel per -height map units (0 = 5)
+		float   thickness   = 1.5f;
+		bool    draw_things = false;
+		int     threads     = 0; // Max threads to rasterize with (0 = all cores)
+		ColRGBA col_background;
+		ColRGBA col_line_1s;
+		ColRGBA col_line_2s;
+		ColRGBA col_line_special;
+		ColRGBA col_line_macro;
+		ColRGBA col_thing;
+	};
+
+	MapPreview()  = default;
+	~MapPreview() = default;
+
+	const vector<Vertex>& vertices() const { return verts_; }
+	const vector<Line>&   lines() const { return lines_; }
+	const vector<Thing>&  things() const { return things_; }
+	unsigned              nVertices() const;
+	unsigned              nSides() const { return n_sides_; }
+	unsigned              nSectors() const { return n_sectors_; }
+	unsigned              width() const;
+	unsigned              height() const;
+	bool                  bounds(Vec2d& min, Vec2d& max) const;
+
+	void addVertex(double x, double y) { verts_.emplace_back(x, y); }
+	void addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false)
+	{
+		lines_.emplace_back(v1, v2, twosided, special, macro);
+	}
+	void addThing(double x, double y) { things_.emplace_back(x, y); }
+	void clear();
+
+	bool open(const Archive::MapDesc& map);
+	bool load(const Source& source);
+	bool render(SImage& image, const RenderOptions& options) const;
+
+	static bool          readSource(Archive::MapDesc map, Source& source);
+	static RenderOptions imageOptions(int width, int height);
+
+private:
+	vector<Vertex> verts_;
+	vector<Line>   lines_;
+	vector<Thing>  things_;
+	unsigned       n_sides_   = 0;
+	unsigned       n_sectors_ = 0;
+
+	bool loadUDMF(const MemChunk& textmap, string_view name);
+	bool loadVertices(const MemChunk& data, MapFormat map_format);
+	bool loadLines(const MemChunk& data, MapFormat map_format);
+	void loadThings(const MemChunk& data, MapFormat map_format);
+};
+} // namespace slade
@@ -39,6 +39,7 @@
 #include "App.h"
 #include "Archive/Formats/WadArchive.h"
 #include "Game/Configuration.h"
+#include "General/Profiler.h"
 #include "MapEditor/SectorBuilder.h"
 #include "MapFormat/MapFormatHandler.h"
 #include "Utility/MathStuff.h"
@@ -115,6 +116,8 @@ void SLADEMap::setThingsUpdated()
 // -----------------------------------------------------------------------------
 bool SLADEMap::readMap(const Archive::MapDesc& map)
 {
+	PROFILE_SCOPE("SLADEMap::readMap");
+
 	auto omap = map;
 
 	// Check for map archive
@@ -508,6 +511,8 @@ void SLADEMap::recomputeSpecials()
 // -----------------------------------------------------------------------------
 bool SLADEMap::writeMap(vector<ArchiveEntry*>& map_entries) const
 {
+	PROFILE_SCOPE("SLADEMap::writeMap");
+
 	// Get format handler
 	auto handler = MapFormatHandler::get(current_format_);
 	handler->setUDMFNamespace(udmf_namespace_);
@@ -44,6 +44,7 @@
 #include "Graphics/Palette/Palette.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "MainEditor/GfxConverter.h"
 #include "Scripting/Lua.h"
 #include "thirdparty/sol/sol.hpp"
 
@@ -776,6 +777,28 @@ sol::table getImageInfo(MemChunk& data, int index)
 		info.has_palette);
 }
 
+// -----------------------------------------------------------------------------
+// Converts all image [entries] to [format] with [options] (on multiple
+// threads), saving with the options' target palette.
+// Returns the number of entries converted
+// -----------------------------------------------------------------------------
+unsigned convertEntries(const vector<ArchiveEntry*>& entries, SIFormat* format, const SIFormat::ConvertOptions& options)
+{
+	GfxConverter converter;
+	for (auto entry : entries)
+		converter.addEntry(entry, format, options, options.pal_target);
+
+	converter.run();
+	for (unsigned a = 0; a < converter.numItems(); ++a)
+	{
+		const auto& item = converter.item(a);
+		if (!item.error.empty())
+			log::warning("Unable to convert {}: {}", item.entry->name(), item.error);
+	}
+
+	return converter.applyToEntries();
+}
+
 // -----------------------------------------------------------------------------
 // Registers the Graphics function namespace with lua
 // -----------------------------------------------------------------------------
@@ -801,6 +824,7 @@ void registerGraphicsNamespace(sol::state& lua)
 	};
 	gfx["DetectImageFormat"] = [](MemChunk& mc) { return SIFormat::determineFormat(mc); };
 	gfx["GetImageInfo"]      = sol::overload(&getImageInfo, [](MemChunk& data) { return getImageInfo(data, 0); });
+	gfx["ConvertEntries"]    = &convertEntries;
 }
 
 } // namespace slade::lua
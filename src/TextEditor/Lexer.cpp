@@ -83,6 +83,9 @@ void Lexer::loadLanguage(TextLanguage* language)
 	language_ = language;
 	clearWords();
 	comment_blocks_.clear();
+	comment_gap_start_  = 0;
+	comment_gap_length_ = 0;
+	comment_shift_      = 0;
 
 	if (!language)
 		return;
@@ -130,10 +133,10 @@ void Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 	while (!done)
 	{
 		auto cb = isWithinComment(state.position);
-		if (cb >= 0)
+		if (cb)
 		{
-			editor->SetStyling(comment_blocks_[cb].end_pos - state.position, Style::Comment);
-			state.position = comment_blocks_[cb].end_pos;
+			editor->SetStyling(cb->end_pos - state.position, Style::Comment);
+			state.position = cb->end_pos;
 			state.line     = editor->LineFromPosition(state.position);
 			state.state    = State::Unknown;
 			continue;
@@ -151,8 +154,9 @@ void Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 	}
 
 	// Set current & next line's info
-	lines_[line].fold_increment = state.fold_increment;
-	lines_[line].has_word       = state.has_word;
+	auto& line_info          = lineInfo(line);
+	line_info.fold_increment = state.fold_increment;
+	line_info.has_word       = state.has_word;
 }
 
 // ----------------------------------------------------------------------------
@@ -170,26 +174,21 @@ void Lexer::updateComments(TextEditorCtrl* editor, int start, int end)
 	int   token_index;
 
 	// Extend start/end if either is within a comment
-	auto cb = isWithinComment(start);
-	if (cb >= 0)
-		start = comment_blocks_[cb].start_pos;
-	cb = isWithinComment(end);
-	if (cb >= 0)
-		end = comment_blocks_[cb].end_pos;
-
-	// Remove any existing comment blocks within start->end
-	for (int i = comment_blocks_.size() - 1; i >= 0; --i)
-	{
-		if (comment_blocks_[i].start_pos >= start && comment_blocks_[i].end_pos <= end)
-			comment_blocks_.erase(comment_blocks_.begin() + i);
-	}
-
-	// Do not look for comments if no language is loaded
-	if (!language_)
-		return;
+	if (auto cb = isWithinComment(start))
+		start = cb->start_pos;
+	if (auto cb = isWithinComment(end))
+		end = cb->end_pos;
+
+	// Find existing comment blocks within start->end
+	// (blocks are sorted and non-overlapping, so these are contiguous)
+	auto first = commentBlockAfter(start - 1);
+	auto last  = first;
+	while (last < numCommentBlocks() && commentBlock(last).end_pos <= end)
+		++last;
 
 	// Scan text
-	auto pos = start;
+	vector<CommentBlock> blocks;
+	auto                 pos = start;
 	while (pos < end)
 	{
 		// Skip quoted strings
@@ -207,7 +206,7 @@ void Lexer::updateComments(TextEditorCtrl* editor, int start, int end)
 		if (checkToken(editor, pos, language_->lineCommentL()))
 		{
 			const auto l_end = editor->GetLineEndPosition(editor->LineFromPosition(pos)) + 1;
-			comment_blocks_.push_back({ pos, l_end });
+			blocks.push_back({ pos, l_end });
 			pos = l_end;
 			continue;
 		}
@@ -228,12 +227,16 @@ void Lexer::updateComments(TextEditorCtrl* editor, int start, int end)
 				++pos;
 			}
 
-			comment_blocks_.push_back({ cb_start, pos });
+			blocks.push_back({ cb_start, pos });
 			continue;
 		}
 
 		++pos;
 	}
+
+	// Replace the existing blocks with the ones found
+	moveCommentGap(first);
+	replaceCommentBlocks(last - first, blocks);
 }
 
 // -----------------------------------------------------------------------------
@@ -673,49 +676,209 @@ bool Lexer::checkToken(TextEditorCtrl* editor, int pos, const vector<string>& to
 }
 
 // ----------------------------------------------------------------------------
-// Checks if [pos] is within a block comment, and returns the index for
-// comment_blocks_ if it is (-1 otherwise)
+// Checks if [pos] is within a block comment, and returns the comment block
+// containing it if it is (nullptr otherwise)
+// ----------------------------------------------------------------------------
+const Lexer::CommentBlock* Lexer::isWithinComment(int pos)
+{
+	// Find the last block starting at or before [pos]
+	auto index = commentBlockAfter(pos);
+	if (index == 0)
+		return nullptr;
+
+	// Move the gap after it, so any pending shift is applied
+	if (comment_gap_start_ < index)
+		moveCommentGap(index);
+
+	auto& block = comment_blocks_[index - 1];
+	return pos < block.end_pos ? &block : nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// Returns the comment block at [index], with any pending shift applied
+// ----------------------------------------------------------------------------
+Lexer::CommentBlock Lexer::commentBlock(size_t index) const
+{
+	if (index < comment_gap_start_)
+		return comment_blocks_[index];
+
+	auto block = comment_blocks_[index + comment_gap_length_];
+	block.start_pos += comment_shift_;
+	block.end_pos += comment_shift_;
+	return block;
+}
+
+// ----------------------------------------------------------------------------
+// Returns the index of the first comment block starting after [pos]
+// ----------------------------------------------------------------------------
+size_t Lexer::commentBlockAfter(int pos) const
+{
+	size_t lo = 0;
+	size_t hi = numCommentBlocks();
+	while (lo < hi)
+	{
+		auto mid = lo + (hi - lo) / 2;
+		if (commentBlock(mid).start_pos > pos)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+// ----------------------------------------------------------------------------
+// Moves the comment block gap to before the block at [index], applying the
+// pending shift to (or taking it back from) the blocks moved across it
+// ----------------------------------------------------------------------------
+void Lexer::moveCommentGap(size_t index)
+{
+	for (auto i = comment_gap_start_; i < index; ++i)
+	{
+		auto& block = comment_blocks_[i] = comment_blocks_[i + comment_gap_length_];
+		block.start_pos += comment_shift_;
+		block.end_pos += comment_shift_;
+	}
+	for (auto i = comment_gap_start_; i > index; --i)
+	{
+		auto& block = comment_blocks_[i - 1 + comment_gap_length_] = comment_blocks_[i - 1];
+		block.start_pos -= comment_shift_;
+		block.end_pos -= comment_shift_;
+	}
+
+	comment_gap_start_ = index;
+	if (comment_gap_start_ == numCommentBlocks())
+		comment_shift_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Removes [count] comment blocks after the gap, and adds [blocks] before it.
+// The gap is grown geometrically when needed, so the blocks after it only
+// have to be moved occasionally
 // ----------------------------------------------------------------------------
-int Lexer::isWithinComment(int pos)
+void Lexer::replaceCommentBlocks(size_t count, const vector<CommentBlock>& blocks)
 {
-	for (unsigned i = 0; i < comment_blocks_.size(); ++i)
-		if (pos >= comment_blocks_[i].start_pos && pos < comment_blocks_[i].end_pos)
-			return i;
+	comment_gap_length_ += count;
+	if (blocks.size() > comment_gap_length_)
+	{
+		auto grow = std::max(blocks.size() - comment_gap_length_, comment_blocks_.size() / 2 + 16);
+		comment_blocks_.insert(
+			comment_blocks_.begin() + comment_gap_start_ + comment_gap_length_, grow, CommentBlock{});
+		comment_gap_length_ += grow;
+	}
 
-	return -1;
+	std::copy(blocks.begin(), blocks.end(), comment_blocks_.begin() + comment_gap_start_);
+	comment_gap_start_ += blocks.size();
+	comment_gap_length_ -= blocks.size();
+	if (comment_gap_start_ == numCommentBlocks())
+		comment_shift_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Returns the cached lexer info for [line], adding it if needed
+// ----------------------------------------------------------------------------
+Lexer::LineInfo& Lexer::lineInfo(int line)
+{
+	if (line >= static_cast<int>(lines_.size()))
+		lines_.resize(line + 1);
+
+	return lines_[line];
+}
+
+// ----------------------------------------------------------------------------
+// Keeps cached comment block positions and line info in sync with the text
+// after [length] characters were inserted (or removed, if negative) at
+// [position] on [line], adding (or removing) [lines_added] lines
+// ----------------------------------------------------------------------------
+void Lexer::textModified(int position, int length, int line, int lines_added)
+{
+	// Shift line info
+	if (lines_added > 0 && line < static_cast<int>(lines_.size()))
+		lines_.insert(lines_.begin() + line + 1, lines_added, LineInfo{});
+	else if (lines_added < 0 && line + 1 < static_cast<int>(lines_.size()))
+	{
+		auto last = std::min<int>(line + 1 - lines_added, lines_.size());
+		lines_.erase(lines_.begin() + line + 1, lines_.begin() + last);
+	}
+
+	if (length == 0)
+		return;
+
+	// Blocks after the inserted (or removed) text are only moved, which is
+	// deferred by adding [length] to the pending shift. Only the block
+	// containing [position] and any starting within removed text are updated
+	// here
+	auto first = commentBlockAfter(length > 0 ? position - 1 : position);
+	auto last  = length > 0 ? first : commentBlockAfter(position - length - 1);
+	if (first > 0 && commentBlock(first - 1).end_pos > position)
+		--first;
+	moveCommentGap(last);
+
+	auto kept = first;
+	for (auto i = first; i < last; ++i)
+	{
+		auto block = comment_blocks_[i];
+		if (block.start_pos > position)
+			block.start_pos = std::max(position, block.start_pos + length);
+		block.end_pos = std::max(position, block.end_pos + length);
+
+		if (block.end_pos > block.start_pos)
+			comment_blocks_[kept++] = block;
+	}
+
+	// Blocks removed entirely become part of the gap
+	comment_gap_length_ += last - kept;
+	comment_gap_start_ = kept;
+	if (comment_gap_start_ < numCommentBlocks())
+		comment_shift_ += length;
+	else
+		comment_shift_ = 0;
 }
 
 // ---------------------------------------------------------------------------
-// Updates code folding levels in [editor], starting from line [line_start]
+// Updates code folding levels in [editor], starting from line [line_start].
+// Past [line_end] (the last restyled line), stops at the first line whose
+// starting fold level matches the one cached from the previous update, since
+// nothing after it can have changed
 // -----------------------------------------------------------------------------
-void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
+void Lexer::updateFolding(TextEditorCtrl* editor, int line_start, int line_end)
 {
 	int fold_level = editor->GetFoldLevel(line_start) & wxSTC_FOLDLEVELNUMBERMASK;
+	int line_count = editor->GetLineCount();
 
-	for (int l = line_start; l < editor->GetLineCount(); l++)
+	for (int l = line_start; l < line_count; l++)
 	{
+		auto& line_info = lineInfo(l);
+		bool  unchanged = line_end >= 0 && l > line_end && line_info.fold_level == fold_level;
+
 		// Determine next line's fold level
-		int next_level = fold_level + lines_[l].fold_increment;
+		int next_level = fold_level + line_info.fold_increment;
 		if (next_level < wxSTC_FOLDLEVELBASE)
 			next_level = wxSTC_FOLDLEVELBASE;
 
 		// Check if we are going up a fold level
 		if (next_level > fold_level)
 		{
-			if (!lines_[l].has_word)
+			if (!line_info.has_word)
 			{
 				// Line doesn't have any words (eg. only has an opening brace),
 				// move the fold header up a line
 				editor->SetFoldLevel(l - 1, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
-				editor->SetFoldLevel(l, next_level);
+				if (!unchanged)
+					editor->SetFoldLevel(l, next_level);
 			}
-			else
+			else if (!unchanged)
 				editor->SetFoldLevel(l, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
 		}
-		else
+		else if (!unchanged)
 			editor->SetFoldLevel(l, fold_level);
 
-		fold_level = next_level;
+		// The previous line has been finalised, the rest is as it was
+		if (unchanged)
+			break;
+
+		line_info.fold_level = fold_level;
+		fold_level           = next_level;
 	}
 }
 
@@ -38,11 +38,12 @@ public:
 	virtual void addWord(string_view word, int style);
 	virtual void clearWords() { word_list_.clear(); }
 	virtual void resetLineInfo() { lines_.clear(); }
+	void         textModified(int position, int length, int line, int lines_added);
 
 	void setWordChars(string_view chars);
 	void setOperatorChars(string_view chars);
 
-	void updateFolding(TextEditorCtrl* editor, int line_start);
+	void updateFolding(TextEditorCtrl* editor, int line_start, int line_end = -1);
 	void foldComments(bool fold) { fold_comments_ = fold; }
 	void foldPreprocessor(bool fold) { fold_preprocessor_ = fold; }
 
@@ -83,16 +84,25 @@ protected:
 	{
 		int  fold_increment;
 		bool has_word;
-		LineInfo() : fold_increment{ 0 }, has_word{ false } {}
+		int  fold_level; // Fold level at the start of the line when last folded
+		LineInfo() : fold_increment{ 0 }, has_word{ false }, fold_level{ -1 } {}
 	};
-	std::map<int, LineInfo> lines_;
+	vector<LineInfo> lines_;
 
+	// Comment blocks are non-overlapping and sorted by start position, kept in
+	// a gap buffer with the gap where the text was last edited, so blocks can
+	// be removed and added there without moving the rest. Blocks after the gap
+	// are yet to be moved by comment_shift_ characters, so an edit only has to
+	// add to the shift rather than move every block after it
 	struct CommentBlock
 	{
 		int start_pos = -1;
 		int end_pos   = -1;
 	};
 	vector<CommentBlock> comment_blocks_;
+	size_t               comment_gap_start_  = 0;
+	size_t               comment_gap_length_ = 0;
+	int                  comment_shift_      = 0;
 
 	struct LexerState
 	{
@@ -115,7 +125,13 @@ protected:
 	virtual void styleWord(LexerState& state, string_view word);
 	bool         checkToken(TextEditorCtrl* editor, int pos, string_view token) const;
 	bool checkToken(TextEditorCtrl* editor, int pos, const vector<string>& tokens, int* found_idx = nullptr) const;
-	int  isWithinComment(int pos);
+	const CommentBlock* isWithinComment(int pos);
+	size_t              numCommentBlocks() const { return comment_blocks_.size() - comment_gap_length_; }
+	CommentBlock        commentBlock(size_t index) const;
+	size_t              commentBlockAfter(int pos) const;
+	void                moveCommentGap(size_t index);
+	void                replaceCommentBlocks(size_t count, const vector<CommentBlock>& blocks);
+	LineInfo&           lineInfo(int line);
 };
 
 class ZScriptLexer : public Lexer
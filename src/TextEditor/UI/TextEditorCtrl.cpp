@@ -81,7 +81,6 @@ CVAR(Bool, txed_tab_spaces, false, CVar::Flag::Save)
 CVAR(Int, txed_show_whitespace, 0, CVar::Flag::Save)
 CVAR(Bool, txed_calltips_argset_kb, true, CVar::Flag::Save)
 
-wxDEFINE_EVENT(wxEVT_COMMAND_JTCALCULATOR_COMPLETED, wxThreadEvent);
 wxDEFINE_EVENT(wxEVT_TEXT_CHANGED, wxCommandEvent);
 
 
@@ -93,9 +92,10 @@ wxDEFINE_EVENT(wxEVT_TEXT_CHANGED, wxCommandEvent);
 
 
 // -----------------------------------------------------------------------------
-// JumpToCalculator thread entry function
+// Finds all jump points in the text, returning them as a comma-separated list
+// of line,name pairs. Can be run on any thread
 // -----------------------------------------------------------------------------
-wxThread::ExitCode JumpToCalculator::Entry()
+wxString JumpToCalculator::run() const
 {
 	wxString jump_points;
 
@@ -153,12 +153,7 @@ wxThread::ExitCode JumpToCalculator::Entry()
 	if (!jump_points.empty())
 		jump_points.RemoveLast(1);
 
-	// Send event
-	auto event = new wxThreadEvent(wxEVT_COMMAND_JTCALCULATOR_COMPLETED);
-	event->SetString(jump_points);
-	wxQueueEvent(handler_, event);
-
-	return nullptr;
+	return jump_points;
 }
 
 
@@ -226,8 +221,8 @@ TextEditorCtrl::TextEditorCtrl(wxWindow* parent, int id) :
 	Bind(wxEVT_KILL_FOCUS, &TextEditorCtrl::onFocusLoss, this);
 	Bind(wxEVT_ACTIVATE, &TextEditorCtrl::onActivate, this);
 	Bind(wxEVT_STC_MARGINCLICK, &TextEditorCtrl::onMarginClick, this);
-	Bind(wxEVT_COMMAND_JTCALCULATOR_COMPLETED, &TextEditorCtrl::onJumpToCalculateComplete, this);
 	Bind(wxEVT_STC_CHANGE, &TextEditorCtrl::onModified, this);
+	Bind(wxEVT_STC_MODIFIED, &TextEditorCtrl::onTextModified, this);
 	Bind(wxEVT_TIMER, &TextEditorCtrl::onUpdateTimer, this);
 	Bind(wxEVT_STC_STYLENEEDED, &TextEditorCtrl::onStyleNeeded, this);
 }
@@ -238,6 +233,7 @@ TextEditorCtrl::TextEditorCtrl(wxWindow* parent, int id) :
 TextEditorCtrl::~TextEditorCtrl()
 {
 	StyleSet::removeEditor(this);
+	jump_to_token_.cancel();
 }
 
 // -----------------------------------------------------------------------------
@@ -1021,17 +1017,24 @@ void TextEditorCtrl::updateJumpToList()
 	if (!choice_jump_to_)
 		return;
 
-	if (!language_ || jump_to_calculator_ || GetText().length() == 0)
+	// Cancel any calculation still in progress, its text is out of date
+	jump_to_token_.cancel();
+	jump_to_token_ = {};
+
+	if (!language_ || GetText().length() == 0)
 	{
 		choice_jump_to_->Clear();
 		return;
 	}
 
-	// Begin jump to calculation thread
+	// Begin jump to calculation job
 	choice_jump_to_->Enable(false);
-	jump_to_calculator_ = new JumpToCalculator(
-		this, wxutil::strToView(GetText()), language_->jumpBlocks(), language_->jumpBlocksIgnored());
-	jump_to_calculator_->Run();
+	auto calculator = std::make_shared<JumpToCalculator>(
+		wxutil::strToView(GetText()), language_->jumpBlocks(), language_->jumpBlocksIgnored());
+	jobs::run(
+		[calculator] { return calculator->run(); },
+		[this](const wxString& jump_points) { onJumpToCalculateComplete(jump_points); },
+		jump_to_token_);
 }
 
 // -----------------------------------------------------------------------------
@@ -1742,20 +1745,17 @@ void TextEditorCtrl::onMarginClick(wxStyledTextEvent& e)
 }
 
 // -----------------------------------------------------------------------------
-// Called when the 'Jump To' calculation thread completes
+// Called when the 'Jump To' calculation job completes
 // -----------------------------------------------------------------------------
-void TextEditorCtrl::onJumpToCalculateComplete(wxThreadEvent& e)
+void TextEditorCtrl::onJumpToCalculateComplete(const wxString& jump_points)
 {
 	if (!choice_jump_to_)
-	{
-		jump_to_calculator_ = nullptr;
 		return;
-	}
 
 	choice_jump_to_->Clear();
 	jump_to_lines_.clear();
 
-	auto split = wxSplit(e.GetString(), ',');
+	auto split = wxSplit(jump_points, ',');
 
 	wxArrayString items;
 	for (unsigned a = 0; a < split.size(); a += 2)
@@ -1774,8 +1774,6 @@ void TextEditorCtrl::onJumpToCalculateComplete(wxThreadEvent& e)
 
 	choice_jump_to_->Append(items);
 	choice_jump_to_->Enable(true);
-
-	jump_to_calculator_ = nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -1813,6 +1811,21 @@ void TextEditorCtrl::onModified(wxStyledTextEvent& e)
 	e.Skip();
 }
 
+// -----------------------------------------------------------------------------
+// Called when text is inserted or deleted in the text editor, keeps the lexer's
+// cached comment and line info in sync with the modified text
+// -----------------------------------------------------------------------------
+void TextEditorCtrl::onTextModified(wxStyledTextEvent& e)
+{
+	auto type = e.GetModificationType();
+	if (type & wxSTC_MOD_INSERTTEXT)
+		lexer_->textModified(e.GetPosition(), e.GetLength(), LineFromPosition(e.GetPosition()), e.GetLinesAdded());
+	else if (type & wxSTC_MOD_DELETETEXT)
+		lexer_->textModified(e.GetPosition(), -e.GetLength(), LineFromPosition(e.GetPosition()), e.GetLinesAdded());
+
+	e.Skip();
+}
+
 // -----------------------------------------------------------------------------
 // Called when the update timer finishes
 // -----------------------------------------------------------------------------
@@ -1865,7 +1878,7 @@ void TextEditorCtrl::onStyleNeeded(wxStyledTextEvent& e)
 	if (txed_fold_enable)
 	{
 		auto modified = last_modified_;
-		lexer_->updateFolding(this, line_start);
+		lexer_->updateFolding(this, line_start, line_end);
 		last_modified_ = modified;
 	}
 }
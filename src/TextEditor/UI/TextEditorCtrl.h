@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Archive/ArchiveEntry.h"
+#include "General/Jobs.h"
 #include "TextEditor/Lexer.h"
 #include "TextEditor/TextLanguage.h"
 #include "TextEditor/TextStyle.h"
@@ -11,7 +12,6 @@ class wxCheckBox;
 class wxTextCtrl;
 class wxChoice;
 
-wxDECLARE_EVENT(wxEVT_COMMAND_JTCALCULATOR_COMPLETED, wxThreadEvent);
 wxDECLARE_EVENT(wxEVT_TEXT_CHANGED, wxCommandEvent);
 
 namespace slade
@@ -19,22 +19,20 @@ namespace slade
 class FindReplacePanel;
 class SCallTip;
 
-class JumpToCalculator : public wxThread
+class JumpToCalculator
 {
 public:
-	JumpToCalculator(wxEvtHandler* handler, string_view text, vector<string> block_names, vector<string> ignore) :
-		handler_(handler),
+	JumpToCalculator(string_view text, vector<string> block_names, vector<string> ignore) :
 		text_(text),
 		block_names_(std::move(block_names)),
 		ignore_(std::move(ignore))
 	{
 	}
-	virtual ~JumpToCalculator() = default;
+	~JumpToCalculator() = default;
 
-	ExitCode Entry() override;
+	wxString run() const;
 
 private:
-	wxEvtHandler*  handler_;
 	string         text_;
 	vector<string> block_names_;
 	vector<string> ignore_;
@@ -98,8 +96,8 @@ private:
 	FindReplacePanel* panel_fr_           = nullptr;
 	SCallTip*         call_tip_           = nullptr;
 	wxChoice*         choice_jump_to_     = nullptr;
-	JumpToCalculator* jump_to_calculator_ = nullptr;
 	unique_ptr<Lexer> lexer_;
+	jobs::Token       jump_to_token_;
 	wxString          prev_word_match_;
 	wxString          autocomp_list_;
 	vector<int>       jump_to_lines_;
@@ -139,9 +137,10 @@ private:
 	void onFocusLoss(wxFocusEvent& e);
 	void onActivate(wxActivateEvent& e);
 	void onMarginClick(wxStyledTextEvent& e);
-	void onJumpToCalculateComplete(wxThreadEvent& e);
+	void onJumpToCalculateComplete(const wxString& jump_points);
 	void onJumpToChoiceSelected(wxCommandEvent& e);
 	void onModified(wxStyledTextEvent& e);
+	void onTextModified(wxStyledTextEvent& e);
 	void onUpdateTimer(wxTimerEvent& e);
 	void onStyleNeeded(wxStyledTextEvent& e);
 };
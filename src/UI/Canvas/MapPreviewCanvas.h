@@ -1,7 +1,8 @@
 #pragma once
 
-#include "Archive/Archive.h"
 #include "OGLCanvas.h"
+#include "General/Jobs.h"
+#include "SLADEMap/MapPreview.h"
 
 namespace slade
 {
@@ -11,83 +12,40 @@ class MapPreviewCanvas : public OGLCanvas
 {
 public:
 	MapPreviewCanvas(wxWindow* parent) : OGLCanvas(parent, -1) {}
-	~MapPreviewCanvas() = default;
+	~MapPreviewCanvas() { load_token_.cancel(); }
 
-	void addVertex(double x, double y);
-	void addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false);
-	void addThing(double x, double y);
-	bool openMap(Archive::MapDesc map);
-	bool readVertices(ArchiveEntry* map_head, ArchiveEntry* map_end, MapFormat map_format);
-	bool readLines(ArchiveEntry* map_head, ArchiveEntry* map_end, MapFormat map_format);
-	bool readThings(ArchiveEntry* map_head, ArchiveEntry* map_end, MapFormat map_format);
-	void clearMap();
-	void showMap();
-	void draw() override;
-	void createImage(ArchiveEntry& ae, int width, int height);
-
-	unsigned nVertices();
-	unsigned nSides() const { return n_sides_; }
-	unsigned nLines() const { return lines_.size(); }
-	unsigned nSectors() const { return n_sectors_; }
-	unsigned nThings() const { return things_.size(); }
-	unsigned width();
-	unsigned height();
+	const MapPreview& mapPreview() const { return map_; }
 
-private:
-	// Structs for basic map features
-	struct Vertex
+	void addVertex(double x, double y) { map_.addVertex(x, y); }
+	void addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false)
 	{
-		double x;
-		double y;
-		Vertex(double x, double y)
-		{
-			this->x = x;
-			this->y = y;
-		}
-	};
-
-	struct Line
+		map_.addLine(v1, v2, twosided, special, macro);
+	}
+	void addThing(double x, double y) { map_.addThing(x, y); }
+	bool openMap(const Archive::MapDesc& map, const std::function<void(bool)>& on_loaded = {});
+	void clearMap()
 	{
-		unsigned v1       = 0;
-		unsigned v2       = 0;
-		bool     twosided = false;
-		bool     special  = false;
-		bool     macro    = false;
-		bool     segment  = false;
+		load_token_.cancel();
+		map_.clear();
+	}
+	void showMap();
+	void draw() override;
+	bool createImage(ArchiveEntry& ae, int width, int height) const;
 
-		Line(
-			unsigned v1,
-			unsigned v2,
-			bool     twosided = false,
-			bool     special  = false,
-			bool     macro    = false,
-			bool     segment  = false) :
-			v1{ v1 },
-			v2{ v2 },
-			twosided{ twosided },
-			special{ special },
-			macro{ macro },
-			segment{ segment }
-		{
-		}
-	};
+	unsigned nVertices() const { return map_.nVertices(); }
+	unsigned nSides() const { return map_.nSides(); }
+	unsigned nLines() const { return map_.lines().size(); }
+	unsigned nSectors() const { return map_.nSectors(); }
+	unsigned nThings() const { return map_.things().size(); }
+	unsigned width() const { return map_.width(); }
+	unsigned height() const { return map_.height(); }
 
-	struct Thing
-	{
-		double x;
-		double y;
-		Thing(double x, double y) : x{ x }, y{ y } {}
-	};
-
-	vector<Vertex>      verts_;
-	vector<Line>        lines_;
-	vector<Thing>       things_;
-	unsigned            n_sides_   = 0;
-	unsigned            n_sectors_ = 0;
-	double              zoom_      = 1.;
-	Vec2d               offset_;
-	unique_ptr<Archive> temp_archive_;
-	unsigned            tex_thing_;
-	bool                tex_loaded_ = false;
+private:
+	MapPreview  map_;
+	double      zoom_ = 1.;
+	Vec2d       offset_;
+	unsigned    tex_thing_;
+	bool        tex_loaded_ = false;
+	jobs::Token load_token_; // Cancelled when a map still being loaded is no longer wanted
 };
 } // namespace slade
@@ -49,6 +49,7 @@
 #include "UI/Controls/PaletteChooser.h"
 #include "UI/Dialogs/Preferences/PreferencesDialog.h"
 #include "UI/WxUtils.h"
+#include <wx/progdlg.h>
 
 using namespace slade;
 
@@ -105,6 +106,10 @@ bool GfxConvDialog::nextItem()
 		return false;
 	}
 
+	// Skip if already converted (by 'Convert All')
+	if (items_[current_item_].modified)
+		return nextItem();
+
 	// Load image if needed
 	if (!items_[current_item_].image.isValid())
 	{
@@ -613,6 +618,11 @@ void GfxConvDialog::applyConversion()
 	item.modified   = true;
 	item.new_format = current_format_.format;
 	item.palette    = pal_chooser_target_->selectedPalette(item.entry);
+
+	// Add to converter to be encoded later
+	SIFormat::ConvertOptions opt;
+	convertOptions(opt);
+	converter_.addImage(item.image, item.entry, item.new_format, opt, item.palette, false);
 }
 
 
@@ -650,19 +660,90 @@ void GfxConvDialog::onBtnConvert(wxCommandEvent& e)
 // -----------------------------------------------------------------------------
 void GfxConvDialog::onBtnConvertAll(wxCommandEvent& e)
 {
-	// Show splash window
-	ui::showSplash("Converting Gfx...", true);
+	// The current and all remaining images are converted as one batch, which
+	// is discarded entirely if cancelled, so keep the current item's state
+	auto&  current       = items_[current_item_];
+	SImage prev_image    = current.image;
+	auto   prev_modified = current.modified;
+	auto   prev_format   = current.new_format;
+	auto   prev_palette  = current.palette;
+	auto   batch_start   = converter_.numItems();
+
+	// Convert the current image as shown
+	applyConversion();
+
+	// Add all remaining images to the converter with the current options
+	SIFormat::ConvertOptions opt;
+	convertOptions(opt);
+	vector<std::pair<size_t, unsigned>> batch; // Item index -> converter item index
+	for (size_t a = current_item_ + 1; a < items_.size(); a++)
+	{
+		auto& item      = items_[a];
+		opt.pal_current = pal_chooser_current_->selectedPalette(item.entry);
+		opt.pal_target  = pal_chooser_target_->selectedPalette(item.entry);
+
+		// Textures need to be built here, they aren't safe to load on another thread
+		if (!item.image.isValid() && item.texture)
+			item.texture->toImage(item.image, item.archive, item.palette, item.force_rgba);
+
+		batch.emplace_back(a, converter_.numItems());
+		if (item.image.isValid())
+			converter_.addImage(item.image, item.entry, current_format_.format, opt, opt.pal_target);
+		else if (item.entry)
+			converter_.addEntry(item.entry, current_format_.format, opt, opt.pal_target);
+		else
+			batch.pop_back();
+	}
 
 	// Convert all images
-	for (size_t a = current_item_; a < items_.size(); a++)
+	wxProgressDialog progress(
+		"Converting Gfx",
+		"Converting Gfx...",
+		100,
+		this,
+		wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME);
+	bool completed = converter_.run(
+		[&progress](unsigned done, unsigned total)
+		{
+			return progress.Update(done * 100 / total, wxString::Format("Converting Gfx... %u of %u", done, total));
+		});
+	progress.Hide();
+
+	// Cancelled, discard the batch and go back to the current image
+	if (!completed)
+	{
+		converter_.removeItems(batch_start);
+		current.image.copyImage(&prev_image);
+		current.modified   = prev_modified;
+		current.new_format = prev_format;
+		current.palette    = prev_palette;
+		return;
+	}
+
+	// Update items with the results. Stop at the first image that couldn't be
+	// written to the selected format so that a different format can be chosen
+	// for it (the rest will be skipped since they are already converted)
+	size_t stop_at = items_.size();
+	for (const auto& [index, conv_index] : batch)
 	{
-		applyConversion();
-		if (!nextItem())
-			break;
+		auto& item  = items_[index];
+		auto& citem = converter_.item(conv_index);
+		if (citem.converted)
+		{
+			item.image.copyImage(&citem.image);
+			item.modified   = true;
+			item.new_format = citem.format;
+			item.palette    = citem.palette;
+		}
+		else if (citem.image.isValid() && !item.image.isValid())
+			item.image.copyImage(&citem.image);
+
+		if (!citem.converted && citem.image.isValid() && stop_at == items_.size())
+			stop_at = index;
 	}
 
-	// Hide splash window
-	ui::hideSplash();
+	current_item_ = stop_at - 1;
+	nextItem();
 }
 
 // -----------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "MainEditor/GfxConverter.h"
 #include "UI/SDialog.h"
 
 /* Convert from anything to:
@@ -58,6 +59,10 @@ public:
 	SIFormat* itemFormat(int index) const;
 	Palette*  itemPalette(int index) const;
 
+	// Holds the converted image data for all converted items, use
+	// GfxConverter::applyToEntries to write it to the entries
+	GfxConverter& converter() { return converter_; }
+
 	void applyConversion();
 
 private:
@@ -95,6 +100,7 @@ private:
 	size_t             current_item_ = 0;
 	vector<ConvFormat> conv_formats_;
 	ConvFormat         current_format_;
+	GfxConverter       converter_;
 
 	wxStaticText*   label_current_format_     = nullptr;
 	GfxCanvas*      gfx_current_              = nullptr;
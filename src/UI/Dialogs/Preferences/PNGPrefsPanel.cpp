@@ -50,6 +50,7 @@ using namespace slade;
 EXTERN_CVAR(String, path_pngout)
 EXTERN_CVAR(String, path_pngcrush)
 EXTERN_CVAR(String, path_deflopt)
+EXTERN_CVAR(Bool, png_opt_reduce_palette)
 CVAR(String, dir_last_pngtool, "", CVar::Flag::Save)
 
 
@@ -71,7 +72,11 @@ PNGPrefsPanel::PNGPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 
 	wxutil::layoutVertically(
 		sizer,
-		vector<wxObject*>{ wxutil::createLabelVBox(
+		vector<wxObject*>{ cb_reduce_palette_ = new wxCheckBox(
+							   this,
+							   -1,
+							   "Reduce palettes when optimizing (removes unused colours, may change palette indices)"),
+						   wxutil::createLabelVBox(
 							   this,
 							   "Location of PNGout:",
 							   flp_pngout_ = new FileLocationPanel(
@@ -109,6 +114,7 @@ PNGPrefsPanel::PNGPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 // -----------------------------------------------------------------------------
 void PNGPrefsPanel::init()
 {
+	cb_reduce_palette_->SetValue(png_opt_reduce_palette);
 	flp_pngout_->setLocation(path_pngout);
 	flp_pngcrush_->setLocation(path_pngcrush);
 	flp_deflopt_->setLocation(path_deflopt);
@@ -122,4 +128,6 @@ void PNGPrefsPanel::applyPreferences()
 	path_pngout   = wxutil::strToView(flp_pngout_->location());
 	path_pngcrush = wxutil::strToView(flp_pngcrush_->location());
 	path_deflopt  = wxutil::strToView(flp_deflopt_->location());
+
+	png_opt_reduce_palette = cb_reduce_palette_->GetValue();
 }
@@ -15,9 +15,10 @@ public:
 	void init() override;
 	void applyPreferences() override;
 
-	wxString pageTitle() override { return "PNG Optimization Tools"; }
+	wxString pageTitle() override { return "PNG Optimization"; }
 
 private:
+	wxCheckBox*        cb_reduce_palette_ = nullptr;
 	FileLocationPanel* flp_pngout_   = nullptr;
 	FileLocationPanel* flp_pngcrush_ = nullptr;
 	FileLocationPanel* flp_deflopt_  = nullptr;
@@ -177,6 +177,9 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 	undo_manager_ = undo_manager;
 	view_type_    = archive->formatDesc().supports_dirs && !force_list ? ViewType::Tree : ViewType::List;
 
+	// Directory archives default to alphabetical order, everything else to index order
+	sort_default_name_ = archive->formatId() == "folder";
+
 	// Refresh (will load all items)
 	Cleared();
 
@@ -187,6 +190,8 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 	connections_ += archive->signals().entry_added.connect(
 		[this](Archive& archive, ArchiveEntry& entry)
 		{
+			updateFilterMatch(entry);
+
 			if (entryIsInList(entry))
 			{
 				if (view_type_ == ViewType::Tree)
@@ -200,16 +205,20 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 	connections_ += archive->signals().entry_removed.connect(
 		[this](Archive& archive, ArchiveDir& dir, ArchiveEntry& entry)
 		{
+			filter_matches_.erase(&entry);
+
 			if (view_type_ == ViewType::Tree)
 				ItemDeleted(createItemForDirectory(dir), wxDataViewItem(&entry));
 			else if (root_dir_.lock().get() == &dir)
 				ItemDeleted({}, wxDataViewItem(&entry));
 		});
 
-	// Entry modified
+	// Entry modified (or renamed)
 	connections_ += archive->signals().entry_state_changed.connect(
 		[this](Archive& archive, ArchiveEntry& entry)
 		{
+			updateFilterMatch(entry);
+
 			if (entryIsInList(entry))
 				ItemChanged(wxDataViewItem(&entry));
 		});
@@ -218,6 +227,8 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 	connections_ += archive->signals().dir_added.connect(
 		[this](Archive& archive, ArchiveDir& dir)
 		{
+			updateDirFilterMatches(dir, false);
+
 			if (dirIsInList(dir))
 			{
 				if (view_type_ == ViewType::Tree)
@@ -231,6 +242,8 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 	connections_ += archive->signals().dir_removed.connect(
 		[this](Archive& archive, ArchiveDir& parent, ArchiveDir& dir)
 		{
+			updateDirFilterMatches(dir, true);
+
 			if (view_type_ == ViewType::Tree)
 				ItemDeleted(createItemForDirectory(parent), wxDataViewItem(dir.dirEntry()));
 			else if (root_dir_.lock().get() == &parent)
@@ -273,14 +286,8 @@ void ArchiveViewModel::openArchive(shared_ptr<Archive> archive, UndoManager* und
 // -----------------------------------------------------------------------------
 void ArchiveViewModel::setFilter(string_view name, string_view category)
 {
-	// Check any change is required
-	if (name.empty() && filter_name_.empty() && filter_category_ == category)
-		return;
-
-	filter_category_ = category;
-
 	// Process filter string
-	filter_name_.clear();
+	vector<string> filter_name;
 	if (!name.empty())
 	{
 		auto filter_parts = strutil::splitV(name, ',');
@@ -292,10 +299,19 @@ void ArchiveViewModel::setFilter(string_view name, string_view category)
 
 			strutil::upperIP(filter_part);
 			filter_part += '*';
-			filter_name_.push_back(filter_part);
+			filter_name.push_back(filter_part);
 		}
 	}
 
+	// Check any change is required
+	if (filter_name == filter_name_ && filter_category_ == category)
+		return;
+
+	filter_category_ = category;
+	filter_name.swap(filter_name_);
+	if (filter_name_ != filter_name)
+		updateFilterMatches(filter_name);
+
 	// Fully refresh the list
 	Cleared();
 }
@@ -723,22 +739,16 @@ int ArchiveViewModel::Compare(
 		// Type column (order by type name -> name)
 		else if (column == 2)
 		{
-			cmpval = e1_type->name().compare(e2_type->name());
+			cmpval = e1_type == e2_type ? 0 : e1_type->name().compare(e2_type->name());
 			if (cmpval == 0)
 				cmpval = e1->upperName().compare(e2->upperName());
 		}
 
-		// Default
+		// Default (name or index order, depending on the archive format)
+		else if (sort_default_name_)
+			cmpval = e1->upperName().compare(e2->upperName());
 		else
-		{
-			// Directory archives default to alphabetical order
-			if (const auto archive = archive_.lock(); archive->formatId() == "folder")
-				cmpval = e1->upperName().compare(e2->upperName());
-
-			// Everything else defaults to index order
-			else
-				cmpval = e1->index() > e2->index() ? 1 : -1;
-		}
+			cmpval = e1->index() > e2->index() ? 1 : -1;
 
 		return ascending ? cmpval : -cmpval;
 	}
@@ -765,14 +775,13 @@ wxDataViewItem ArchiveViewModel::createItemForDirectory(const ArchiveDir& dir) c
 // -----------------------------------------------------------------------------
 bool ArchiveViewModel::matchesFilter(const ArchiveEntry& entry) const
 {
-	// Check for name match if needed
+	// Check for name match if needed (directories aren't in the match set)
 	if (!filter_name_.empty())
 	{
-		for (const auto& f : filter_name_)
-			if (strutil::matches(entry.upperName(), f))
-				return true;
+		if (entry.type() == EntryType::folderType())
+			return matchesFilterName(entry);
 
-		return false;
+		return filter_matches_.find(&entry) != filter_matches_.end();
 	}
 
 	// Check for category match if needed
@@ -783,6 +792,114 @@ bool ArchiveViewModel::matchesFilter(const ArchiveEntry& entry) const
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [entry]'s name matches any of the current name filters
+// -----------------------------------------------------------------------------
+bool ArchiveViewModel::matchesFilterName(const ArchiveEntry& entry) const
+{
+	for (const auto& f : filter_name_)
+		if (strutil::matches(entry.upperName(), f))
+			return true;
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the set of entries matching the current name filter, after it has
+// been changed from [prev_filter_name].
+// If each new filter starts with a previous filter (eg. another character was
+// typed), only the previous matches need to be checked. Otherwise the matches
+// are looked up in each directory's entry name index
+// -----------------------------------------------------------------------------
+void ArchiveViewModel::updateFilterMatches(const vector<string>& prev_filter_name)
+{
+	if (filter_name_.empty())
+	{
+		filter_matches_.clear();
+		return;
+	}
+
+	// Check if the new filter narrows the previous one. Previous filters always
+	// end with '*', so anything matching the new filter also matched them
+	auto narrows = !prev_filter_name.empty();
+	for (const auto& f : filter_name_)
+	{
+		auto prefix_of_f = [&f](const string& prev)
+		{ return strutil::startsWith(f, string_view{ prev }.substr(0, prev.size() - 1)); };
+		if (std::none_of(prev_filter_name.begin(), prev_filter_name.end(), prefix_of_f))
+		{
+			narrows = false;
+			break;
+		}
+	}
+
+	// Narrowed, remove previous matches that don't match the new filter
+	if (narrows)
+	{
+		for (auto i = filter_matches_.begin(); i != filter_matches_.end();)
+		{
+			if (matchesFilterName(**i))
+				++i;
+			else
+				i = filter_matches_.erase(i);
+		}
+		return;
+	}
+
+	// Otherwise find all matching entries in the archive
+	filter_matches_.clear();
+	auto archive = archive_.lock();
+	if (!archive)
+		return;
+	auto dirs = archive->rootDir()->allDirectories();
+	dirs.push_back(archive->rootDir());
+	vector<unsigned> indices;
+	for (const auto& dir : dirs)
+	{
+		indices.clear();
+		for (const auto& f : filter_name_)
+			dir->entryIndicesMatching(f, false, indices);
+		for (auto index : indices)
+			filter_matches_.insert(dir->entryAt(index));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Updates whether [entry] is in the set of entries matching the current name
+// filter (eg. after it was added or renamed)
+// -----------------------------------------------------------------------------
+void ArchiveViewModel::updateFilterMatch(const ArchiveEntry& entry)
+{
+	if (!filter_name_.empty() && matchesFilterName(entry))
+		filter_matches_.insert(&entry);
+	else
+		filter_matches_.erase(&entry);
+}
+
+// -----------------------------------------------------------------------------
+// Updates the set of entries matching the current name filter for all entries
+// in [dir] and its subdirectories, after it was added to or [removed] from the
+// archive
+// -----------------------------------------------------------------------------
+void ArchiveViewModel::updateDirFilterMatches(const ArchiveDir& dir, bool removed)
+{
+	if (filter_name_.empty())
+		return;
+
+	vector<const ArchiveDir*> dirs{ &dir };
+	for (const auto& subdir : dir.allDirectories())
+		dirs.push_back(subdir.get());
+
+	for (const auto* d : dirs)
+		for (const auto& entry : d->entries())
+		{
+			if (removed)
+				filter_matches_.erase(entry.get());
+			else
+				updateFilterMatch(*entry);
+		}
+}
+
 // -----------------------------------------------------------------------------
 // Populates [items] with all child entries/subrirs of [dir].
 // If [filtered] is true, only adds children matching the current filter
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "General/Sigslot.h"
+#include <unordered_set>
 #include <wx/dataview.h>
 
 namespace slade
@@ -56,16 +57,18 @@ namespace ui
 		wxDataViewItem createItemForDirectory(const ArchiveDir& dir) const;
 
 	private:
-		weak_ptr<Archive>    archive_;
-		weak_ptr<ArchiveDir> root_dir_;
-		ScopedConnectionList connections_;
-		vector<string>       filter_name_;
-		string               filter_category_;
-		UndoManager*         undo_manager_       = nullptr;
-		bool                 sort_enabled_       = true;
-		bool                 modified_indicator_ = true;
-		ViewType             view_type_          = ViewType::Tree;
-		ArchivePathPanel*    path_panel_         = nullptr;
+		weak_ptr<Archive>                       archive_;
+		weak_ptr<ArchiveDir>                    root_dir_;
+		ScopedConnectionList                    connections_;
+		vector<string>                          filter_name_;
+		string                                  filter_category_;
+		std::unordered_set<const ArchiveEntry*> filter_matches_; // Entries matching filter_name_
+		UndoManager*                            undo_manager_       = nullptr;
+		bool                                    sort_enabled_       = true;
+		bool                                    sort_default_name_  = false; // Default sort is by name, not index
+		bool                                    modified_indicator_ = true;
+		ViewType                                view_type_          = ViewType::Tree;
+		ArchivePathPanel*                       path_panel_         = nullptr;
 
 		// wxDataViewModel
 		unsigned int   GetColumnCount() const override { return 4; }
@@ -82,6 +85,10 @@ namespace ui
 			const override;
 
 		bool matchesFilter(const ArchiveEntry& entry) const;
+		bool matchesFilterName(const ArchiveEntry& entry) const;
+		void updateFilterMatches(const vector<string>& prev_filter_name);
+		void updateFilterMatch(const ArchiveEntry& entry);
+		void updateDirFilterMatches(const ArchiveDir& dir, bool removed);
 		void getDirChildItems(wxDataViewItemArray& items, const ArchiveDir& dir, bool filter = true) const;
 		bool entryIsInList(const ArchiveEntry& entry) const;
 		bool dirIsInList(const ArchiveDir& dir) const;
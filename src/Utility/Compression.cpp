@@ -37,11 +37,226 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Compression.h"
+#include "General/Jobs.h"
 #include "thirdparty/zreaders/files.h"
+#include <list>
+#include <mutex>
 
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, decompressed_cache_mb, 128, CVar::Flag::Save)
+
+namespace
+{
+constexpr size_t   CHUNK                = 256 * 1024; // Minimum initial size of decompression buffers
+constexpr unsigned deflate_block_size   = 512 * 1024; // Size of blocks deflated in parallel
+constexpr unsigned deflate_dict_size    = 32 * 1024;  // Each block is primed with this much of the previous block
+constexpr unsigned bzip2_block_size     = 900000;     // Size of blocks compressed in parallel as bzip2 streams
+constexpr unsigned parallel_min_threads = 2;
+
+// Cache of recently decompressed data, to avoid decompressing the same data
+// again (eg. when an archive is closed and reopened). Only the decompressed
+// data is kept, the compressed data is identified by its size and two
+// independent hashes (crc32 and 64-bit)
+struct CacheKey
+{
+	uint32_t size = 0;
+	uint32_t crc  = 0;
+	uint64_t hash = 0;
+
+	bool operator==(const CacheKey& other) const
+	{
+		return size == other.size && crc == other.crc && hash == other.hash;
+	}
+};
+struct CachedData
+{
+	CacheKey key;
+	MemChunk decompressed;
+};
+std::list<CachedData> decompressed_cache; // Most recently used first
+size_t                decompressed_cache_size = 0;
+std::mutex            decompressed_cache_mutex;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the initial output buffer size for decompressing [in]. This is
+// [size_hint] if known, so the data is decompressed straight into a buffer of
+// the right size. Hints beyond the maximum deflate ratio are ignored so a bad
+// size in a corrupt file can't cause a huge allocation. Otherwise it starts at
+// twice the input size and is doubled as needed (see growDecompressBuffer)
+// -----------------------------------------------------------------------------
+uint32_t decompressBufferSize(const MemChunk& in, size_t size_hint)
+{
+	if (size_hint > 0 && size_hint <= in.size() * 1032ull && size_hint < UINT32_MAX)
+		return static_cast<uint32_t>(size_hint);
+
+	return static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(CHUNK, in.size() * 2ull), UINT32_MAX / 2));
+}
+
+// -----------------------------------------------------------------------------
+// Doubles the size of decompression buffer [out] (keeping its contents),
+// returns false if it can't grow any further
+// -----------------------------------------------------------------------------
+bool growDecompressBuffer(MemChunk& out)
+{
+	if (out.size() >= UINT32_MAX / 2)
+		return false;
+
+	return out.reSize(out.size() * 2);
+}
+
+// -----------------------------------------------------------------------------
+// Shrinks decompression buffer [out] to the [size] actually decompressed
+// -----------------------------------------------------------------------------
+void trimDecompressBuffer(MemChunk& out, size_t size)
+{
+	if (size == 0)
+		out.clear();
+	else if (size < out.size())
+		out.reSize(size);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the decompressed data cache item matching [key], or the end of the
+// cache if there isn't one. The cache mutex must be locked
+// -----------------------------------------------------------------------------
+std::list<CachedData>::iterator findCachedData(const CacheKey& key)
+{
+	for (auto i = decompressed_cache.begin(); i != decompressed_cache.end(); ++i)
+		if (i->key == key)
+			return i;
+
+	return decompressed_cache.end();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the decompressed data cache key for compressed data [in]
+// -----------------------------------------------------------------------------
+CacheKey cacheKey(const MemChunk& in)
+{
+	return { in.size(), static_cast<uint32_t>(crc32(0, in.data(), in.size())), in.hash() };
+}
+
+// -----------------------------------------------------------------------------
+// Deflates [in] to [out] as separate blocks on multiple threads, like pigz.
+// Non-final blocks end with a sync flush, which byte-aligns them so they can
+// simply be concatenated into a single standard stream. Each block is primed
+// with the end of the previous one so there is very little loss in compression
+// -----------------------------------------------------------------------------
+bool parallelDeflate(const MemChunk& in, MemChunk& out, int level, int windowbits, const char* function)
+{
+	bool     gzip     = windowbits > MAX_WBITS;
+	bool     zlib     = windowbits >= 0 && windowbits <= MAX_WBITS;
+	unsigned n_blocks = (in.size() + deflate_block_size - 1) / deflate_block_size;
+
+	vector<vector<uint8_t>> blocks(n_blocks);
+	vector<uLong>           checks(n_blocks); // crc32 (gzip) or adler32 (zlib) of each block
+	std::atomic<bool>       ok = true;
+	jobs::parallelFor(
+		n_blocks,
+		[&](unsigned index)
+		{
+			auto start = index * deflate_block_size;
+			auto size  = std::min(deflate_block_size, in.size() - start);
+			auto data  = in.data() + start;
+			bool last  = index == n_blocks - 1;
+
+			if (gzip)
+				checks[index] = crc32(0, data, size);
+			else if (zlib)
+				checks[index] = adler32(1, data, size);
+
+			z_stream strm{};
+			int      ret = deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 9, Z_DEFAULT_STRATEGY);
+			if (ret != Z_OK)
+			{
+				log::error("{} init error {}", function, ret);
+				ok = false;
+				return;
+			}
+			if (index > 0)
+				deflateSetDictionary(&strm, data - deflate_dict_size, deflate_dict_size);
+
+			// Extra space for the sync flush marker, which deflateBound doesn't include
+			auto& block = blocks[index];
+			block.resize(deflateBound(&strm, size) + 64);
+			strm.next_in   = const_cast<Bytef*>(data);
+			strm.avail_in  = size;
+			strm.next_out  = block.data();
+			strm.avail_out = block.size();
+			ret            = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+			if (last ? ret != Z_STREAM_END : (ret != Z_OK || strm.avail_in > 0 || strm.avail_out == 0))
+			{
+				log::error("{} error {}", function, ret);
+				ok = false;
+			}
+			block.resize(strm.total_out);
+			deflateEnd(&strm);
+		});
+	if (!ok)
+		return false;
+
+	// Header
+	vector<uint8_t> data;
+	if (gzip)
+	{
+		// Minimal gzip header (no name, mtime or flags), with an unknown OS
+		uint8_t xfl = level == 9 ? 2 : level == 1 ? 4 : 0;
+		data        = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, xfl, 0xff };
+	}
+	else if (zlib)
+	{
+		// Deflate with a 32k window, and the compression level in the flags
+		uint8_t cmf = 0x78;
+		uint8_t flg = (level < 0 || level == 6) ? 2 : level < 2 ? 0 : level < 6 ? 1 : 3;
+		flg <<= 6;
+		flg += 31 - (cmf * 256 + flg) % 31;
+		data = { cmf, flg };
+	}
+
+	// Blocks
+	for (const auto& block : blocks)
+		data.insert(data.end(), block.begin(), block.end());
+
+	// Trailer
+	uLong check = checks[0];
+	for (unsigned a = 1; a < n_blocks; ++a)
+	{
+		auto size = std::min(deflate_block_size, in.size() - a * deflate_block_size);
+		check     = gzip ? crc32_combine(check, checks[a], size) : adler32_combine(check, checks[a], size);
+	}
+	if (gzip)
+	{
+		for (auto value : { static_cast<uint32_t>(check), in.size() })
+			for (unsigned a = 0; a < 4; ++a)
+				data.push_back((value >> (a * 8)) & 0xFF);
+	}
+	else if (zlib)
+	{
+		for (int a = 3; a >= 0; --a)
+			data.push_back((check >> (a * 8)) & 0xFF);
+	}
+
+	return out.importMem(data.data(), data.size());
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // Compression Namespace Functions
@@ -50,91 +265,92 @@ using namespace slade;
 
 
 // -----------------------------------------------------------------------------
-// Inflates the content of [in] to [out]
+// Inflates the content of [in] to [out]. If [size_hint] is given (the
+// expected inflated size) the output is allocated once at that size
 // -----------------------------------------------------------------------------
-#define CHUNK 4096
-bool compression::genericInflate(MemChunk& in, MemChunk& out, int windowbits, const char* function)
+bool compression::genericInflate(MemChunk& in, MemChunk& out, int windowbits, const char* function, size_t size_hint)
 {
-	in.seek(0, SEEK_SET);
 	out.clear();
-	MemoryReader source(in);
-	FileReaderZ  stream(source, windowbits);
-	uint8_t      buffer[CHUNK];
-	size_t       gotten;
-	do
+
+	z_stream strm{};
+	int      ret = windowbits == 0 ? inflateInit(&strm) : inflateInit2(&strm, windowbits);
+	if (ret != Z_OK)
+	{
+		log::error("{} init error {}", function, ret);
+		return false;
+	}
+
+	// Inflate straight into [out], growing it if needed
+	size_t total = 0;
+	if (!out.reSize(decompressBufferSize(in, size_hint), false))
 	{
-		gotten = stream.Read(buffer, CHUNK);
-		if (gotten > 0)
-			out.write(buffer, gotten);
-	} while (gotten == CHUNK && stream.Status == Z_OK);
-	return (stream.Status == Z_OK || stream.Status == Z_STREAM_END);
+		inflateEnd(&strm);
+		return false;
+	}
+	strm.next_in  = in.data();
+	strm.avail_in = in.size();
+	while (true)
+	{
+		strm.next_out  = out.data() + total;
+		strm.avail_out = out.size() - total;
+		ret            = inflate(&strm, Z_NO_FLUSH);
+		total          = strm.next_out - out.data();
+
+		// Stop at the end of the stream (or an error), or if all input was
+		// used without filling the output (truncated stream)
+		if (ret != Z_OK || strm.avail_out > 0)
+			break;
+		if (!growDecompressBuffer(out))
+		{
+			ret = Z_MEM_ERROR;
+			break;
+		}
+	}
+	inflateEnd(&strm);
+	trimDecompressBuffer(out, total);
+
+	return ret == Z_STREAM_END;
 }
 
 // -----------------------------------------------------------------------------
-// Basically a copy of zpipe.
-// Deflates the content of [in] to [out]
+// Deflates the content of [in] to [out]. Large data is deflated in blocks on
+// multiple threads (see parallelDeflate above)
 // -----------------------------------------------------------------------------
 bool compression::genericDeflate(MemChunk& in, MemChunk& out, int level, int windowbits, const char* function)
 {
-	in.seek(0, SEEK_SET);
 	out.clear();
 
-	int           ret, flush;
-	unsigned      have;
-	z_stream      strm;
-	unsigned char bin[CHUNK];
-	unsigned char bout[CHUNK];
+	if (in.size() > deflate_block_size * 2 && jobs::nThreads() >= parallel_min_threads)
+		return parallelDeflate(in, out, level, windowbits, function);
 
-	/* allocate deflate state */
-	strm.zalloc = nullptr;
-	strm.zfree  = nullptr;
-	strm.opaque = nullptr;
+	z_stream strm{};
+	int      ret;
 	if (windowbits == 0)
 		ret = deflateInit(&strm, level);
 	else
 		ret = deflateInit2(&strm, level, Z_DEFLATED, windowbits, 9, Z_DEFAULT_STRATEGY);
 	if (ret != Z_OK)
 	{
-		log::error("{} init error {}: {}", function, ret, strm.msg);
+		log::error("{} init error {}: {}", function, ret, strm.msg ? strm.msg : "");
 		return false;
 	}
 
-	/* compress until end of file */
-	do
+	// The input is all in memory, so deflate it in one go to a buffer big
+	// enough for the worst case
+	vector<uint8_t> buffer(deflateBound(&strm, in.size()));
+	strm.next_in   = in.data();
+	strm.avail_in  = in.size();
+	strm.next_out  = buffer.data();
+	strm.avail_out = buffer.size();
+	ret            = deflate(&strm, Z_FINISH);
+	deflateEnd(&strm);
+	if (ret != Z_STREAM_END)
 	{
-		// Find out how much stream remains
-		have = in.size() - in.currentPos();
-		// keep it in bite-sized chunks
-		if (have > CHUNK)
-		{
-			have  = CHUNK;
-			flush = Z_NO_FLUSH;
-		}
-		else
-			flush = Z_FINISH;
-		in.read(bin, have);
-
-		strm.avail_in = have;
-		strm.next_in  = bin;
+		log::error("{} error {}", function, ret);
+		return false;
+	}
 
-		/*  run deflate() on input until output buffer not full, finish
-			compression if all of source has been read in */
-		do
-		{
-			strm.avail_out = CHUNK;
-			strm.next_out  = bout;
-			ret            = deflate(&strm, flush); /* no bad return value */
-			assert(ret != Z_STREAM_ERROR);          /* state not clobbered */
-			have = CHUNK - strm.avail_out;
-			out.write(bout, have);
-		} while (strm.avail_out == 0);
-		assert(strm.avail_in == 0); /* all input will be used */
-	} while (flush != Z_FINISH);    /* done when last data in file processed */
-	assert(ret == Z_STREAM_END);    /* stream will be complete */
-
-	/* clean up and return */
-	deflateEnd(&strm);
-	return true;
+	return out.importMem(buffer.data(), strm.total_out);
 }
 
 // -----------------------------------------------------------------------------
@@ -144,7 +360,7 @@ bool compression::genericDeflate(MemChunk& in, MemChunk& out, int level, int win
 // -----------------------------------------------------------------------------
 bool compression::zipInflate(MemChunk& in, MemChunk& out, size_t maxsize)
 {
-	bool ret = compression::genericInflate(in, out, -MAX_WBITS, "ZipInflate");
+	bool ret = compression::genericInflate(in, out, -MAX_WBITS, "ZipInflate", maxsize);
 
 	if (maxsize && out.size() != maxsize)
 		log::warning("Zip stream inflated to {}, expected {}", out.size(), maxsize);
@@ -169,7 +385,12 @@ bool compression::zipDeflate(MemChunk& in, MemChunk& out, int level)
 // -----------------------------------------------------------------------------
 bool compression::gzipInflate(MemChunk& in, MemChunk& out, size_t maxsize)
 {
-	bool ret = compression::genericInflate(in, out, 16 + MAX_WBITS, "GZipInflate");
+	// If the size isn't given, use the one in the gzip footer
+	size_t size_hint = maxsize;
+	if (size_hint == 0 && in.size() >= 18)
+		size_hint = in.readL32(in.size() - 4);
+
+	bool ret = compression::genericInflate(in, out, 16 + MAX_WBITS, "GZipInflate", size_hint);
 
 	if (maxsize && out.size() != maxsize)
 		log::warning("Zip stream inflated to {}, expected {}", out.size(), maxsize);
@@ -195,7 +416,7 @@ bool compression::gzipDeflate(MemChunk& in, MemChunk& out, int level)
 // -----------------------------------------------------------------------------
 bool compression::zlibInflate(MemChunk& in, MemChunk& out, size_t maxsize)
 {
-	bool ret = compression::genericInflate(in, out, 0, "ZlibInflate");
+	bool ret = compression::genericInflate(in, out, 0, "ZlibInflate", maxsize);
 
 	if (maxsize && out.size() != maxsize)
 		log::warning("Zlib stream inflated to {}, expected {}", out.size(), maxsize);
@@ -212,57 +433,112 @@ bool compression::zlibDeflate(MemChunk& in, MemChunk& out, int level)
 }
 
 // -----------------------------------------------------------------------------
-// Decompress the content of [in] as a bzip2 stream to [out]
+// Decompress the content of [in] as a bzip2 stream to [out]. Concatenated
+// streams (as written by bzip2Compress or pbzip2) are decompressed one after
+// the other
 // -----------------------------------------------------------------------------
 bool compression::bzip2Decompress(MemChunk& in, MemChunk& out, size_t maxsize)
 {
-	in.seek(0, SEEK_SET);
 	out.clear();
 
-	MemoryReader  source(in);
-	FileReaderBZ2 stream(source);
-	uint8_t       buffer[4096];
-	size_t        gotten;
-	do
+	bz_stream strm{};
+	int       ret = BZ2_bzDecompressInit(&strm, 0, 0);
+	if (ret != BZ_OK)
 	{
-		gotten = stream.Read(buffer, 4096);
-		if (gotten > 0)
-			out.write(buffer, gotten);
-	} while (gotten == 4096 && stream.Status == BZ_OK);
+		log::error("bzip2 decompress init error {}", ret);
+		return false;
+	}
+
+	// Decompress straight into [out], growing it if needed
+	size_t total = 0;
+	if (!out.reSize(decompressBufferSize(in, maxsize), false))
+	{
+		BZ2_bzDecompressEnd(&strm);
+		return false;
+	}
+	strm.next_in  = reinterpret_cast<char*>(in.data());
+	strm.avail_in = in.size();
+	while (ret == BZ_OK)
+	{
+		if (total == out.size() && !growDecompressBuffer(out))
+		{
+			ret = BZ_MEM_ERROR;
+			break;
+		}
+		strm.next_out  = reinterpret_cast<char*>(out.data() + total);
+		strm.avail_out = out.size() - total;
+		ret            = BZ2_bzDecompress(&strm);
+		total          = reinterpret_cast<uint8_t*>(strm.next_out) - out.data();
+
+		// Ran out of input before the end of the stream
+		if (ret == BZ_OK && strm.avail_out > 0)
+		{
+			ret = BZ_UNEXPECTED_EOF;
+			break;
+		}
+
+		// Continue with the next stream, if there is one
+		if (ret == BZ_STREAM_END && strm.avail_in >= 4 && memcmp(strm.next_in, "BZh", 3) == 0)
+		{
+			auto next_in  = strm.next_in;
+			auto avail_in = strm.avail_in;
+			BZ2_bzDecompressEnd(&strm);
+			strm          = {};
+			strm.next_in  = next_in;
+			strm.avail_in = avail_in;
+			ret           = BZ2_bzDecompressInit(&strm, 0, 0);
+		}
+	}
+	BZ2_bzDecompressEnd(&strm);
+	trimDecompressBuffer(out, total);
 
 	if (maxsize && out.size() != maxsize)
 		log::warning("bzip2 stream inflated to {}, expected {}", out.size(), maxsize);
 
-	return (stream.Status == BZ_OK || stream.Status == BZ_STREAM_END);
+	return ret == BZ_STREAM_END;
 }
 
 // -----------------------------------------------------------------------------
-// Compress the content of [in] as a bzip2 stream to [out]
+// Compress the content of [in] as a bzip2 stream to [out].
+// Large data is split into 900k blocks compressed on multiple threads as
+// separate, concatenated bzip2 streams (like pbzip2). bzip2 compresses each
+// 900k block independently anyway, so this makes next to no difference to the
+// compressed size
 // -----------------------------------------------------------------------------
 bool compression::bzip2Compress(MemChunk& in, MemChunk& out)
 {
 	// Clear out
 	out.clear();
 
-	// Allocate a work buffer big enough to guarantee success
-	unsigned bufferlen = in.size() + (in.size() >> 6) + 1024;
-	char*    buffer    = new char[bufferlen];
-	int      ok        = -1;
-	if (buffer)
-	{
-		ok = BZ2_bzBuffToBuffCompress(
-			buffer,
-			&bufferlen,
-			// How ridiculous is it that casting is needed here?
-			(char*)in.data(),
-			in.size(),
-			9,
-			0,
-			0);
-		out.write(buffer, bufferlen);
-		delete[] buffer;
-	}
-	return (ok == BZ_OK);
+	unsigned n_blocks = std::max(1u, (in.size() + bzip2_block_size - 1) / bzip2_block_size);
+	if (jobs::nThreads() < parallel_min_threads)
+		n_blocks = 1;
+
+	vector<vector<char>> streams(n_blocks);
+	std::atomic<bool>    ok = true;
+	jobs::parallelFor(
+		n_blocks,
+		[&](unsigned index)
+		{
+			auto start = index * bzip2_block_size;
+			auto size  = n_blocks == 1 ? in.size() : std::min(bzip2_block_size, in.size() - start);
+
+			// Allocate a work buffer big enough to guarantee success
+			unsigned bufferlen = size + (size >> 6) + 1024;
+			auto&    stream    = streams[index];
+			stream.resize(bufferlen);
+			auto data = reinterpret_cast<char*>(in.data() + start);
+			if (BZ2_bzBuffToBuffCompress(stream.data(), &bufferlen, data, size, 9, 0, 0) != BZ_OK)
+				ok = false;
+			stream.resize(bufferlen);
+		});
+	if (!ok)
+		return false;
+
+	for (const auto& stream : streams)
+		out.write(stream.data(), stream.size());
+
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -285,3 +561,53 @@ bool compression::lzmaDecompress(MemChunk& in, MemChunk& out, size_t size)
 	delete[] cache;
 	return false;
 }
+
+// -----------------------------------------------------------------------------
+// Gets the previously decompressed data for compressed data [in] from the
+// cache into [out]. Returns false if it isn't cached
+// -----------------------------------------------------------------------------
+bool compression::getCachedDecompressed(const MemChunk& in, MemChunk& out)
+{
+	if (decompressed_cache_mb <= 0 || !in.hasData())
+		return false;
+
+	auto key = cacheKey(in);
+
+	std::lock_guard lock(decompressed_cache_mutex);
+	auto            cached = findCachedData(key);
+	if (cached == decompressed_cache.end())
+		return false;
+
+	out.importMem(cached->decompressed);
+	decompressed_cache.splice(decompressed_cache.begin(), decompressed_cache, cached);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [out], the decompressed data of [in], to the decompressed data cache.
+// The least recently used data is removed if the cache is over its size limit
+// (decompressed_cache_mb)
+// -----------------------------------------------------------------------------
+void compression::cacheDecompressed(const MemChunk& in, const MemChunk& out)
+{
+	size_t limit = std::max(0, static_cast<int>(decompressed_cache_mb)) * 1024ull * 1024ull;
+	if (!in.hasData() || !out.hasData() || out.size() > limit)
+		return;
+
+	auto key = cacheKey(in);
+
+	std::lock_guard lock(decompressed_cache_mutex);
+	if (findCachedData(key) != decompressed_cache.end())
+		return;
+
+	auto& cached = decompressed_cache.emplace_front();
+	cached.key   = key;
+	cached.decompressed.importMem(out);
+	decompressed_cache_size += out.size();
+
+	while (decompressed_cache_size > limit)
+	{
+		decompressed_cache_size -= decompressed_cache.back().decompressed.size();
+		decompressed_cache.pop_back();
+	}
+}
@@ -2,7 +2,7 @@
 
 namespace slade::compression
 {
-bool genericInflate(MemChunk& in, MemChunk& out, int windowbits, const char* function);
+bool genericInflate(MemChunk& in, MemChunk& out, int windowbits, const char* function, size_t size_hint = 0);
 bool genericDeflate(MemChunk& in, MemChunk& out, int level, int windowbits, const char* function);
 bool gzipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool gzipDeflate(MemChunk& in, MemChunk& out, int level = -1);
@@ -15,4 +15,8 @@ bool zipUnshrink(MemChunk& in, MemChunk& out, size_t maxsize);
 bool bzip2Decompress(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool bzip2Compress(MemChunk& in, MemChunk& out);
 bool lzmaDecompress(MemChunk& in, MemChunk& out, size_t size);
+
+// Decompressed data cache
+bool getCachedDecompressed(const MemChunk& in, MemChunk& out);
+void cacheDecompressed(const MemChunk& in, const MemChunk& out);
 } // namespace slade::compression
@@ -0,0 +1,289 @@
+
+// -----------------------------------------------------------------------------
+// TSoSLADaE - It's a Fork of a Doom Editor!
+// Copyright(C) 2008 - 2023 Simon Judd
+// Copyright(C) 2022 - 2023 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+//
+// TSoSLADaE Email:			  none
+// TSoSLADaE Web:			  https://github.com/StarManiaKG/The-Story-of-Slicing-Language-Arrangements-Dramatically-and-Efficiently
+//
+// Filename:    DirWatcher.cpp
+// Description: DirWatcher class, keeps track of changes to files within a
+//              directory tree using OS file change notifications, so that
+//              changes can be found without rescanning the whole tree
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "DirWatcher.h"
+#include "StringUtils.h"
+#include <cstring>
+#include <filesystem>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace slade;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+#ifdef __linux__
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM
+								| IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// DirWatcher Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// DirWatcher class constructor
+// -----------------------------------------------------------------------------
+DirWatcher::DirWatcher(string_view path, bool ignore_hidden) : path_{ path }, ignore_hidden_{ ignore_hidden }
+{
+	while (path_.size() > 1 && (path_.back() == '/' || path_.back() == '\\'))
+		path_.pop_back();
+
+#ifdef __linux__
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0)
+	{
+		log::warning("Unable to initialise inotify for {}: {}", path_, strerror(errno));
+		return;
+	}
+
+	addWatches(path_);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// DirWatcher class destructor
+// -----------------------------------------------------------------------------
+DirWatcher::~DirWatcher()
+{
+#ifdef __linux__
+	if (fd_ >= 0)
+		close(fd_);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Adds all paths (files or directories) that have changed since the last call
+// to [paths].
+// Returns false if the changes couldn't be tracked (eg. the OS event queue
+// overflowed, or watching isn't supported), in which case the whole directory
+// tree needs to be rescanned
+// -----------------------------------------------------------------------------
+bool DirWatcher::takeChangedPaths(vector<string>& paths)
+{
+	if (!isValid())
+		return false;
+
+	readEvents();
+
+	// Rebuild all watches if they could be out of date
+	if (rescan_needed_)
+	{
+		log::info(2, "Change tracking for {} lost, rescan needed", path_);
+		changed_.clear();
+		removeWatches();
+		rescan_needed_ = false;
+		addWatches(path_);
+		return false;
+	}
+
+	paths.insert(paths.end(), changed_.begin(), changed_.end());
+	changed_.clear();
+
+	return isValid();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if directory watching is supported on this platform
+// -----------------------------------------------------------------------------
+bool DirWatcher::isSupported()
+{
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Adds watches for [dir] and all its subdirectories.
+// If a watch can't be added (usually due to hitting the system's max watches
+// limit), all watches are removed and the watcher becomes invalid
+// -----------------------------------------------------------------------------
+bool DirWatcher::addWatches(const string& dir)
+{
+#ifdef __linux__
+	namespace fs = std::filesystem;
+
+	auto add_watch = [this](const string& path)
+	{
+		auto wd = inotify_add_watch(fd_, path.c_str(), WATCH_MASK);
+		if (wd < 0)
+		{
+			log::warning("Unable to watch directory {} for changes: {}", path, strerror(errno));
+			return false;
+		}
+
+		watches_[wd] = path;
+		return true;
+	};
+
+	bool            ok = add_watch(dir);
+	std::error_code ec;
+	for (auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied, ec);
+		 ok && !ec && it != fs::recursive_directory_iterator();
+		 it.increment(ec))
+	{
+		if (!it->is_directory(ec) || it->is_symlink(ec))
+			continue;
+
+		if (ignore_hidden_ && strutil::startsWith(it->path().filename().string(), '.'))
+		{
+			it.disable_recursion_pending();
+			continue;
+		}
+
+		ok = add_watch(it->path().string());
+	}
+
+	if (!ok)
+	{
+		removeWatches();
+		close(fd_);
+		fd_ = -1;
+	}
+
+	return ok;
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Removes all current watches
+// -----------------------------------------------------------------------------
+void DirWatcher::removeWatches()
+{
+#ifdef __linux__
+	for (const auto& watch : watches_)
+		inotify_rm_watch(fd_, watch.first);
+#endif
+
+	watches_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Reads all pending events from the OS and adds the paths they refer to to the
+// changed paths list
+// -----------------------------------------------------------------------------
+void DirWatcher::readEvents()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[16384];
+	while (isValid())
+	{
+		auto len = read(fd_, buffer, sizeof(buffer));
+		if (len <= 0)
+			break; // No more events (EAGAIN)
+
+		for (auto ptr = buffer; ptr < buffer + len;)
+		{
+			auto event = reinterpret_cast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+
+			// Events were dropped, can't trust the changed list anymore
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				rescan_needed_ = true;
+				continue;
+			}
+
+			// Watch removed (directory deleted)
+			if (event->mask & IN_IGNORED)
+			{
+				watches_.erase(event->wd);
+				continue;
+			}
+
+			auto watch = watches_.find(event->wd);
+			if (watch == watches_.end())
+				continue;
+
+			// The watched directory itself was moved or deleted. For the root
+			// directory or a move, paths of existing watches are now invalid
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+			{
+				if (watch->second == path_ || event->mask & IN_MOVE_SELF)
+					rescan_needed_ = true;
+				continue;
+			}
+
+			// Changes to the root directory itself (eg. its attributes) aren't
+			// a change within the tree
+			string name = event->len > 0 ? event->name : "";
+			if (name.empty() && watch->second == path_)
+				continue;
+			if (ignore_hidden_ && strutil::startsWith(name, '.'))
+				continue;
+
+			auto path = name.empty() ? watch->second : fmt::format("{}/{}", watch->second, name);
+
+			if (event->mask & IN_ISDIR)
+			{
+				// Watch new subdirectories
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					if (!addWatches(path))
+						return;
+				}
+
+				// Watches for subdirectories of a renamed directory have the
+				// wrong path now
+				else if (event->mask & IN_MOVED_FROM)
+					rescan_needed_ = true;
+			}
+
+			changed_.insert(path);
+		}
+	}
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <unordered_set>
+
+namespace slade
+{
+// Watches a directory tree for changes via the OS file change notification API
+// (currently inotify, so Linux only). Events are queued by the OS and collected
+// when takeChangedPaths is called, so no polling or traversal is needed to find
+// out what changed
+class DirWatcher
+{
+public:
+	DirWatcher(string_view path, bool ignore_hidden = true);
+	~DirWatcher();
+
+	const string& path() const { return path_; }
+	bool          isValid() const { return fd_ >= 0; }
+
+	bool takeChangedPaths(vector<string>& paths);
+
+	static bool isSupported();
+
+private:
+	string                          path_;
+	bool                            ignore_hidden_ = true;
+	int                             fd_            = -1;
+	bool                            rescan_needed_ = false;
+	std::unordered_map<int, string> watches_; // Watch descriptor -> directory path
+	std::unordered_set<string>      changed_;
+
+	bool addWatches(const string& dir);
+	void removeWatches();
+	void readEvents();
+};
+} // namespace slade
@@ -117,7 +117,7 @@ bool fileutil::validExecutable(string_view path)
 // -----------------------------------------------------------------------------
 bool fileutil::removeFile(string_view path)
 {
-	static std::error_code ec;
+	std::error_code ec;
 	if (!fs::remove(path, ec))
 	{
 		log::warning("Unable to remove file \"{}\": {}", path, ec.message());
@@ -133,8 +133,8 @@ bool fileutil::removeFile(string_view path)
 // -----------------------------------------------------------------------------
 bool fileutil::copyFile(string_view from, string_view to, bool overwrite)
 {
-	static std::error_code ec;
-	auto                   options = overwrite ? fs::copy_options::overwrite_existing : fs::copy_options::none;
+	std::error_code ec;
+	auto            options = overwrite ? fs::copy_options::overwrite_existing : fs::copy_options::none;
 	if (!fs::copy_file(from, to, options, ec))
 	{
 		log::warning("Unable to copy file from \"{}\" to \"{}\": {}", from, to, ec.message());
@@ -144,6 +144,31 @@ bool fileutil::copyFile(string_view from, string_view to, bool overwrite)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Creates a new, empty file named [filename] in the temp directory (or
+// [filename].<n> if that already exists) and returns its path, or an empty
+// string if it couldn't be created. The file is created exclusively, so
+// concurrent callers (from any thread or process) never get the same file
+// -----------------------------------------------------------------------------
+string fileutil::createTempFile(string_view filename)
+{
+	wxLogNull no_log; // Failing because the file exists is expected
+	for (unsigned n = 0; n < 10000; ++n)
+	{
+		auto   path = app::path(n == 0 ? string{ filename } : fmt::format("{}.{}", filename, n), app::Dir::Temp);
+		wxFile file;
+		if (file.Create(path, false))
+			return path;
+
+		// Give up if it failed for any reason other than the file existing
+		if (!fileExists(path))
+			break;
+	}
+
+	log::warning("Unable to create temp file for \"{}\"", filename);
+	return {};
+}
+
 // -----------------------------------------------------------------------------
 // Reads all text from the file at [path] into [str]
 // -----------------------------------------------------------------------------
@@ -190,7 +215,7 @@ bool fileutil::writeStringToFile(const string& str, const string& path)
 // -----------------------------------------------------------------------------
 bool fileutil::createDir(string_view path)
 {
-	static std::error_code ec;
+	std::error_code ec;
 	if (!fs::create_directory(path, ec))
 	{
 		if (ec.value() != 0)
@@ -208,7 +233,7 @@ bool fileutil::createDir(string_view path)
 // -----------------------------------------------------------------------------
 bool fileutil::removeDir(string_view path)
 {
-	static std::error_code ec;
+	std::error_code ec;
 	if (!fs::remove_all(path, ec))
 	{
 		log::warning("Unable to remove directory \"{}\": {}", path, ec.message());
@@ -11,6 +11,7 @@ namespace fileutil
 	bool           validExecutable(string_view path);
 	bool           removeFile(string_view path);
 	bool           copyFile(string_view from, string_view to, bool overwrite = true);
+	string         createTempFile(string_view filename);
 	bool           readFileToString(const string& path, string& str);
 	bool           writeStringToFile(const string& str, const string& path);
 	bool           createDir(string_view path);
@@ -132,7 +132,7 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	}
 	else if (data_ != nullptr)
 	{
-		memcpy(ndata, data_, size_ * sizeof(uint8_t));
+		memcpy(ndata, data_, std::min(size_, new_size) * sizeof(uint8_t));
 		delete[] data_;
 		data_ = ndata;
 	}
@@ -556,6 +556,14 @@ uint32_t MemChunk::crc() const
 	return hasData() ? misc::crc(data_, size_) : 0;
 }
 
+// -----------------------------------------------------------------------------
+// Returns a 64-bit hash of the data
+// -----------------------------------------------------------------------------
+uint64_t MemChunk::hash() const
+{
+	return misc::hash64(data_, size_);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the data as a string
 // -----------------------------------------------------------------------------
@@ -60,6 +60,7 @@ public:
 	// Misc
 	bool     fillData(uint8_t val) const;
 	uint32_t crc() const;
+	uint64_t hash() const;
 	string   asString(uint32_t offset = 0, uint32_t length = 0) const;
 
 	// Platform-independent functions to read values in little (L##) or big (B##) endian
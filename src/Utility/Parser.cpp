@@ -45,6 +45,55 @@
 using namespace slade;
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const char     BINARY_MAGIC[4] = { 'S', 'P', 'T', 'B' };
+const uint32_t BINARY_VERSION  = 1;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Binary parse tree read/write helpers.
+// Values are written in native byte order, since the binary form is only used
+// as a local cache
+// -----------------------------------------------------------------------------
+template<typename T> void writeValue(MemChunk& out, T value)
+{
+	out.write(&value, sizeof(T));
+}
+void writeString(MemChunk& out, const string& str)
+{
+	writeValue(out, static_cast<uint32_t>(str.size()));
+	out.write(str.data(), str.size());
+}
+template<typename T> bool readValue(MemChunk& in, T& value)
+{
+	return in.read(&value, sizeof(T));
+}
+bool readString(MemChunk& in, string& str)
+{
+	uint32_t len;
+	if (!readValue(in, len) || len > in.size() - in.currentPos())
+		return false;
+
+	str.resize(len);
+	return in.read(str.data(), len);
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // ParseTreeNode Class Functions
@@ -537,6 +586,124 @@ void ParseTreeNode::write(string& out, int indent) const
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Writes this node and its children to [out] in binary form, which can be read
+// back with readBinary without needing to tokenize or preprocess anything
+// -----------------------------------------------------------------------------
+void ParseTreeNode::writeBinary(MemChunk& out) const
+{
+	using Type = property::ValueType;
+
+	writeString(out, name_);
+	writeString(out, type_);
+	writeString(out, inherit_);
+
+	// Values
+	writeValue(out, static_cast<uint32_t>(values_.size()));
+	for (const auto& value : values_)
+	{
+		writeValue(out, static_cast<uint8_t>(value.index()));
+		switch (property::valueType(value))
+		{
+		case Type::Bool: writeValue<uint8_t>(out, std::get<bool>(value) ? 1 : 0); break;
+		case Type::Int: writeValue(out, std::get<int>(value)); break;
+		case Type::UInt: writeValue(out, std::get<unsigned>(value)); break;
+		case Type::Float: writeValue(out, std::get<double>(value)); break;
+		default: writeString(out, std::get<string>(value)); break;
+		}
+	}
+
+	// Children
+	writeValue(out, static_cast<uint32_t>(children_.size()));
+	for (auto* node : children_)
+		dynamic_cast<ParseTreeNode*>(node)->writeBinary(out);
+}
+
+// -----------------------------------------------------------------------------
+// Reads this node's values and children from binary data written by
+// writeBinary in [in]. Returns false if the data was invalid or incomplete
+// -----------------------------------------------------------------------------
+bool ParseTreeNode::readBinary(MemChunk& in)
+{
+	using Type = property::ValueType;
+
+	string name;
+	if (!readString(in, name) || !readString(in, type_) || !readString(in, inherit_))
+		return false;
+	name_ = name;
+
+	// Values
+	uint32_t n_values;
+	if (!readValue(in, n_values))
+		return false;
+	values_.clear();
+	values_.reserve(std::min<uint32_t>(n_values, in.size() - in.currentPos()));
+	for (uint32_t a = 0; a < n_values; a++)
+	{
+		uint8_t type;
+		if (!readValue(in, type))
+			return false;
+
+		switch (static_cast<Type>(type))
+		{
+		case Type::Bool:
+		{
+			uint8_t val;
+			if (!readValue(in, val))
+				return false;
+			values_.emplace_back(val != 0);
+			break;
+		}
+		case Type::Int:
+		{
+			int val;
+			if (!readValue(in, val))
+				return false;
+			values_.emplace_back(val);
+			break;
+		}
+		case Type::UInt:
+		{
+			unsigned val;
+			if (!readValue(in, val))
+				return false;
+			values_.emplace_back(val);
+			break;
+		}
+		case Type::Float:
+		{
+			double val;
+			if (!readValue(in, val))
+				return false;
+			values_.emplace_back(val);
+			break;
+		}
+		case Type::String:
+		{
+			string val;
+			if (!readString(in, val))
+				return false;
+			values_.emplace_back(std::move(val));
+			break;
+		}
+		default: return false;
+		}
+	}
+
+	// Children
+	uint32_t n_children;
+	if (!readValue(in, n_children))
+		return false;
+	for (uint32_t a = 0; a < n_children; a++)
+	{
+		auto child = new ParseTreeNode(this, parser_, archive_dir_);
+		if (!child->readBinary(in))
+			return false;
+	}
+
+	return true;
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -619,6 +786,41 @@ bool Parser::parseText(string_view text, string_view source) const
 	return pt_root_->parse(tz);
 }
 
+// -----------------------------------------------------------------------------
+// Writes the current parse tree to [out] in binary form
+// -----------------------------------------------------------------------------
+void Parser::writeBinary(MemChunk& out) const
+{
+	out.write(BINARY_MAGIC, 4);
+	writeValue(out, BINARY_VERSION);
+	pt_root_->writeBinary(out);
+}
+
+// -----------------------------------------------------------------------------
+// Reads a parse tree previously written with writeBinary from [in], replacing
+// the current parse tree. Returns false if [in] isn't a valid binary parse tree
+// -----------------------------------------------------------------------------
+bool Parser::readBinary(MemChunk& in)
+{
+	char     magic[4];
+	uint32_t version;
+	in.seekFromStart(0);
+	if (!in.read(magic, 4) || memcmp(magic, BINARY_MAGIC, 4) != 0)
+		return false;
+	if (!readValue(in, version) || version != BINARY_VERSION)
+		return false;
+
+	pt_root_ = std::make_unique<ParseTreeNode>(nullptr, this, archive_dir_root_);
+	if (!pt_root_->readBinary(in))
+	{
+		log::error("Invalid or incomplete binary parse tree data");
+		pt_root_ = std::make_unique<ParseTreeNode>(nullptr, this, archive_dir_root_);
+		return false;
+	}
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Adds [def] to the #defines list
 // -----------------------------------------------------------------------------
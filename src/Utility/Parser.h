@@ -51,6 +51,8 @@ public:
 
 	bool parse(Tokenizer& tz);
 	void write(string& out, int indent = 0) const;
+	void writeBinary(MemChunk& out) const;
+	bool readBinary(MemChunk& in);
 
 protected:
 	STreeNode* createChild(string_view name) override
@@ -89,6 +91,10 @@ public:
 	void define(string_view def);
 	bool defined(string_view def) const;
 
+	// Binary (pre-parsed) form of the parse tree, for caching
+	void writeBinary(MemChunk& out) const;
+	bool readBinary(MemChunk& in);
+
 	// To simplify casts from STreeNode to ParseTreeNode
 	static ParseTreeNode* node(STreeNode* node) { return dynamic_cast<ParseTreeNode*>(node); }
 